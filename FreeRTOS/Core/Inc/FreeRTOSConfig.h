@@ -56,7 +56,7 @@
 #define CMSIS_device_header "stm32f4xx.h"
 #endif /* CMSIS_device_header */
 
-#define configENABLE_FPU                         0
+#define configENABLE_FPU                         1
 #define configENABLE_MPU                         0
 
 #define configUSE_PREEMPTION                     1
@@ -165,6 +165,11 @@ standard names. */
 
 /* USER CODE BEGIN Defines */
 /* Section where parameter definitions can be added (for instance, to override default ones in FreeRTOS.h) */
+#if defined(__ICCARM__) || defined(__CC_ARM) || defined(__GNUC__)
+  extern void msg_pool_heap_trace(void *ptr, uint32_t size);
+#endif
+/* Any heap allocation after msg_pool_lock_heap() trips an assert */
+#define traceMALLOC( pvAddress, uiSize )  msg_pool_heap_trace( ( pvAddress ), ( uint32_t ) ( uiSize ) )
 /* USER CODE END Defines */
 
 #endif /* FREERTOS_CONFIG_H */
@@ -23,6 +23,22 @@
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
 #include "app_tasks.h"
+#include "msg_pool.h"
+#include "cycle_counter.h"
+#include "job_worker.h"
+#include "cli_registry.h"
+#include "telemetry.h"
+#include "adc_acq.h"
+#include "calib.h"
+#include "bus.h"
+#include "sensor_drdy.h"
+#include "siggen.h"
+#include "sensor_pipeline.h"
+#include "flash_log.h"
+#include "kv_store.h"
+#include "boot_metadata.h"
+#include "crc32.h"
+#include "flash_ctrl.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -43,13 +59,6 @@
 /* Private variables ---------------------------------------------------------*/
 UART_HandleTypeDef huart2;
 
-/* Definitions for HeartbeatTask */
-osThreadId_t HeartbeatTaskHandle;
-const osThreadAttr_t HeartbeatTask_attributes = {
-  .name = "HeartbeatTask",
-  .stack_size = 256 * 4,
-  .priority = (osPriority_t) osPriorityLow,
-};
 /* Definitions for CLITask */
 osThreadId_t CLITaskHandle;
 const osThreadAttr_t CLITask_attributes = {
@@ -84,14 +93,52 @@ const osMessageQueueAttr_t cliRxQueue_attributes = {
   .name = "cliRxQueue"
 };
 /* USER CODE BEGIN PV */
-
+/* Definitions for JobWorkerTask */
+osThreadId_t JobWorkerTaskHandle;
+const osThreadAttr_t JobWorkerTask_attributes = {
+  .name = "JobWorkerTask",
+  .stack_size = 256 * 4,
+  .priority = (osPriority_t) osPriorityLow,
+};
+/* Definitions for TelemetryTask */
+osThreadId_t TelemetryTaskHandle;
+const osThreadAttr_t TelemetryTask_attributes = {
+  .name = "TelemetryTask",
+  .stack_size = 192 * 4,
+  .priority = (osPriority_t) osPriorityBelowNormal,
+};
+/* Definitions for AdcTask */
+osThreadId_t AdcTaskHandle;
+const osThreadAttr_t AdcTask_attributes = {
+  .name = "AdcTask",
+  .stack_size = 128 * 4,
+  .priority = (osPriority_t) osPriorityAboveNormal1,
+};
+/* Definitions for the sensor pipeline stages, below SensorTask so acquire never waits */
+osThreadId_t PipeFilterTaskHandle;
+const osThreadAttr_t PipeFilterTask_attributes = {
+  .name = "PipeFilter",
+  .stack_size = 128 * 4,
+  .priority = (osPriority_t) osPriorityBelowNormal1,
+};
+osThreadId_t PipeAggregateTaskHandle;
+const osThreadAttr_t PipeAggregateTask_attributes = {
+  .name = "PipeAggregate",
+  .stack_size = 128 * 4,
+  .priority = (osPriority_t) osPriorityBelowNormal1,
+};
+osThreadId_t PipePublishTaskHandle;
+const osThreadAttr_t PipePublishTask_attributes = {
+  .name = "PipePublish",
+  .stack_size = 128 * 4,
+  .priority = (osPriority_t) osPriorityBelowNormal,
+};
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
 void SystemClock_Config(void);
 static void MX_GPIO_Init(void);
 static void MX_USART2_UART_Init(void);
-void HeartbeatTaskFunc(void *argument);
 void CLITaskFunc(void *argument);
 void SensorTaskFunc(void *argument);
 void LoggerTaskFunc(void *argument);
@@ -139,6 +186,7 @@ int main(void)
   /* USER CODE BEGIN 2 */
   HAL_UART_Receive_IT(&huart2, &rx_byte, 1);
   uart_logger_init(&huart2);
+  cycle_counter_init();
 
   /* USER CODE END 2 */
 
@@ -147,8 +195,26 @@ int main(void)
 
   /* USER CODE BEGIN RTOS_MUTEX */
   /* add mutexes, ... */
-  CreateMutex();
+  msg_pool_init();
   CreateQueue();
+  job_worker_init();
+  cli_registry_init();
+  telemetry_init();
+  calib_init();
+  adc_acq_init();
+  bus_init();
+  sensor_drdy_init();
+  siggen_init();
+  sensor_pipeline_init();
+  flash_ctrl_init();
+  boot_metadata_init();
+  crc32_init();
+  flash_log_init();
+  kv_init();
+  sensor_sched_load_settings();
+  flash_log_load_settings();
+  crc32_load_settings();
+  calib_load_settings();
   /* USER CODE END RTOS_MUTEX */
 
   /* USER CODE BEGIN RTOS_SEMAPHORES */
@@ -157,6 +223,7 @@ int main(void)
 
   /* USER CODE BEGIN RTOS_TIMERS */
   /* start timers, add new ones, ... */
+  CreatePeriodicJobs();
   /* USER CODE END RTOS_TIMERS */
 
   /* Create the queue(s) */
@@ -168,9 +235,6 @@ int main(void)
   /* USER CODE END RTOS_QUEUES */
 
   /* Create the thread(s) */
-  /* creation of HeartbeatTask */
-  HeartbeatTaskHandle = osThreadNew(HeartbeatTaskFunc, NULL, &HeartbeatTask_attributes);
-
   /* creation of CLITask */
   CLITaskHandle = osThreadNew(CLITaskFunc, NULL, &CLITask_attributes);
 
@@ -185,10 +249,25 @@ int main(void)
 
   /* USER CODE BEGIN RTOS_THREADS */
   /* add threads, ... */
+  /* creation of JobWorkerTask */
+  JobWorkerTaskHandle = osThreadNew(JobWorkerTaskFunc, NULL, &JobWorkerTask_attributes);
+
+  /* creation of TelemetryTask */
+  TelemetryTaskHandle = osThreadNew(TelemetryTaskFunc, NULL, &TelemetryTask_attributes);
+
+  /* creation of AdcTask */
+  AdcTaskHandle = osThreadNew(AdcTaskFunc, NULL, &AdcTask_attributes);
+
+  /* creation of the sensor pipeline stages */
+  PipeFilterTaskHandle = osThreadNew(PipeStageTaskFunc, (void *)PIPE_STAGE_FILTER, &PipeFilterTask_attributes);
+  PipeAggregateTaskHandle = osThreadNew(PipeStageTaskFunc, (void *)PIPE_STAGE_AGGREGATE, &PipeAggregateTask_attributes);
+  PipePublishTaskHandle = osThreadNew(PipeStageTaskFunc, (void *)PIPE_STAGE_PUBLISH, &PipePublishTask_attributes);
   /* USER CODE END RTOS_THREADS */
 
   /* USER CODE BEGIN RTOS_EVENTS */
   /* add events, ... */
+  /* Every kernel object exists now; runtime traffic must use the pools */
+  msg_pool_lock_heap();
   /* USER CODE END RTOS_EVENTS */
 
   /* Start scheduler */
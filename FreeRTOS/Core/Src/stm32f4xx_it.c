@@ -22,6 +22,10 @@
 #include "stm32f4xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "adc_acq.h"
+#include "bus.h"
+#include "sensor_drdy.h"
+#include "siggen.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -192,4 +196,68 @@ void TIM6_DAC_IRQHandler(void)
 
 /* USER CODE BEGIN 1 */
 
+/**
+  * @brief This function handles DMA2 stream0 global interrupt (ADC1 scan buffer).
+  */
+void DMA2_Stream0_IRQHandler(void)
+{
+  adc_acq_dma_irq();
+}
+
+/**
+  * @brief This function handles EXTI line[15:10] interrupts (sensor data-ready).
+  */
+void EXTI15_10_IRQHandler(void)
+{
+  sensor_drdy_irq();
+}
+
+/**
+  * @brief This function handles TIM7 global interrupt (signal generator sample clock).
+  */
+void TIM7_IRQHandler(void)
+{
+  siggen_tim_irq();
+}
+
+/**
+  * @brief This function handles I2C1 event interrupt.
+  */
+void I2C1_EV_IRQHandler(void)
+{
+  bus_i2c1_ev_irq();
+}
+
+/**
+  * @brief This function handles I2C1 error interrupt.
+  */
+void I2C1_ER_IRQHandler(void)
+{
+  bus_i2c1_er_irq();
+}
+
+/**
+  * @brief This function handles DMA1 stream6 global interrupt (I2C1 TX).
+  */
+void DMA1_Stream6_IRQHandler(void)
+{
+  bus_i2c1_dma_tx_irq();
+}
+
+/**
+  * @brief This function handles DMA1 stream0 global interrupt (I2C1 RX).
+  */
+void DMA1_Stream0_IRQHandler(void)
+{
+  bus_i2c1_dma_rx_irq();
+}
+
+/**
+  * @brief This function handles DMA2 stream2 global interrupt (SPI1 RX).
+  */
+void DMA2_Stream2_IRQHandler(void)
+{
+  bus_spi1_dma_rx_irq();
+}
+
 /* USER CODE END 1 */
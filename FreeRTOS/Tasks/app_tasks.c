@@ -1,39 +1,35 @@
 #include "cmsis_os2.h"
 #include "app_tasks.h"
+#include "task.h"
 
 #include "uart_logger.h"
 #include "main.h"
 #include "ota.h"
 #include "cli_handler.h"
+#include "msg_pool.h"
+#include "periodic_jobs.h"
+#include "cycle_counter.h"
+#include "sensor_sched.h"
+#include "quantile.h"
 #include <stdbool.h>
+#include <string.h>
 
 #define QUEUE_SIZE		10
+#define OTA_STREAM_CHUNKS	2
+#define OTA_RX_IDLE_TIMEOUT_MS	5000
 
 extern UART_HandleTypeDef huart2;
 
 char command_buff[64];
 int i = 0;
 
-SensorMessage_t g_sensor_data = {0};
-
-//Mutex creating and init
-
-const osMutexAttr_t sensor_data_mutex_attr = {
-    .name = "SensorDataMutex"
-};
-
-osMutexId_t sensor_data_mutex = NULL;
-
-void CreateMutex(){
-	sensor_data_mutex = osMutexNew(&sensor_data_mutex_attr);
-	if (sensor_data_mutex == NULL) {
-	    log_printf("Failed to create SensorDataMutex\r\n");
-	}
-
-}
-
 osMessageQueueId_t loggerQueue;
-osMessageQueueId_t otaQueue;
+
+// Each message costs its length plus a size_t length header; static buffers lose one byte
+static uint8_t ota_stream_storage[OTA_STREAM_CHUNKS * (OTA_CHUNK_SIZE + sizeof(size_t)) + 1];
+static StaticMessageBuffer_t ota_stream_cb;
+MessageBufferHandle_t otaStream;
+OTAHandoffStats_t ota_handoff_stats = {0};
 
 // OTA state management
 volatile OTAState_t ota_state = OTA_STATE_IDLE;
@@ -42,42 +38,99 @@ volatile uint32_t ota_received_size = 0;
 
 /* creation of DataQueue */
 void CreateQueue(void) {
-  //Logger Queue Creation
-	loggerQueue = osMessageQueueNew (QUEUE_SIZE, 100, NULL);
+  //Logger Queue Creation - carries pointers to pool blocks, not the text itself
+	loggerQueue = osMessageQueueNew (QUEUE_SIZE, sizeof(char *), NULL);
     if (loggerQueue == NULL) {
     	log_printf("Logger Queue creation failed\r\n");
     }
     
-    //OTA Queue Creation
-    otaQueue = osMessageQueueNew(5, sizeof(OTAMessage_t), NULL);
-    if (otaQueue == NULL) {
-    	log_printf("OTA Queue creation failed\r\n");
+    //OTA data stream creation - chunk boundaries are preserved for word-aligned flash writes
+    otaStream = xMessageBufferCreateStatic(sizeof(ota_stream_storage), ota_stream_storage, &ota_stream_cb);
+    if (otaStream == NULL) {
+    	log_printf("OTA stream creation failed\r\n");
     }
 }
 
-void HeartbeatTaskFunc(void *argument)
+#define HEARTBEAT_PERIOD_MS		500
+#define STACK_CHECK_PERIOD_MS	1000
+#define STACK_LOW_WATER_BYTES	64
+
+static void HeartbeatJob(void *argument)
 {
-  /* USER CODE BEGIN 5 */
-  /* Infinite loop */
-	log_printf("[HeartBeat] task alive\r\n");
-  for(;;)
-  {
-	  HAL_GPIO_TogglePin(GPIOA, GPIO_PIN_5);
-	  osDelay(500);
-  }
-  osDelay(1000);
+	HAL_GPIO_TogglePin(GPIOA, GPIO_PIN_5);
+}
+
+#define STACK_WARN_LEN			64
+#define STACK_CHECK_MAX_TASKS	20		// Every task, idle and timer service included
+
+// Warns once per task when its stack headroom drops below the low-water mark.
+// Every task is checked, so new ones need no registration. osThreadEnumerate()
+// allocates from the heap, which is locked by now, so the task list goes into
+// a static array through uxTaskGetSystemState() instead. This runs on the
+// timer service task, which must not block on the UART, so the line goes to
+// LoggerTask through the queue without waiting; if the pool or the queue is
+// full it is tried again on the next run.
+static void StackCheckJob(void *argument)
+{
+	static TaskStatus_t tasks[STACK_CHECK_MAX_TASKS];
+	static TaskHandle_t warned[STACK_CHECK_MAX_TASKS];
+	static uint32_t warned_count = 0;
+
+	// Returns 0 if the array is too small; raise STACK_CHECK_MAX_TASKS then
+	UBaseType_t count = uxTaskGetSystemState(tasks, STACK_CHECK_MAX_TASKS, NULL);
+
+	for (UBaseType_t t = 0; t < count; t++) {
+		uint32_t space = tasks[t].usStackHighWaterMark * sizeof(StackType_t);
+		if (space >= STACK_LOW_WATER_BYTES) {
+			continue;
+		}
+
+		bool seen = false;
+		for (uint32_t w = 0; w < warned_count && !seen; w++) {
+			seen = (warned[w] == tasks[t].xHandle);
+		}
+		if (seen || warned_count == STACK_CHECK_MAX_TASKS) {
+			continue;
+		}
+
+		char *msg = msg_pool_alloc(STACK_WARN_LEN, 0);
+		if (msg == NULL) {
+			continue;
+		}
+		snprintf(msg, STACK_WARN_LEN, "[Jobs] %s stack low: %lu bytes left", tasks[t].pcTaskName, space);
+		if (osMessageQueuePut(loggerQueue, &msg, 0, 0) == osOK) {
+			warned[warned_count++] = tasks[t].xHandle;
+		} else {
+			msg_pool_free(msg);
+		}
+	}
+}
+
+/* creation of periodic jobs, all hosted by the timer service task */
+void CreatePeriodicJobs(void) {
+	periodic_job_add("Heartbeat", HeartbeatJob, NULL, HEARTBEAT_PERIOD_MS);
+	periodic_job_add("StackCheck", StackCheckJob, NULL, STACK_CHECK_PERIOD_MS);
 }
 
 
 void CLITaskFunc(void *argument) {
 	uint8_t bytes;
-	uint8_t ota_buffer[256];
+	static uint8_t ota_buffer[OTA_CHUNK_SIZE];
 	uint32_t ota_buffer_index = 0;
 	
 	log_printf("[CLI] Task started\r\n");
 
 	for(;;){
-		if (osMessageQueueGet(cliRxQueueHandle, &bytes, NULL, osWaitForever) == osOK){
+		// While receiving firmware, a silent link means the host gave up
+		uint32_t timeout = (ota_state == OTA_STATE_RECEIVING) ? OTA_RX_IDLE_TIMEOUT_MS : osWaitForever;
+		osStatus_t rx_status = osMessageQueueGet(cliRxQueueHandle, &bytes, NULL, timeout);
+		if (rx_status == osErrorTimeout && ota_state == OTA_STATE_RECEIVING && ota_received_size + ota_buffer_index > 0) {
+			log_printf("[CLI] OTA data stalled, aborting transfer\r\n");
+			ota_buffer_index = 0;
+			osThreadFlagsSet(OTATaskHandle, OTA_FLAG_ABORT);
+			continue;
+		}
+		if (rx_status == osOK){
 			
 			// Check if we're in OTA data receiving mode
 			if (ota_state == OTA_STATE_RECEIVING) {
@@ -92,20 +145,19 @@ void CLITaskFunc(void *argument) {
 				ota_buffer[ota_buffer_index++] = bytes;
 				
 				// When buffer is full or we've received all expected data
-				if (ota_buffer_index >= 256 || ota_received_size + ota_buffer_index >= ota_expected_size) {
-					// Send data to OTA task
-					OTAMessage_t otaMsg = {0};
-					otaMsg.command = OTA_CMD_DATA;
-					otaMsg.offset = ota_received_size;
-					otaMsg.length = ota_buffer_index;
-					
-					// Copy data to message
-					for (uint32_t j = 0; j < ota_buffer_index; j++) {
-						otaMsg.data[j] = ota_buffer[j];
-					}
-					
-					
-					if (osMessageQueuePut(otaQueue, &otaMsg, 0, 100) == osOK) {
+				if (ota_buffer_index >= OTA_CHUNK_SIZE || ota_received_size + ota_buffer_index >= ota_expected_size) {
+					// Send data to OTA task; the chunk is copied once into the stream
+					uint32_t start = cycle_counter_now();
+					size_t sent = xMessageBufferSend(otaStream, ota_buffer, ota_buffer_index, pdMS_TO_TICKS(100));
+					if (sent == ota_buffer_index) {
+						osThreadFlagsSet(OTATaskHandle, OTA_FLAG_DATA);
+						uint32_t cycles = cycle_counter_now() - start;
+						ota_handoff_stats.chunks++;
+						ota_handoff_stats.total_cycles += cycles;
+						if (cycles > ota_handoff_stats.max_cycles) {
+							ota_handoff_stats.max_cycles = cycles;
+						}
+						quantile_record(QMETRIC_OTA_HANDOFF, (float)cycles_to_us(cycles));
 						ota_received_size += ota_buffer_index;
 						
 						// Check if transfer is complete
@@ -114,9 +166,7 @@ void CLITaskFunc(void *argument) {
 							ota_state = OTA_STATE_COMPLETE;
 							
 							// Send finish command
-							OTAMessage_t finishMsg = {0};
-							finishMsg.command = OTA_CMD_FINISH;
-							osMessageQueuePut(otaQueue, &finishMsg, 0, 100);
+							osThreadFlagsSet(OTATaskHandle, OTA_FLAG_FINISH);
 						}
 					} else {
 						log_printf("[CLI] Failed to send OTA data chunk\r\n");
@@ -144,118 +194,144 @@ void CLITaskFunc(void *argument) {
 }
 
 void SensorTaskFunc(void *argument) {
-
   for (;;) {
+	  TickType_t next_due = sensor_sched_poll(xTaskGetTickCount());
 
-	  float temp = 25;
-	  float press = 10;
+	  // Sleep until the earliest deadline, a data-ready edge or a rate change;
+	  // deadlines are absolute, so waking early for a flag costs no drift
+	  TickType_t now = xTaskGetTickCount();
+	  uint32_t timeout = ((int32_t)(next_due - now) > 0) ? next_due - now : 0;
+	  uint32_t flags = osThreadFlagsWait(SENSOR_FLAG_ALL, osFlagsWaitAny, timeout);
 
-	  if(osMutexAcquire(sensor_data_mutex, osWaitForever) == osOK){
-		  g_sensor_data.temperature = temp;
-		  g_sensor_data.pressure = press;
-		  g_sensor_data.timestamp_ms = HAL_GetTick();
-		  osMutexRelease(sensor_data_mutex);
+	  if (flags & osFlagsError) {
+		  continue;
+	  }
+	  if (flags & SENSOR_FLAG_DRDY) {
+		  sensor_sched_service_drdy();
+	  }
+	  if (flags & SENSOR_FLAG_SIGGEN) {
+		  sensor_sched_service_siggen();
+	  }
+	  if (flags & SENSOR_FLAG_BUS) {
+		  sensor_sched_service_bus();
 	  }
-
   }
-  osDelay(5000);
 }
 
 void LoggerTaskFunc(void *argument) {
 
     for (;;) {
-    	char msg[100];
+    	char *msg;
     	if(osMessageQueueGet(loggerQueue, &msg, 0, osWaitForever) == osOK){
     		log_printf("%s \r\n",msg);
+    		msg_pool_free(msg);
     	}
     }
     osDelay(2000);
 }
 
+// Drops any chunks still queued for flash, e.g. after an abort
+static void ota_drain_stream(uint8_t *chunk)
+{
+  while (xMessageBufferReceive(otaStream, chunk, OTA_CHUNK_SIZE, 0) > 0) {
+  }
+}
+
 void OTATaskFunc(void *argument) {
-  OTAMessage_t otaMsg;
+  static uint8_t chunk[OTA_CHUNK_SIZE];
   uint32_t totalBytesReceived = 0;
   
   log_printf("[OTA] Task started, waiting for commands...\r\n");
   
-  // Verify queue is valid
-  if (otaQueue == NULL) {
-    log_printf("[OTA] ERROR: Queue handle is NULL!\r\n");
+  // Verify stream is valid
+  if (otaStream == NULL) {
+    log_printf("[OTA] ERROR: Stream handle is NULL!\r\n");
     for(;;) {
       osDelay(1000);
-      log_printf("[OTA] ERROR: Stuck - Queue is NULL\r\n");
+      log_printf("[OTA] ERROR: Stuck - Stream is NULL\r\n");
     }
   }
   
-  log_printf("[OTA] Queue handle: %p\r\n", (void*)otaQueue);
-  
   for (;;) {
-    osStatus_t status = osMessageQueueGet(otaQueue, &otaMsg, NULL, osWaitForever);
+    uint32_t flags = osThreadFlagsWait(OTA_FLAG_ALL, osFlagsWaitAny, osWaitForever);
+    if (flags & osFlagsError) {
+      continue;
+    }
+    
+    log_printf("[OTA] Received events: 0x%02lX\r\n", flags);
     
-    if (status == osOK) {
-      log_printf("[OTA] Received message, command: %d\r\n", otaMsg.command);
+    if (flags & OTA_FLAG_ABORT) {
+      ota_drain_stream(chunk);
+      log_printf("[OTA] Transfer aborted after %lu bytes\r\n", totalBytesReceived);
+      ota_state = OTA_STATE_IDLE;
+      ota_received_size = 0;
+      totalBytesReceived = 0;
+      continue;
+    }
+    
+    if (flags & OTA_FLAG_START) {
+      log_printf("[OTA] Starting firmware update to Slot B...\r\n");
+      ota_drain_stream(chunk);
+      ota_erase_slot();
+      ota_state = OTA_STATE_RECEIVING;
+      ota_received_size = 0;
+      totalBytesReceived = 0;
+      ota_handoff_stats = (OTAHandoffStats_t){0};
+      log_printf("[OTA] Ready to receive firmware data\r\n");
       
-      switch(otaMsg.command) {
-        case OTA_CMD_START:
-          log_printf("[OTA] Starting firmware update to Slot B...\r\n");
-          ota_erase_slot();
-          ota_state = OTA_STATE_RECEIVING;
-          ota_received_size = 0;
-          totalBytesReceived = 0;
-          log_printf("[OTA] Ready to receive firmware data\r\n");
+      // Yield after erase operation to allow other tasks to run
+      osThreadYield();
+      log_printf("[OTA] START command completed, back to waiting\r\n");
+    }
+    
+    if (flags & OTA_FLAG_DATA) {
+      size_t length;
+      while ((length = xMessageBufferReceive(otaStream, chunk, sizeof(chunk), 0)) > 0) {
+        if (ota_state == OTA_STATE_IDLE) {
+          log_printf("[OTA] Data received but OTA not in RECEIVING state\r\n");
+          continue;
+        }
+        
+        uint32_t offset = totalBytesReceived;
+        uint32_t write_start = cycle_counter_now();
+        HAL_StatusTypeDef hal_status = ota_write_firmware(offset, chunk, length);
+        quantile_record(QMETRIC_OTA_WRITE, (float)cycles_to_us(cycle_counter_now() - write_start));
+        if (hal_status == HAL_OK) {
+          totalBytesReceived += length;
+          log_printf("[OTA] Written %u bytes at offset 0x%08lX (Total: %lu bytes)\r\n", 
+                    (unsigned int)length, offset, totalBytesReceived);
           
-          // Yield after erase operation to allow other tasks to run
+          // Yield after flash write to allow other tasks to run
           osThreadYield();
-          log_printf("[OTA] START command completed, back to waiting\r\n");
-          break;
-          
-        case OTA_CMD_DATA:
-          if (ota_state == OTA_STATE_RECEIVING) {
-            HAL_StatusTypeDef hal_status = ota_write_firmware(otaMsg.offset, otaMsg.data, otaMsg.length);
-            if (hal_status == HAL_OK) {
-              totalBytesReceived += otaMsg.length;
-              log_printf("[OTA] Written %lu bytes at offset 0x%08lX (Total: %lu bytes)\r\n", 
-                        otaMsg.length, otaMsg.offset, totalBytesReceived);
-              
-              // Yield after flash write to allow other tasks to run
-              osThreadYield();
-            } else {
-              log_printf("[OTA] Write failed at offset 0x%08lX, status: %d\r\n", otaMsg.offset, hal_status);
-              ota_state = OTA_STATE_IDLE;
-            }
-          } else {
-            log_printf("[OTA] Data received but OTA not in RECEIVING state\r\n");
-          }
-          break;
-          
-        case OTA_CMD_FINISH:
-          if (ota_state == OTA_STATE_RECEIVING || ota_state == OTA_STATE_COMPLETE) {
-            log_printf("[OTA] Firmware update completed. Total bytes: %lu\r\n", totalBytesReceived);
-            
-            // Complete OTA process and switch boot slot
-            HAL_StatusTypeDef switch_status = ota_complete_and_switch(totalBytesReceived);
-            if (switch_status == HAL_OK) {
-              log_printf("[OTA] Boot slot switched successfully\r\n");
-              log_printf("[OTA] System will boot from new firmware after reset\r\n");
-              
-              // Optional: Trigger system reset to boot new firmware
-              log_printf("[OTA] Triggering system reset in 3 seconds...\r\n");
-              osDelay(3000);
-              NVIC_SystemReset();
-            } else {
-              log_printf("[OTA] Failed to switch boot slot: %d\r\n", switch_status);
-              log_printf("[OTA] OTA completed but system will boot from old firmware\r\n");
-            }
-            
-            ota_state = OTA_STATE_IDLE;
-          } else {
-            log_printf("[OTA] Finish command received but OTA was not in progress\r\n");
-          }
-          break;
+        } else {
+          log_printf("[OTA] Write failed at offset 0x%08lX, status: %d\r\n", offset, hal_status);
+          ota_state = OTA_STATE_IDLE;
+        }
+      }
+    }
+    
+    if (flags & OTA_FLAG_FINISH) {
+      if (ota_state == OTA_STATE_RECEIVING || ota_state == OTA_STATE_COMPLETE) {
+        log_printf("[OTA] Firmware update completed. Total bytes: %lu\r\n", totalBytesReceived);
+        
+        // Complete OTA process and switch boot slot
+        HAL_StatusTypeDef switch_status = ota_complete_and_switch(totalBytesReceived);
+        if (switch_status == HAL_OK) {
+          log_printf("[OTA] Boot slot switched successfully\r\n");
+          log_printf("[OTA] System will boot from new firmware after reset\r\n");
           
-        default:
-          log_printf("[OTA] Unknown command received: %d\r\n", otaMsg.command);
-          break;
+          // Optional: Trigger system reset to boot new firmware
+          log_printf("[OTA] Triggering system reset in 3 seconds...\r\n");
+          osDelay(3000);
+          NVIC_SystemReset();
+        } else {
+          log_printf("[OTA] Failed to switch boot slot: %d\r\n", switch_status);
+          log_printf("[OTA] OTA completed but system will boot from old firmware\r\n");
+        }
+        
+        ota_state = OTA_STATE_IDLE;
+      } else {
+        log_printf("[OTA] Finish command received but OTA was not in progress\r\n");
       }
     }
   }
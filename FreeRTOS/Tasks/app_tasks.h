@@ -2,25 +2,31 @@
 #define __APP_TASKS_H
 
 #include "cmsis_os2.h"
+#include "FreeRTOS.h"
+#include "message_buffer.h"
 
 typedef struct{
 	float temperature;
 	float pressure;
 	uint32_t timestamp_ms;
+	uint16_t timestamp_us;	// 0..999 us past timestamp_ms
 }SensorMessage_t;
 
-typedef enum {
-	OTA_CMD_START,
-	OTA_CMD_DATA,
-	OTA_CMD_FINISH
-} OTACommand_t;
+// OTA control events are thread flags on OTATask; data chunks go through otaStream
+#define OTA_FLAG_START		0x01U
+#define OTA_FLAG_DATA		0x02U
+#define OTA_FLAG_FINISH		0x04U
+#define OTA_FLAG_ABORT		0x08U
+#define OTA_FLAG_ALL		(OTA_FLAG_START | OTA_FLAG_DATA | OTA_FLAG_FINISH | OTA_FLAG_ABORT)
 
-typedef struct {
-	OTACommand_t command;
-	uint32_t offset;
-	uint32_t length;
-	uint8_t data[256];  // Increased buffer size for larger chunks
-} OTAMessage_t;
+// SensorTask wake-ups other than its own deadlines
+#define SENSOR_FLAG_DRDY		0x01U	// A data-ready edge was latched
+#define SENSOR_FLAG_RESCHEDULE	0x02U	// A sensor's period or mode changed
+#define SENSOR_FLAG_SIGGEN		0x04U	// Generated samples are waiting
+#define SENSOR_FLAG_BUS		0x08U	// A bus-read sensor's transfer finished
+#define SENSOR_FLAG_ALL		(SENSOR_FLAG_DRDY | SENSOR_FLAG_RESCHEDULE | SENSOR_FLAG_SIGGEN | SENSOR_FLAG_BUS)
+
+#define OTA_CHUNK_SIZE		256
 
 // OTA state management
 typedef enum {
@@ -33,22 +39,30 @@ extern volatile OTAState_t ota_state;
 extern volatile uint32_t ota_expected_size;
 extern volatile uint32_t ota_received_size;
 
-extern SensorMessage_t g_sensor_data;
+// Cost of handing one chunk from CLITask to OTATask, in CPU cycles
+typedef struct {
+	uint32_t chunks;
+	uint32_t total_cycles;
+	uint32_t max_cycles;
+} OTAHandoffStats_t;
+
+extern OTAHandoffStats_t ota_handoff_stats;
 
 void CLITaskFunc(void *argument);
 void LoggerTaskFunc(void *argument);
 void SensorTaskFunc(void *argument);
 void OTATaskFunc(void *argument);
-void HeartbeatTaskFunc(void *argument);
 
-void QueueCreate(void);
+void CreateQueue(void);
+void CreatePeriodicJobs(void);
 
 extern osMessageQueueId_t loggerQueue;
 extern osMessageQueueId_t cliRxQueueHandle;
-extern osMessageQueueId_t otaQueue;
+extern MessageBufferHandle_t otaStream;
 
-// Mutex for thread-safe access
-extern osMutexId_t sensor_data_mutex;
-extern const osMutexAttr_t sensor_data_mutex_attr;
+extern osThreadId_t CLITaskHandle;
+extern osThreadId_t SensorTaskHandle;
+extern osThreadId_t OTATaskHandle;
+extern osThreadId_t LoggerTaskHandle;
 
 #endif /* __APP_TASKS_H */
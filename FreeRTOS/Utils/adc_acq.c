@@ -0,0 +1,337 @@
+/*
+ * adc_acq.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+#include "adc_acq.h"
+#include "main.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "calib.h"
+#include "cli_registry.h"
+#include "uart_logger.h"
+#include <string.h>
+
+// The HAL ADC driver is not part of this project, so ADC1, DMA2 Stream0 and
+// TIM2 are driven directly through their registers.
+#define ADC_DMA_STREAM           DMA2_Stream0    // ADC1 is request channel 0 on stream 0
+#define ADC_DMA_IRQ_PRIORITY     6               // Below configMAX_SYSCALL, may use FromISR APIs
+#define ADC_EXTSEL_TIM2_TRGO     (0x6U << ADC_CR2_EXTSEL_Pos)
+#define ADC_BUFFER_SAMPLES       (2 * ADC_ACQ_SCANS_PER_HALF * ADC_CH_COUNT)
+
+// Factory VREFINT reading, taken with VDDA at 3.3 V
+#define VREFINT_CAL_ADDR         ((const uint16_t *)0x1FFF7A2AU)
+
+static uint16_t adc_buffer[ADC_BUFFER_SAMPLES];
+
+static AdcStats_t adc_stats = { .backend = ADC_BACKEND_HW, .rate_hz = ADC_ACQ_DEFAULT_RATE_HZ };
+static volatile uint32_t halves_produced = 0;
+static AdcSinkFunc_t adc_sink = NULL;
+
+// Default simulated feed: slow triangle on PA0, ramp on PA1, ~25 C and ~3.3 V rails
+#define SIM_DEFAULT_SCANS        64
+static uint16_t sim_default[SIM_DEFAULT_SCANS][ADC_CH_COUNT];
+static const uint16_t *sim_table = &sim_default[0][0];
+static uint32_t sim_scans = SIM_DEFAULT_SCANS;
+static uint32_t sim_pos = 0;
+static uint32_t sim_half = 0;
+
+static StaticTimer_t sim_timer_cb;
+static osTimerId_t sim_timer;
+
+static void adc_half_ready(uint32_t half)
+{
+	halves_produced++;
+	if (AdcTaskHandle != NULL) {
+		osThreadFlagsSet(AdcTaskHandle, half ? ADC_FLAG_FULL : ADC_FLAG_HALF);
+	}
+}
+
+void adc_acq_dma_irq(void)
+{
+	uint32_t isr = DMA2->LISR;
+
+	if (isr & DMA_LISR_TEIF0) {
+		DMA2->LIFCR = DMA_LIFCR_CTEIF0;
+	}
+	if (isr & DMA_LISR_HTIF0) {
+		DMA2->LIFCR = DMA_LIFCR_CHTIF0;
+		adc_half_ready(0);
+	}
+	if (isr & DMA_LISR_TCIF0) {
+		DMA2->LIFCR = DMA_LIFCR_CTCIF0;
+		adc_half_ready(1);
+	}
+}
+
+static void sim_timer_callback(void *argument)
+{
+	uint16_t *dst = &adc_buffer[sim_half * ADC_ACQ_SCANS_PER_HALF * ADC_CH_COUNT];
+
+	for (uint32_t s = 0; s < ADC_ACQ_SCANS_PER_HALF; s++) {
+		memcpy(&dst[s * ADC_CH_COUNT], &sim_table[sim_pos * ADC_CH_COUNT], ADC_CH_COUNT * sizeof(uint16_t));
+		sim_pos = (sim_pos + 1 == sim_scans) ? 0 : sim_pos + 1;
+	}
+	adc_half_ready(sim_half);
+	sim_half ^= 1;
+}
+
+void adc_acq_init(void)
+{
+	for (uint32_t s = 0; s < SIM_DEFAULT_SCANS; s++) {
+		uint32_t tri = (s < SIM_DEFAULT_SCANS / 2) ? s : SIM_DEFAULT_SCANS - s;
+		sim_default[s][ADC_CH_PA0] = (uint16_t)(1024 + tri * 64);
+		sim_default[s][ADC_CH_PA1] = (uint16_t)(s * 64);
+		sim_default[s][ADC_CH_TEMP] = 943;        // 0.76 V at VDDA 3.3 V
+		sim_default[s][ADC_CH_VREFINT] = 1489;    // 1.2 V at VDDA 3.3 V
+	}
+
+	osTimerAttr_t attr = {
+		.name = "AdcSim",
+		.cb_mem = &sim_timer_cb,
+		.cb_size = sizeof(sim_timer_cb)
+	};
+	sim_timer = osTimerNew(sim_timer_callback, osTimerPeriodic, NULL, &attr);
+	if (sim_timer == NULL) {
+		log_printf("ADC sim timer creation failed\r\n");
+	}
+
+	HAL_NVIC_SetPriority(DMA2_Stream0_IRQn, ADC_DMA_IRQ_PRIORITY, 0);
+	HAL_NVIC_EnableIRQ(DMA2_Stream0_IRQn);
+}
+
+static uint32_t tim2_clock_hz(void)
+{
+	// APB1 timers run at twice PCLK1 whenever the APB1 prescaler is not 1
+	uint32_t pclk1 = HAL_RCC_GetPCLK1Freq();
+	return ((RCC->CFGR & RCC_CFGR_PPRE1) == RCC_CFGR_PPRE1_DIV1) ? pclk1 : 2 * pclk1;
+}
+
+static void adc_hw_start(uint32_t rate_hz)
+{
+	RCC->AHB1ENR |= RCC_AHB1ENR_GPIOAEN | RCC_AHB1ENR_DMA2EN;
+	RCC->APB2ENR |= RCC_APB2ENR_ADC1EN;
+	RCC->APB1ENR |= RCC_APB1ENR_TIM2EN;
+	__DSB();
+
+	// PA0/PA1 analog
+	GPIOA->MODER |= (3U << GPIO_MODER_MODER0_Pos) | (3U << GPIO_MODER_MODER1_Pos);
+
+	// ADCCLK = PCLK2 / 4, temperature sensor and VREFINT on
+	ADC123_COMMON->CCR = (ADC123_COMMON->CCR & ~ADC_CCR_ADCPRE) | ADC_CCR_ADCPRE_0 | ADC_CCR_TSVREFE;
+
+	ADC1->CR2 = 0;
+	ADC1->CR1 = ADC_CR1_SCAN;
+	// 84 cycles on the external inputs, 480 on IN17/IN18 (sensor needs >= 10 us)
+	ADC1->SMPR2 = (4U << ADC_SMPR2_SMP0_Pos) | (4U << ADC_SMPR2_SMP1_Pos);
+	ADC1->SMPR1 = (7U << ADC_SMPR1_SMP17_Pos) | (7U << ADC_SMPR1_SMP18_Pos);
+	ADC1->SQR1 = (ADC_CH_COUNT - 1) << ADC_SQR1_L_Pos;
+	ADC1->SQR3 = (0U << ADC_SQR3_SQ1_Pos) | (1U << ADC_SQR3_SQ2_Pos) |
+	             (18U << ADC_SQR3_SQ3_Pos) | (17U << ADC_SQR3_SQ4_Pos);
+
+	// DMA: peripheral to memory, 16-bit, circular, half and full interrupts
+	ADC_DMA_STREAM->CR = 0;
+	while (ADC_DMA_STREAM->CR & DMA_SxCR_EN) {
+	}
+	DMA2->LIFCR = DMA_LIFCR_CTCIF0 | DMA_LIFCR_CHTIF0 | DMA_LIFCR_CTEIF0 | DMA_LIFCR_CDMEIF0 | DMA_LIFCR_CFEIF0;
+	ADC_DMA_STREAM->PAR = (uint32_t)&ADC1->DR;
+	ADC_DMA_STREAM->M0AR = (uint32_t)adc_buffer;
+	ADC_DMA_STREAM->NDTR = ADC_BUFFER_SAMPLES;
+	ADC_DMA_STREAM->FCR = 0;     // Direct mode
+	ADC_DMA_STREAM->CR = DMA_SxCR_PL_1 | DMA_SxCR_MSIZE_0 | DMA_SxCR_PSIZE_0 | DMA_SxCR_MINC |
+	                     DMA_SxCR_CIRC | DMA_SxCR_HTIE | DMA_SxCR_TCIE | DMA_SxCR_TEIE;
+	ADC_DMA_STREAM->CR |= DMA_SxCR_EN;
+
+	// One scan per TIM2 update; DDS keeps DMA requests going in circular mode
+	ADC1->CR2 = ADC_CR2_ADON | ADC_CR2_DMA | ADC_CR2_DDS | ADC_CR2_EXTEN_0 | ADC_EXTSEL_TIM2_TRGO;
+
+	TIM2->CR1 = 0;
+	TIM2->PSC = tim2_clock_hz() / 1000000U - 1;   // 1 MHz count
+	TIM2->ARR = 1000000U / rate_hz - 1;
+	TIM2->CR2 = TIM_CR2_MMS_1;                   // TRGO on update
+	TIM2->EGR = TIM_EGR_UG;
+	TIM2->CR1 = TIM_CR1_CEN;
+}
+
+static void adc_hw_stop(void)
+{
+	TIM2->CR1 = 0;
+	ADC1->CR2 = 0;
+	ADC_DMA_STREAM->CR &= ~DMA_SxCR_EN;
+	while (ADC_DMA_STREAM->CR & DMA_SxCR_EN) {
+	}
+	DMA2->LIFCR = DMA_LIFCR_CTCIF0 | DMA_LIFCR_CHTIF0 | DMA_LIFCR_CTEIF0 | DMA_LIFCR_CDMEIF0 | DMA_LIFCR_CFEIF0;
+}
+
+bool adc_acq_start(AdcBackend_t backend, uint32_t rate_hz)
+{
+	if (backend >= ADC_BACKEND_COUNT || rate_hz < ADC_ACQ_MIN_RATE_HZ || rate_hz > ADC_ACQ_MAX_RATE_HZ) {
+		return false;
+	}
+
+	adc_acq_stop();
+	adc_stats.backend = backend;
+	adc_stats.rate_hz = rate_hz;
+
+	if (backend == ADC_BACKEND_HW) {
+		adc_hw_start(rate_hz);
+	} else {
+		// One half per timer period; sub-tick rates round up to 1 ms
+		uint32_t period_ms = (ADC_ACQ_SCANS_PER_HALF * 1000U) / rate_hz;
+		sim_half = 0;
+		if (osTimerStart(sim_timer, (period_ms > 0) ? period_ms : 1) != osOK) {
+			return false;
+		}
+	}
+	adc_stats.running = true;
+	return true;
+}
+
+void adc_acq_stop(void)
+{
+	if (!adc_stats.running) {
+		return;
+	}
+	if (adc_stats.backend == ADC_BACKEND_HW) {
+		adc_hw_stop();
+	} else {
+		osTimerStop(sim_timer);
+	}
+	adc_stats.running = false;
+}
+
+void adc_acq_set_sink(AdcSinkFunc_t sink)
+{
+	adc_sink = sink;
+}
+
+void adc_acq_sim_load(const uint16_t *samples, uint32_t scans)
+{
+	if (samples == NULL || scans == 0) {
+		samples = &sim_default[0][0];
+		scans = SIM_DEFAULT_SCANS;
+	}
+
+	taskENTER_CRITICAL();
+	sim_table = samples;
+	sim_scans = scans;
+	sim_pos = 0;
+	taskEXIT_CRITICAL();
+}
+
+void adc_acq_get_stats(AdcStats_t *stats)
+{
+	taskENTER_CRITICAL();
+	*stats = adc_stats;
+	taskEXIT_CRITICAL();
+}
+
+static void adc_process_half(const uint16_t *samples)
+{
+	uint32_t sum[ADC_CH_COUNT] = {0};
+
+	for (uint32_t s = 0; s < ADC_ACQ_SCANS_PER_HALF; s++) {
+		for (uint32_t ch = 0; ch < ADC_CH_COUNT; ch++) {
+			sum[ch] += samples[s * ADC_CH_COUNT + ch];
+		}
+	}
+
+	taskENTER_CRITICAL();
+	for (uint32_t ch = 0; ch < ADC_CH_COUNT; ch++) {
+		adc_stats.mean[ch] = (uint16_t)(sum[ch] / ADC_ACQ_SCANS_PER_HALF);
+	}
+	adc_stats.halves++;
+	taskEXIT_CRITICAL();
+
+	if (adc_sink != NULL) {
+		adc_sink(samples, ADC_ACQ_SCANS_PER_HALF);
+	}
+}
+
+void AdcTaskFunc(void *argument)
+{
+	uint32_t halves_seen = 0;
+
+	adc_acq_start(ADC_BACKEND_HW, ADC_ACQ_DEFAULT_RATE_HZ);
+
+	for (;;) {
+		uint32_t flags = osThreadFlagsWait(ADC_FLAG_ALL, osFlagsWaitAny, osWaitForever);
+		if (flags & osFlagsError) {
+			continue;
+		}
+
+		// More halves than flags handled means the DMA lapped us
+		uint32_t produced = halves_produced;
+		uint32_t pending = ((flags & ADC_FLAG_HALF) ? 1 : 0) + ((flags & ADC_FLAG_FULL) ? 1 : 0);
+		if (produced - halves_seen > pending) {
+			adc_stats.overruns += produced - halves_seen - pending;
+		}
+		halves_seen = produced;
+
+		if (flags & ADC_FLAG_HALF) {
+			adc_process_half(&adc_buffer[0]);
+		}
+		if (flags & ADC_FLAG_FULL) {
+			adc_process_half(&adc_buffer[ADC_ACQ_SCANS_PER_HALF * ADC_CH_COUNT]);
+		}
+	}
+}
+
+// Rescales a count to what it would read with VDDA at 3.3 V, in integer math
+static uint32_t adc_vdda_compensate(uint16_t raw, uint16_t vrefint_raw)
+{
+	if (vrefint_raw == 0) {
+		return raw;
+	}
+	return ((uint32_t)raw * *VREFINT_CAL_ADDR + vrefint_raw / 2) / vrefint_raw;
+}
+
+bool adc_acq_temperature_c(float *celsius)
+{
+	if (adc_stats.halves == 0) {
+		return false;
+	}
+	uint32_t raw = adc_vdda_compensate(adc_stats.mean[ADC_CH_TEMP], adc_stats.mean[ADC_CH_VREFINT]);
+	*celsius = calib_convert(ADC_CH_TEMP, raw);
+	return true;
+}
+
+bool adc_acq_input_percent(AdcChannel_t channel, float *percent)
+{
+	if (adc_stats.halves == 0 || channel > ADC_CH_PA1) {
+		return false;
+	}
+	*percent = calib_convert(channel, adc_stats.mean[channel]);
+	return true;
+}
+
+static const char *const backend_names[ADC_BACKEND_COUNT] = { "hw", "sim" };
+
+// adc | adc start <rate_hz> [hw|sim] | adc stop
+CLI_COMMAND(adc, "|sus", "[start <rate_hz> [hw|sim] | stop]", "ADC acquisition status and control")
+{
+	if (args->count > 0 && strcmp(args->v[0].s, "stop") == 0) {
+		adc_acq_stop();
+	} else if (args->count > 1 && strcmp(args->v[0].s, "start") == 0) {
+		AdcBackend_t backend = ADC_BACKEND_HW;
+		if (args->count > 2 && strcmp(args->v[2].s, "sim") == 0) {
+			backend = ADC_BACKEND_SIM;
+		}
+		if (!adc_acq_start(backend, args->v[1].u)) {
+			log_printf("Rate must be %u..%u Hz\r\n", ADC_ACQ_MIN_RATE_HZ, ADC_ACQ_MAX_RATE_HZ);
+			return;
+		}
+	} else if (args->count > 0) {
+		log_printf("Usage: adc [start <rate_hz> [hw|sim] | stop]\r\n");
+		return;
+	}
+
+	AdcStats_t stats;
+	adc_acq_get_stats(&stats);
+	log_printf("ADC %s (%s) at %lu Hz, halves %lu, overruns %lu\r\n",
+	           stats.running ? "running" : "stopped", backend_names[stats.backend],
+	           stats.rate_hz, stats.halves, stats.overruns);
+	log_printf("Mean raw: PA0 %u, PA1 %u, TEMP %u, VREFINT %u\r\n", stats.mean[ADC_CH_PA0],
+	           stats.mean[ADC_CH_PA1], stats.mean[ADC_CH_TEMP], stats.mean[ADC_CH_VREFINT]);
+}
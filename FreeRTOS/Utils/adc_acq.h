@@ -0,0 +1,72 @@
+/*
+ * adc_acq.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+
+#ifndef ADC_ACQ_H_
+#define ADC_ACQ_H_
+
+#include "cmsis_os2.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Scan order within one conversion sequence
+typedef enum {
+	ADC_CH_PA0 = 0,              // ADC1_IN0, external input (pressure transducer)
+	ADC_CH_PA1,                  // ADC1_IN1, external input
+	ADC_CH_TEMP,                 // ADC1_IN18, internal temperature sensor
+	ADC_CH_VREFINT,              // ADC1_IN17, internal reference for VDDA
+	ADC_CH_COUNT
+} AdcChannel_t;
+
+#define ADC_ACQ_SCANS_PER_HALF   16      // Scans per ping-pong half
+#define ADC_ACQ_MIN_RATE_HZ      1
+#define ADC_ACQ_MAX_RATE_HZ      2000    // Long sample times on IN17/IN18 cap the scan rate
+#define ADC_ACQ_DEFAULT_RATE_HZ  1000
+
+#define ADC_FLAG_HALF            0x01U   // First half of the DMA buffer is ready
+#define ADC_FLAG_FULL            0x02U   // Second half is ready
+#define ADC_FLAG_ALL             (ADC_FLAG_HALF | ADC_FLAG_FULL)
+
+// Where samples come from. Both backends fill the same ping-pong buffer and
+// raise the same flags, so processing cannot tell them apart.
+typedef enum {
+	ADC_BACKEND_HW = 0,          // TIM2-triggered ADC1 scan, DMA2 Stream0 circular
+	ADC_BACKEND_SIM,             // Timer service replays a waveform table
+	ADC_BACKEND_COUNT
+} AdcBackend_t;
+
+// Called by AdcTask with each completed half: 'scans' rows of ADC_CH_COUNT samples
+typedef void (*AdcSinkFunc_t)(const uint16_t *samples, uint32_t scans);
+
+typedef struct {
+	bool running;
+	AdcBackend_t backend;
+	uint32_t rate_hz;
+	uint32_t halves;             // Halves processed
+	uint32_t overruns;           // Halves overwritten before AdcTask got to them
+	uint16_t mean[ADC_CH_COUNT]; // Per-channel mean of the latest half
+} AdcStats_t;
+
+extern osThreadId_t AdcTaskHandle;
+
+void adc_acq_init(void);
+void AdcTaskFunc(void *argument);
+void adc_acq_dma_irq(void);
+
+bool adc_acq_start(AdcBackend_t backend, uint32_t rate_hz);
+void adc_acq_stop(void);
+void adc_acq_set_sink(AdcSinkFunc_t sink);
+void adc_acq_get_stats(AdcStats_t *stats);
+
+// Replaces the simulated waveform; 'scans' rows of ADC_CH_COUNT samples,
+// played in a loop. The table must stay valid while the sim backend runs.
+void adc_acq_sim_load(const uint16_t *samples, uint32_t scans);
+
+// Converted values from the latest half, false until the first half arrives
+bool adc_acq_temperature_c(float *celsius);
+bool adc_acq_input_percent(AdcChannel_t channel, float *percent);
+
+#endif /* ADC_ACQ_H_ */
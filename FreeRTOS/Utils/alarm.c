@@ -0,0 +1,258 @@
+/*
+ * alarm.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+#include "alarm.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "pubsub.h"
+#include "cli_registry.h"
+#include "uart_logger.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+_Static_assert(ALARM_MAX_RULES <= 8, "channel_rules is a byte mask");
+
+static AlarmRule_t rules[ALARM_MAX_RULES];
+static uint8_t channel_rules[SENSOR_COUNT];  // Bit n set: rule n watches this channel
+
+static const char *const type_names[ALARM_TYPE_COUNT] = {
+	[ALARM_HIGH]  = "high",
+	[ALARM_LOW]   = "low",
+	[ALARM_RATE]  = "rate",
+	[ALARM_STUCK] = "stuck",
+};
+
+const char *alarm_type_name(AlarmType_t type)
+{
+	return (type < ALARM_TYPE_COUNT) ? type_names[type] : "?";
+}
+
+// Applies one sample to a rule. Returns true when the rule changed state,
+// with the value to report in *report.
+static bool rule_step(AlarmRule_t *r, float value, uint32_t time_ms, float *report)
+{
+	bool active = r->active;
+	*report = value;
+
+	switch (r->type) {
+	case ALARM_HIGH:
+		if (!active && value > r->limit) {
+			active = true;
+		} else if (active && value < r->limit - r->hysteresis) {
+			active = false;
+		}
+		break;
+
+	case ALARM_LOW:
+		if (!active && value < r->limit) {
+			active = true;
+		} else if (active && value > r->limit + r->hysteresis) {
+			active = false;
+		}
+		break;
+
+	case ALARM_RATE: {
+		if (!r->primed) {
+			break;
+		}
+		// Compare the change since the window opened against what the rate
+		// limit allows over a whole window, so a step is caught on the
+		// sample that makes it; the window only decides when to clear
+		uint32_t elapsed = time_ms - r->ref_ms;
+		float change = fabsf(value - r->ref_value);
+		float allowed = r->limit * (float)r->window_ms / 1000.0f;
+		*report = change * 1000.0f / (float)((elapsed > 0) ? elapsed : 1);
+
+		if (!active && change > allowed) {
+			active = true;
+		}
+		if (elapsed >= r->window_ms) {
+			if (active && change < allowed - r->hysteresis * (float)r->window_ms / 1000.0f) {
+				active = false;
+			}
+			r->ref_value = value;
+			r->ref_ms = time_ms;
+		}
+		break;
+	}
+
+	case ALARM_STUCK:
+		if (!r->primed || fabsf(value - r->ref_value) > r->limit) {
+			r->ref_value = value;
+			r->ref_ms = time_ms;
+			active = false;
+		} else if (time_ms - r->ref_ms >= r->window_ms) {
+			active = true;
+		}
+		break;
+
+	default:
+		break;
+	}
+
+	if (!r->primed) {
+		r->primed = 1;
+		r->ref_value = value;
+		r->ref_ms = time_ms;
+	}
+
+	if (active == (bool)r->active) {
+		return false;
+	}
+	r->active = active;
+	if (active) {
+		r->raised++;
+	}
+	return true;
+}
+
+void alarm_evaluate(SensorId_t channel, float value, uint32_t time_ms)
+{
+	AlarmEvent_t events[ALARM_MAX_RULES];
+	uint32_t count = 0;
+
+	if (channel >= SENSOR_COUNT) {
+		return;
+	}
+
+	taskENTER_CRITICAL();        // Against rule edits from the CLI
+	for (uint32_t mask = channel_rules[channel]; mask != 0; mask &= mask - 1) {
+		uint32_t n = (uint32_t)__builtin_ctz(mask);
+		AlarmRule_t *r = &rules[n];
+		float report;
+
+		if (rule_step(r, value, time_ms, &report)) {
+			events[count++] = (AlarmEvent_t){ .time_ms = time_ms, .value = report, .rule = (uint8_t)n,
+			                                  .type = r->type, .channel = r->channel, .active = r->active };
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	for (uint32_t i = 0; i < count; i++) {
+		pubsub_publish(TOPIC_ALARM, &events[i]);
+	}
+}
+
+int alarm_add(AlarmType_t type, SensorId_t channel, float limit, float hysteresis, uint32_t window_ms)
+{
+	if (type >= ALARM_TYPE_COUNT || channel >= SENSOR_COUNT || hysteresis < 0.0f) {
+		return -1;
+	}
+	if ((type == ALARM_RATE || type == ALARM_STUCK) && (window_ms == 0 || limit < 0.0f)) {
+		return -1;
+	}
+
+	int slot = -1;
+	taskENTER_CRITICAL();
+	for (uint32_t n = 0; n < ALARM_MAX_RULES; n++) {
+		if (!rules[n].in_use) {
+			rules[n] = (AlarmRule_t){ .limit = limit, .hysteresis = hysteresis, .window_ms = window_ms,
+			                          .type = (uint8_t)type, .channel = (uint8_t)channel, .in_use = 1 };
+			channel_rules[channel] |= (uint8_t)(1U << n);
+			slot = (int)n;
+			break;
+		}
+	}
+	taskEXIT_CRITICAL();
+	return slot;
+}
+
+bool alarm_remove(uint32_t rule)
+{
+	if (rule >= ALARM_MAX_RULES || !rules[rule].in_use) {
+		return false;
+	}
+
+	taskENTER_CRITICAL();
+	channel_rules[rules[rule].channel] &= (uint8_t)~(1U << rule);
+	rules[rule].in_use = 0;
+	taskEXIT_CRITICAL();
+	return true;
+}
+
+void alarm_clear_all(void)
+{
+	taskENTER_CRITICAL();
+	memset(rules, 0, sizeof(rules));
+	memset(channel_rules, 0, sizeof(channel_rules));
+	taskEXIT_CRITICAL();
+}
+
+bool alarm_get_rule(uint32_t rule, AlarmRule_t *out)
+{
+	if (rule >= ALARM_MAX_RULES || out == NULL) {
+		return false;
+	}
+
+	taskENTER_CRITICAL();
+	*out = rules[rule];
+	taskEXIT_CRITICAL();
+	return out->in_use;
+}
+
+static int find_type(const char *name)
+{
+	for (uint32_t t = 0; t < ALARM_TYPE_COUNT; t++) {
+		if (strcmp(name, type_names[t]) == 0) {
+			return (int)t;
+		}
+	}
+	return -1;
+}
+
+// alarm | alarm high|low <sensor> <limit> [hyst] | alarm rate <sensor> <per_s> <window_ms> [hyst]
+// alarm stuck <sensor> <delta> <ms> | alarm del <n> | alarm clear
+CLI_COMMAND(alarm, "|ssfff", "[high|low|rate|stuck <sensor> ...|del <n>|clear]", "List or edit alarm rules")
+{
+	if (args->count > 0) {
+		const char *op = args->v[0].s;
+		int type = find_type(op);
+
+		if (strcmp(op, "clear") == 0) {
+			alarm_clear_all();
+		} else if (strcmp(op, "del") == 0 && args->count == 2) {
+			// Slot 1 is a sensor name for the other forms, so parse the number here
+			char *end;
+			uint32_t n = strtoul(args->v[1].s, &end, 0);
+			if (end == args->v[1].s || *end != '\0' || !alarm_remove(n)) {
+				log_printf("No such rule\r\n");
+				return;
+			}
+		} else if (type >= 0 && args->count >= 3) {
+			int id = sensor_find(args->v[1].s);
+			bool windowed = (type == ALARM_RATE || type == ALARM_STUCK);
+			float limit = args->v[2].f;
+			float window = (windowed && args->count > 3) ? args->v[3].f : 0.0f;
+			uint32_t hyst_arg = windowed ? 4 : 3;
+			float hyst = (args->count > hyst_arg && type != ALARM_STUCK) ? args->v[hyst_arg].f : 0.0f;
+
+			if (id < 0 || (windowed && args->count < 4) ||
+			    alarm_add((AlarmType_t)type, (SensorId_t)id, limit, hyst, (uint32_t)window) < 0) {
+				log_printf("Invalid rule or table full (%u rules)\r\n", ALARM_MAX_RULES);
+				return;
+			}
+		} else {
+			log_printf("Usage: alarm high|low <sensor> <limit> [hyst]\r\n");
+			log_printf("       alarm rate <sensor> <per_s> <window_ms> [hyst]\r\n");
+			log_printf("       alarm stuck <sensor> <delta> <ms> | alarm del <n> | alarm clear\r\n");
+			return;
+		}
+	}
+
+	log_printf("#  Sensor    Type   Limit      Hyst     Window(ms)  State   Raised\r\n");
+	for (uint32_t n = 0; n < ALARM_MAX_RULES; n++) {
+		AlarmRule_t r;
+		if (!alarm_get_rule(n, &r)) {
+			continue;
+		}
+		SensorStats_t sensor;
+		sensor_get_stats((SensorId_t)r.channel, &sensor);
+		log_printf("%-2lu %-9s %-6s %-10.2f %-8.2f %-11lu %-7s %lu\r\n",
+		           n, sensor.name, alarm_type_name((AlarmType_t)r.type), r.limit, r.hysteresis,
+		           r.window_ms, r.active ? "ACTIVE" : "ok", r.raised);
+	}
+}
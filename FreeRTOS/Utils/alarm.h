@@ -0,0 +1,67 @@
+/*
+ * alarm.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+
+#ifndef ALARM_H_
+#define ALARM_H_
+
+#include "sensor_sched.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Alarm rules evaluated inline by the pipeline's aggregate stage on every
+// filtered sample, so an alarm is raised on the sample that crosses the
+// rule rather than on the next poll. Each sample only costs the rules on
+// its own channel. Raise and clear transitions are published on the alarm
+// topic; TelemetryTask reports them on the console, or as frames while the
+// binary stream is on.
+
+#define ALARM_MAX_RULES          8
+
+typedef enum {
+	ALARM_HIGH = 0,              // value > limit, clears below limit - hysteresis
+	ALARM_LOW,                   // value < limit, clears above limit + hysteresis
+	ALARM_RATE,                  // |change| > limit/s within window_ms, clears below limit - hysteresis
+	ALARM_STUCK,                 // Moved less than limit for window_ms, clears on the next move
+	ALARM_TYPE_COUNT
+} AlarmType_t;
+
+typedef struct {
+	float limit;
+	float hysteresis;
+	uint32_t window_ms;          // Rate window or stuck duration
+	uint8_t type;                // AlarmType_t
+	uint8_t channel;             // SensorId_t
+	uint8_t in_use;
+	uint8_t active;
+	uint8_t primed;              // Has seen a sample; ref_* are valid
+	// Evaluation state: reference sample for rate and stuck rules
+	float ref_value;
+	uint32_t ref_ms;
+	uint32_t raised;             // Times this rule has gone active
+} AlarmRule_t;
+
+typedef struct {
+	uint32_t time_ms;
+	float value;                 // Sample that caused the transition (rate: change per second)
+	uint8_t rule;
+	uint8_t type;                // AlarmType_t
+	uint8_t channel;             // SensorId_t
+	uint8_t active;              // 1 raised, 0 cleared
+} AlarmEvent_t;
+
+// Called by the aggregate stage for every sample
+void alarm_evaluate(SensorId_t channel, float value, uint32_t time_ms);
+
+// Returns the rule slot, or -1 when the table is full or the rule is invalid
+int alarm_add(AlarmType_t type, SensorId_t channel, float limit, float hysteresis, uint32_t window_ms);
+bool alarm_remove(uint32_t rule);
+void alarm_clear_all(void);
+bool alarm_get_rule(uint32_t rule, AlarmRule_t *out);
+
+const char *alarm_type_name(AlarmType_t type);
+
+#endif /* ALARM_H_ */
@@ -7,11 +7,240 @@
 
 #include "boot_metadata.h"
 #include "stm32f4xx_hal.h"
+#include "ota.h"
+#include "flash_ctrl.h"
 
-BootMetadata_t *boot_metadata = (BootMetadata_t *)0x0800C000;  // METADATA address
+static BootMetadata_t current;
+static uint32_t current_seq = 0;
+static uint32_t next_record = 0;   // First blank record after the last used one
+static bool journaled = false;     // Bootloader reported BOOT_CAP_JOURNAL
+
+BootMetadata_t *boot_metadata = &current;
 uint32_t slot_to_erase_addr = 0;
 uint32_t sectors_to_erase[2] = {0};
 
+static const BootMetadataRecord_t *record_at(uint32_t base, uint32_t index)
+{
+	return (const BootMetadataRecord_t *)(base + index * METADATA_RECORD_SIZE);
+}
+
+static uint32_t record_crc(const BootMetadataRecord_t *rec)
+{
+	return ~crc32_update_words(0xFFFFFFFF, (const uint32_t *)rec, METADATA_RECORD_WORDS - 1);
+}
+
+static bool record_blank(const BootMetadataRecord_t *rec)
+{
+	const uint32_t *w = (const uint32_t *)rec;
+
+	for (uint32_t i = 0; i < METADATA_RECORD_WORDS; i++) {
+		if (w[i] != 0xFFFFFFFF) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Last record in a journal area that passes its check. Records are
+// appended in order, so the used ones end at the last non-blank; torn or
+// corrupt ones after the newest valid one still take up their place.
+static const BootMetadataRecord_t *journal_newest(uint32_t base, uint32_t count, uint32_t *used)
+{
+	*used = 0;
+	for (uint32_t i = 0; i < count; i++) {
+		if (!record_blank(record_at(base, i))) {
+			*used = i + 1;
+		}
+	}
+	for (uint32_t i = *used; i > 0; i--) {
+		const BootMetadataRecord_t *rec = record_at(base, i - 1);
+		if (rec->marker == METADATA_JOURNAL_MARKER && rec->record_crc == record_crc(rec)) {
+			return rec;
+		}
+	}
+	return NULL;
+}
+
+void boot_metadata_load(void)
+{
+	const BootMetadataRecord_t *legacy = (const BootMetadataRecord_t *)METADATA_ADDRESS;
+	const BootMetadataRecord_t *newest = journal_newest(METADATA_ADDRESS, METADATA_RECORDS, &next_record);
+	uint32_t bridge_used;
+
+	// Sector 3 only loses every record to power loss during a wrap, and
+	// then the bridge holds the record that was current
+	if (newest == NULL && legacy->marker != VALID_MARKER) {
+		newest = journal_newest(METADATA_BRIDGE_ADDRESS, METADATA_BRIDGE_RECORDS, &bridge_used);
+	}
+
+	current.reserved[0] = 0;
+	current.reserved[1] = 0;
+	if (newest != NULL) {
+		current.is_valid = VALID_MARKER;
+		current.version = newest->version;
+		current.active_slot = newest->active_slot;
+		current.crc = newest->crc;
+		current.image_size = newest->image_size;
+		current_seq = newest->seq;
+	} else {
+		// Nothing journaled yet: take the old single record as-is, valid or not
+		current = *(const BootMetadata_t *)METADATA_ADDRESS;
+		current_seq = 0;
+	}
+}
+
+void boot_metadata_init(void)
+{
+	__HAL_RCC_PWR_CLK_ENABLE();
+	HAL_PWR_EnableBkUpAccess();
+	__HAL_RCC_BKPSRAM_CLK_ENABLE();
+
+	// Cleared once read, so a bootloader swapped for an older one that never
+	// writes the word is not mistaken for a journaling one on the next boot
+	BootCaps_t *caps = (BootCaps_t *)BOOT_CAPS_ADDRESS;
+	journaled = caps->magic == BOOT_CAPS_MAGIC &&
+			caps->check == ~(caps->magic ^ caps->caps) &&
+			(caps->caps & BOOT_CAP_JOURNAL) != 0;
+	caps->magic = 0;
+
+	boot_metadata_load();
+}
+
+bool boot_metadata_journaled(void)
+{
+	return journaled;
+}
+
+static BootMetadataRecord_t record_make(const BootMetadata_t *metadata, uint32_t seq)
+{
+	BootMetadataRecord_t rec = {
+		.marker = METADATA_JOURNAL_MARKER,
+		.seq = seq,
+		.version = metadata->version,
+		.active_slot = metadata->active_slot,
+		.crc = metadata->crc,
+		.image_size = metadata->image_size,
+		.reserved = 0,
+	};
+	rec.record_crc = record_crc(&rec);
+	return rec;
+}
+
+// Body first, marker last: until the marker lands the record is not valid
+static HAL_StatusTypeDef record_program(uint32_t addr, const BootMetadataRecord_t *rec)
+{
+	const uint32_t *words = (const uint32_t *)rec;
+
+	for (uint32_t i = 1; i <= METADATA_RECORD_WORDS; i++) {
+		uint32_t w = i % METADATA_RECORD_WORDS;
+		HAL_StatusTypeDef status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, addr + w * 4, words[w]);
+		if (status != HAL_OK) {
+			return status;
+		}
+	}
+	return HAL_OK;
+}
+
+// Copies the current record to the bridge so that it is never only in the
+// sector being erased. A full bridge (2048 wraps without a slot B erase)
+// is left as it is.
+static HAL_StatusTypeDef bridge_save(void)
+{
+	uint32_t used;
+
+	if (current.is_valid != VALID_MARKER) {
+		return HAL_OK;
+	}
+	journal_newest(METADATA_BRIDGE_ADDRESS, METADATA_BRIDGE_RECORDS, &used);
+	if (used >= METADATA_BRIDGE_RECORDS) {
+		return HAL_OK;
+	}
+	BootMetadataRecord_t rec = record_make(&current, current_seq);
+	return record_program(METADATA_BRIDGE_ADDRESS + used * METADATA_RECORD_SIZE, &rec);
+}
+
+// Erases sector 3 with the current record saved to the bridge first
+static HAL_StatusTypeDef sector_erase(void)
+{
+	HAL_StatusTypeDef status = bridge_save();
+	if (status != HAL_OK) {
+		return status;
+	}
+	FLASH_EraseInitTypeDef erase = {
+		.TypeErase = FLASH_TYPEERASE_SECTORS,
+		.VoltageRange = FLASH_VOLTAGE_RANGE_3,
+		.Sector = FLASH_SECTOR_3,
+		.NbSectors = 1
+	};
+	uint32_t sector_error;
+	status = HAL_FLASHEx_Erase(&erase, &sector_error);
+	if (status == HAL_OK) {
+		next_record = 0;
+	}
+	return status;
+}
+
+// Single record at the sector base for bootloaders without the journal;
+// is_valid goes last, as those bootloaders check only that word
+static HAL_StatusTypeDef legacy_write_locked(const BootMetadata_t *metadata)
+{
+	const uint32_t *words = (const uint32_t *)metadata;
+	HAL_StatusTypeDef status = sector_erase();
+
+	for (uint32_t i = 1; status == HAL_OK && i <= sizeof(BootMetadata_t) / 4; i++) {
+		uint32_t w = i % (sizeof(BootMetadata_t) / 4);
+		uint32_t value = (w == 0) ? VALID_MARKER : words[w];
+		status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, METADATA_ADDRESS + w * 4, value);
+	}
+
+	boot_metadata_load();
+	return status;
+}
+
+static HAL_StatusTypeDef append_locked(const BootMetadata_t *metadata)
+{
+	BootMetadataRecord_t rec = record_make(metadata, current_seq + 1);
+	HAL_StatusTypeDef status;
+
+	if (!journaled) {
+		return legacy_write_locked(metadata);
+	}
+
+	if (next_record >= METADATA_RECORDS) {
+		status = sector_erase();
+		if (status != HAL_OK) {
+			return status;
+		}
+	}
+
+	status = record_program(METADATA_ADDRESS + next_record * METADATA_RECORD_SIZE, &rec);
+	if (status != HAL_OK) {
+		next_record++;
+		return status;
+	}
+
+	boot_metadata_load();
+	return (current_seq == rec.seq) ? HAL_OK : HAL_ERROR;
+}
+
+HAL_StatusTypeDef boot_metadata_append(const BootMetadata_t *metadata)
+{
+	flash_ctrl_lock();
+	HAL_StatusTypeDef status = append_locked(metadata);
+	flash_ctrl_unlock();
+	return status;
+}
+
+uint32_t boot_metadata_seq(void)
+{
+	return current_seq;
+}
+
+uint32_t boot_metadata_free_records(void)
+{
+	return METADATA_RECORDS - next_record;
+}
+
 bool ota_slot_check(){
 	if(boot_metadata->is_valid != VALID_MARKER){
 		return false;
@@ -20,6 +20,38 @@
 #define SLOT_A_SECTORS    {FLASH_SECTOR_4, FLASH_SECTOR_5}
 #define SLOT_B_SECTORS    {FLASH_SECTOR_6, FLASH_SECTOR_7}
 
+// Sector 3 is a journal of fixed-size metadata records, appended one after
+// another; the last valid record by position is current.
+// An update programs eight words into the next blank record with the
+// marker last, so power loss mid-write leaves a record that fails its
+// check and the previous one stays current. The sector is erased only when
+// all 512 records are used. Before that erase the current record is copied
+// to the bridge, a second journal in the tail of sector 7 past the largest
+// slot B image, which is read only when sector 3 holds no valid record; a
+// power loss between the erase and the next record therefore still boots
+// the current slot. The bridge is erased with slot B, which never happens
+// during a wrap, as both hold the flash controller.
+//
+// A record with VALID_MARKER in the first word at the sector base is the
+// single-record layout older images wrote; it is read as sequence 0.
+// The bootloader (FreeRTOS_bootloader/Core/Src/main.c) has its own copy
+// of this format.
+#define METADATA_SECTOR_SIZE      (16U * 1024U)
+#define METADATA_JOURNAL_MARKER   0x4A524E4CU  // "JRNL"
+#define METADATA_RECORD_WORDS     8
+#define METADATA_RECORD_SIZE      (METADATA_RECORD_WORDS * 4)
+#define METADATA_RECORDS          (METADATA_SECTOR_SIZE / METADATA_RECORD_SIZE)
+#define METADATA_BRIDGE_ADDRESS   0x08070000   // Slot B images stop at 192K
+#define METADATA_BRIDGE_RECORDS   ((64U * 1024U) / METADATA_RECORD_SIZE)
+
+// Bootloaders that read the journal say so on every boot in backup SRAM,
+// just after their verification cache. Older ones read only the record at
+// the sector base, so without this word updates keep writing that single
+// record (erase, then is_valid last) and the journal is left unused.
+#define BOOT_CAPS_ADDRESS         (BKPSRAM_BASE + 0x40)
+#define BOOT_CAPS_MAGIC           0x424C4452U  // "BLDR"
+#define BOOT_CAP_JOURNAL          (1U << 0)
+
 typedef enum {
     SLOT_A = 0,
     SLOT_B = 1
@@ -34,10 +66,48 @@ typedef struct {
     uint32_t reserved[2];    // Reserved for future use
 } BootMetadata_t;
 
+typedef struct {
+    uint32_t magic;          // BOOT_CAPS_MAGIC
+    uint32_t caps;           // BOOT_CAP_* bits
+    uint32_t check;          // ~(magic ^ caps)
+} BootCaps_t;
+
+// One journal entry in flash
+typedef struct {
+    uint32_t marker;         // METADATA_JOURNAL_MARKER, programmed last
+    uint32_t seq;            // +1 per record
+    uint32_t version;
+    uint32_t active_slot;
+    uint32_t crc;
+    uint32_t image_size;
+    uint32_t reserved;
+    uint32_t record_crc;     // CRC-32 of the seven words above
+} BootMetadataRecord_t;
+
+// RAM copy of the current record; is_valid is VALID_MARKER when one was found
 extern BootMetadata_t *boot_metadata;
 extern uint32_t slot_to_erase_addr;
 extern uint32_t sectors_to_erase[2];
 
+// Reads and clears the bootloader capability word, then loads the journal.
+// Call once at startup.
+void boot_metadata_init(void);
+
+// Scans the journal into boot_metadata; also done after every append
+void boot_metadata_load(void);
+
+// True when the bootloader reads the journal, so appends are used
+bool boot_metadata_journaled(void);
+
+// Appends a record with the next sequence number, erasing the sector first
+// only if it is full; with an older bootloader, rewrites the single record
+// at the sector base instead. Flash must be unlocked by the caller.
+HAL_StatusTypeDef boot_metadata_append(const BootMetadata_t *metadata);
+
+// Sequence number of the current record and records left before an erase
+uint32_t boot_metadata_seq(void);
+uint32_t boot_metadata_free_records(void);
+
 bool ota_slot_check();
 
 #endif /* BOOT_METADATA_H_ */
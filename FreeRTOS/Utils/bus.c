@@ -0,0 +1,348 @@
+/*
+ * bus.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+#include "bus.h"
+#include "main.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "cmsis_os2.h"
+#include "cycle_counter.h"
+#include "quantile.h"
+#include "cli_registry.h"
+#include "uart_logger.h"
+#include <string.h>
+
+#define MOCK_BYTE_TIME_US        90      // One byte plus ACK at 100 kHz I2C
+
+typedef struct {
+	const char *name;
+	const BusBackend_t *backend;
+	BusXfer_t *active;
+	BusXfer_t *head;             // Waiting behind 'active', oldest first
+	BusXfer_t *tail;
+	uint32_t depth;              // Waiting plus active
+	uint32_t high_water;
+	uint32_t transfers;
+	uint32_t errors;
+	uint32_t bytes;
+	uint32_t max_latency_us;
+	uint32_t busy_since;         // Cycle count when 'active' started
+	uint32_t busy_us;
+	uint32_t window_start;       // Tick of the last stats reset
+} Bus_t;
+
+static void mock_init(void);
+static void mock_start(const BusXfer_t *xfer);
+static const BusBackend_t bus_mock_backend = { mock_init, mock_start };
+
+static Bus_t buses[BUS_COUNT] = {
+	[BUS_I2C1] = { .name = "i2c1", .backend = &bus_i2c1_backend },
+	[BUS_SPI1] = { .name = "spi1", .backend = &bus_spi1_backend },
+	[BUS_MOCK] = { .name = "mock", .backend = &bus_mock_backend },
+};
+
+void bus_init(void)
+{
+	for (uint32_t b = 0; b < BUS_COUNT; b++) {
+		buses[b].backend->init();
+		buses[b].window_start = osKernelGetTickCount();
+	}
+}
+
+static void bus_start(Bus_t *bus, BusXfer_t *xfer)
+{
+	xfer->status = BUS_XFER_ACTIVE;
+	bus->backend->start(xfer);
+}
+
+bool bus_submit(BusId_t id, BusXfer_t *xfer)
+{
+	if (id >= BUS_COUNT || xfer == NULL) {
+		return false;
+	}
+
+	Bus_t *bus = &buses[id];
+	bool start_now = false;
+
+	UBaseType_t isrm = taskENTER_CRITICAL_FROM_ISR();
+	if (xfer->status == BUS_XFER_QUEUED || xfer->status == BUS_XFER_ACTIVE) {
+		taskEXIT_CRITICAL_FROM_ISR(isrm);
+		return false;
+	}
+
+	xfer->status = BUS_XFER_QUEUED;
+	xfer->next = NULL;
+	xfer->queued_at = cycle_counter_now();
+	if (bus->active == NULL) {
+		bus->active = xfer;
+		bus->busy_since = xfer->queued_at;
+		start_now = true;
+	} else if (bus->tail == NULL) {
+		bus->head = bus->tail = xfer;
+	} else {
+		bus->tail->next = xfer;
+		bus->tail = xfer;
+	}
+	bus->depth++;
+	if (bus->depth > bus->high_water) {
+		bus->high_water = bus->depth;
+	}
+	taskEXIT_CRITICAL_FROM_ISR(isrm);
+
+	// Only the submitter that found the bus idle starts it; everyone else
+	// is picked up by bus_complete()
+	if (start_now) {
+		bus_start(bus, xfer);
+	}
+	return true;
+}
+
+void bus_complete(BusId_t id, BusXferStatus_t status)
+{
+	Bus_t *bus = &buses[id];
+	uint32_t now = cycle_counter_now();
+
+	UBaseType_t isrm = taskENTER_CRITICAL_FROM_ISR();
+	BusXfer_t *done = bus->active;
+	if (done == NULL) {
+		taskEXIT_CRITICAL_FROM_ISR(isrm);
+		return;
+	}
+
+	uint32_t latency_us = cycles_to_us(now - done->queued_at);
+	bus->busy_us += cycles_to_us(now - bus->busy_since);
+	bus->transfers++;
+	bus->bytes += done->tx_len + done->rx_len;
+	if (status != BUS_XFER_OK) {
+		bus->errors++;
+	}
+	if (latency_us > bus->max_latency_us) {
+		bus->max_latency_us = latency_us;
+	}
+	quantile_record(QMETRIC_BUS_LATENCY, (float)latency_us);
+	bus->depth--;
+
+	BusXfer_t *next = bus->head;
+	if (next != NULL) {
+		bus->head = next->next;
+		if (bus->head == NULL) {
+			bus->tail = NULL;
+		}
+		bus->busy_since = now;
+	}
+	bus->active = next;
+	taskEXIT_CRITICAL_FROM_ISR(isrm);
+
+	// Keep the bus busy before running the callback, which may queue more
+	if (next != NULL) {
+		bus_start(bus, next);
+	}
+	done->status = status;
+	if (done->done != NULL) {
+		done->done(done);
+	}
+}
+
+void bus_get_stats(BusId_t id, BusStats_t *stats)
+{
+	if (id >= BUS_COUNT || stats == NULL) {
+		return;
+	}
+
+	Bus_t *bus = &buses[id];
+	uint32_t now = cycle_counter_now();
+
+	taskENTER_CRITICAL();
+	uint32_t busy_us = bus->busy_us;
+	if (bus->active != NULL) {
+		busy_us += cycles_to_us(now - bus->busy_since);
+	}
+	uint32_t window_ms = osKernelGetTickCount() - bus->window_start;
+	stats->name = bus->name;
+	stats->transfers = bus->transfers;
+	stats->errors = bus->errors;
+	stats->bytes = bus->bytes;
+	stats->queue_depth = bus->depth;
+	stats->queue_high_water = bus->high_water;
+	stats->max_latency_us = bus->max_latency_us;
+	taskEXIT_CRITICAL();
+
+	// busy_us / (window_ms * 1000) in permille
+	stats->busy_permille = (window_ms > 0) ? (uint32_t)(((uint64_t)busy_us) / window_ms) : 0;
+	if (stats->busy_permille > 1000) {
+		stats->busy_permille = 1000;
+	}
+}
+
+void bus_reset_stats(BusId_t id)
+{
+	if (id >= BUS_COUNT) {
+		return;
+	}
+
+	Bus_t *bus = &buses[id];
+	taskENTER_CRITICAL();
+	bus->transfers = 0;
+	bus->errors = 0;
+	bus->bytes = 0;
+	bus->high_water = bus->depth;
+	bus->max_latency_us = 0;
+	bus->busy_us = 0;
+	bus->busy_since = cycle_counter_now();
+	bus->window_start = osKernelGetTickCount();
+	taskEXIT_CRITICAL();
+}
+
+// Mock backend: completes each transfer from a one-shot timer after roughly
+// the time it would take on the wire, so queueing and callbacks behave as on
+// hardware while the data comes from a replaceable device model.
+static StaticTimer_t mock_timer_cb;
+static osTimerId_t mock_timer;
+static const BusXfer_t *mock_xfer;
+static BusMockFunc_t mock_model;
+
+static BusXferStatus_t mock_default_model(uint8_t device, const uint8_t *tx, uint16_t tx_len,
+                                          uint8_t *rx, uint16_t rx_len)
+{
+	uint8_t base = (uint8_t)(device + ((tx_len > 0) ? tx[0] : 0));
+	for (uint16_t i = 0; i < rx_len; i++) {
+		rx[i] = (uint8_t)(base + i);
+	}
+	return BUS_XFER_OK;
+}
+
+static void mock_timer_callback(void *argument)
+{
+	const BusXfer_t *xfer = mock_xfer;
+	BusMockFunc_t model = (mock_model != NULL) ? mock_model : mock_default_model;
+
+	bus_complete(BUS_MOCK, model(xfer->device, xfer->tx, xfer->tx_len, xfer->rx, xfer->rx_len));
+}
+
+static void mock_init(void)
+{
+	osTimerAttr_t attr = {
+		.name = "BusMock",
+		.cb_mem = &mock_timer_cb,
+		.cb_size = sizeof(mock_timer_cb)
+	};
+	mock_timer = osTimerNew(mock_timer_callback, osTimerOnce, NULL, &attr);
+	if (mock_timer == NULL) {
+		log_printf("Bus mock timer creation failed\r\n");
+	}
+}
+
+static void mock_start(const BusXfer_t *xfer)
+{
+	// Tick resolution: anything shorter than a millisecond takes one tick
+	uint32_t us = (1U + xfer->tx_len + xfer->rx_len) * MOCK_BYTE_TIME_US;
+	uint32_t ticks = (us + 999U) / 1000U;
+
+	mock_xfer = xfer;
+	if (mock_timer == NULL || osTimerStart(mock_timer, ticks) != osOK) {
+		bus_complete(BUS_MOCK, BUS_XFER_ERROR);
+	}
+}
+
+void bus_mock_set_device(BusMockFunc_t model)
+{
+	mock_model = model;
+}
+
+int bus_find(const char *name)
+{
+	for (uint32_t b = 0; b < BUS_COUNT; b++) {
+		if (strcmp(name, buses[b].name) == 0) {
+			return (int)b;
+		}
+	}
+	return -1;
+}
+
+#define BUS_PROBE_MAX            8
+#define BUS_PROBE_FLAG           0x0100U
+#define BUS_PROBE_TIMEOUT_MS     500
+
+static const char *const status_names[] = { "idle", "queued", "active", "ok", "nack", "error" };
+
+static volatile uint32_t probe_pending;
+
+static void probe_done(BusXfer_t *xfer)
+{
+	if (--probe_pending == 0) {
+		osThreadFlagsSet((osThreadId_t)xfer->context, BUS_PROBE_FLAG);
+	}
+}
+
+// Queues 'count' register reads back-to-back and waits for all of them
+static void bus_probe(BusId_t id, uint8_t device, uint8_t reg, uint32_t count)
+{
+	static BusXfer_t xfers[BUS_PROBE_MAX];
+	static uint8_t rx[BUS_PROBE_MAX][2];
+	static uint8_t reg_byte;
+
+	for (uint32_t i = 0; i < BUS_PROBE_MAX; i++) {
+		if (xfers[i].status == BUS_XFER_QUEUED || xfers[i].status == BUS_XFER_ACTIVE) {
+			log_printf("Previous probe still in flight\r\n");
+			return;
+		}
+	}
+
+	reg_byte = reg;
+	probe_pending = count;
+	osThreadFlagsClear(BUS_PROBE_FLAG);
+
+	uint32_t start = cycle_counter_now();
+	for (uint32_t i = 0; i < count; i++) {
+		memset(&xfers[i], 0, sizeof(xfers[i]));
+		bus_xfer_reg_read(&xfers[i], device, &reg_byte, rx[i], sizeof(rx[i]), probe_done, osThreadGetId());
+		bus_submit(id, &xfers[i]);
+	}
+	uint32_t submit_us = cycles_to_us(cycle_counter_now() - start);
+
+	if (osThreadFlagsWait(BUS_PROBE_FLAG, osFlagsWaitAny, BUS_PROBE_TIMEOUT_MS) & osFlagsError) {
+		// Transfers still reference our buffers; leave them for the bus to finish
+		log_printf("Probe timed out, %lu transfers outstanding\r\n", probe_pending);
+		return;
+	}
+	uint32_t total_us = cycles_to_us(cycle_counter_now() - start);
+
+	log_printf("%lu reads queued in %lu us, all done in %lu us\r\n", count, submit_us, total_us);
+	for (uint32_t i = 0; i < count; i++) {
+		log_printf("  #%lu %s: %02X %02X\r\n", i, status_names[xfers[i].status], rx[i][0], rx[i][1]);
+	}
+}
+
+// bus | bus reset | bus probe <bus> <device> <reg> [count]
+CLI_COMMAND(bus, "|ssuuu", "[reset | probe <i2c1|spi1|mock> <device> <reg> [count]]", "Sensor bus statistics and test reads")
+{
+	if (args->count > 0 && strcmp(args->v[0].s, "reset") == 0) {
+		for (uint32_t b = 0; b < BUS_COUNT; b++) {
+			bus_reset_stats((BusId_t)b);
+		}
+	} else if (args->count >= 4 && strcmp(args->v[0].s, "probe") == 0) {
+		int id = bus_find(args->v[1].s);
+		uint32_t count = (args->count > 4) ? args->v[4].u : 1;
+		if (id < 0 || count == 0 || count > BUS_PROBE_MAX || args->v[2].u > 0x7F || args->v[3].u > 0xFF) {
+			log_printf("Unknown bus, or device > 0x7F, reg > 0xFF, count outside 1..%u\r\n", BUS_PROBE_MAX);
+			return;
+		}
+		bus_probe((BusId_t)id, (uint8_t)args->v[2].u, (uint8_t)args->v[3].u, count);
+		return;
+	} else if (args->count > 0) {
+		log_printf("Usage: bus [reset | probe <i2c1|spi1|mock> <device> <reg> [count]]\r\n");
+		return;
+	}
+
+	log_printf("Bus   Xfers    Errors  Bytes     Depth/Max  MaxLat(us)  Busy\r\n");
+	for (uint32_t b = 0; b < BUS_COUNT; b++) {
+		BusStats_t stats;
+		bus_get_stats((BusId_t)b, &stats);
+		log_printf("%-5s %-8lu %-7lu %-9lu %lu/%-7lu %-11lu %lu.%lu%%\r\n", stats.name, stats.transfers,
+		           stats.errors, stats.bytes, stats.queue_depth, stats.queue_high_water,
+		           stats.max_latency_us, stats.busy_permille / 10, stats.busy_permille % 10);
+	}
+}
@@ -0,0 +1,120 @@
+/*
+ * bus.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+
+#ifndef BUS_H_
+#define BUS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Asynchronous sensor bus layer. Callers queue transfers and get a callback
+// when each one finishes, so several devices can be polled back-to-back
+// without a task blocking on any single transfer.
+
+typedef enum {
+	BUS_I2C1 = 0,                // PB8 SCL / PB9 SDA, 100 kHz, DMA1 Stream6 TX / Stream0 RX
+	BUS_SPI1,                    // PB3 SCK / PB4 MISO / PB5 MOSI, CS on PB6, DMA2 Stream3 TX / Stream2 RX
+	BUS_MOCK,                    // No hardware; completes from a timer with scripted data
+	BUS_COUNT
+} BusId_t;
+
+typedef enum {
+	BUS_XFER_IDLE = 0,
+	BUS_XFER_QUEUED,
+	BUS_XFER_ACTIVE,
+	BUS_XFER_OK,
+	BUS_XFER_NACK,               // I2C address or data not acknowledged
+	BUS_XFER_ERROR               // Bus or DMA error
+} BusXferStatus_t;
+
+typedef struct BusXfer BusXfer_t;
+
+// Runs in the context that finished the transfer (ISR for hardware buses,
+// timer service for the mock), so it must only use FromISR-safe calls such
+// as osThreadFlagsSet(). The next queued transfer is already running.
+typedef void (*BusDoneFunc_t)(BusXfer_t *xfer);
+
+// Owned by the caller and must stay valid until the callback runs. The write
+// phase is sent first, then rx_len bytes are read (repeated start on I2C,
+// clocked out with 0xFF on SPI). Either length may be zero; with both zero
+// I2C sends only the address, which completes OK or NACK.
+struct BusXfer {
+	uint8_t device;              // 7-bit I2C address, or SPI chip-select index
+	uint16_t tx_len;
+	uint16_t rx_len;
+	const uint8_t *tx;
+	uint8_t *rx;
+	BusDoneFunc_t done;
+	void *context;               // For the callback's use
+	volatile BusXferStatus_t status;
+	uint32_t queued_at;          // Cycle count at submit
+	BusXfer_t *next;
+};
+
+typedef struct {
+	const char *name;
+	uint32_t transfers;
+	uint32_t errors;
+	uint32_t bytes;
+	uint32_t queue_depth;
+	uint32_t queue_high_water;
+	uint32_t max_latency_us;     // Submit to completion, including queueing
+	uint32_t busy_permille;      // Time a transfer was in flight since the last reset
+} BusStats_t;
+
+// Builds a write-then-read transfer for the common "read N bytes from
+// register R" case. 'reg' must stay valid with the transfer.
+static inline void bus_xfer_reg_read(BusXfer_t *xfer, uint8_t device, const uint8_t *reg,
+                                     uint8_t *rx, uint16_t rx_len, BusDoneFunc_t done, void *context)
+{
+	xfer->device = device;
+	xfer->tx = reg;
+	xfer->tx_len = 1;
+	xfer->rx = rx;
+	xfer->rx_len = rx_len;
+	xfer->done = done;
+	xfer->context = context;
+}
+
+void bus_init(void);
+
+// Queues a transfer and starts it if the bus is idle. Returns false if the
+// transfer is still pending from an earlier submit. Safe from ISRs.
+bool bus_submit(BusId_t bus, BusXfer_t *xfer);
+
+// Returns the BusId_t named "i2c1", "spi1" or "mock", or -1
+int bus_find(const char *name);
+void bus_get_stats(BusId_t bus, BusStats_t *stats);
+void bus_reset_stats(BusId_t bus);
+
+// Mock device model: fills 'rx' for a transfer to 'device' and returns the
+// status to report. NULL restores the default (each rx byte is the device
+// address plus the first tx byte plus its index, so reads are predictable).
+typedef BusXferStatus_t (*BusMockFunc_t)(uint8_t device, const uint8_t *tx, uint16_t tx_len,
+                                         uint8_t *rx, uint16_t rx_len);
+void bus_mock_set_device(BusMockFunc_t model);
+
+// Backend interface, used by bus.c and the bus_*.c drivers only
+typedef struct {
+	void (*init)(void);
+	void (*start)(const BusXfer_t *xfer);   // Called with the bus idle
+} BusBackend_t;
+
+extern const BusBackend_t bus_i2c1_backend;
+extern const BusBackend_t bus_spi1_backend;
+
+// Called by a backend (usually from its ISR) when the active transfer ends
+void bus_complete(BusId_t bus, BusXferStatus_t status);
+
+// IRQ entry points, called from stm32f4xx_it.c
+void bus_i2c1_ev_irq(void);
+void bus_i2c1_er_irq(void);
+void bus_i2c1_dma_tx_irq(void);
+void bus_i2c1_dma_rx_irq(void);
+void bus_spi1_dma_rx_irq(void);
+
+#endif /* BUS_H_ */
@@ -0,0 +1,189 @@
+/*
+ * bus_i2c.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+#include "bus.h"
+#include "main.h"
+
+// The HAL I2C driver is not part of this project, so I2C1 and its DMA1
+// streams are driven through their registers. The event interrupt walks the
+// start/address phases; DMA moves the data and its completion ends each phase.
+#define I2C_DMA_TX               DMA1_Stream6    // I2C1_TX, channel 1
+#define I2C_DMA_RX               DMA1_Stream0    // I2C1_RX, channel 1
+#define I2C_DMA_CHANNEL          (1U << DMA_SxCR_CHSEL_Pos)
+#define I2C_IRQ_PRIORITY         6               // Below configMAX_SYSCALL, may use FromISR APIs
+#define I2C_SPEED_HZ             100000U
+
+#define I2C_DMA_TX_FLAGS         (DMA_HIFCR_CTCIF6 | DMA_HIFCR_CHTIF6 | DMA_HIFCR_CTEIF6 | DMA_HIFCR_CDMEIF6 | DMA_HIFCR_CFEIF6)
+#define I2C_DMA_RX_FLAGS         (DMA_LIFCR_CTCIF0 | DMA_LIFCR_CHTIF0 | DMA_LIFCR_CTEIF0 | DMA_LIFCR_CDMEIF0 | DMA_LIFCR_CFEIF0)
+#define I2C_SR1_ERRORS           (I2C_SR1_BERR | I2C_SR1_ARLO | I2C_SR1_AF | I2C_SR1_OVR | I2C_SR1_TIMEOUT)
+
+typedef enum {
+	I2C_PHASE_WRITE = 0,
+	I2C_PHASE_READ
+} I2cPhase_t;
+
+static const BusXfer_t *i2c_xfer;
+static I2cPhase_t i2c_phase;
+
+static void i2c_dma_stop(DMA_Stream_TypeDef *stream)
+{
+	stream->CR &= ~DMA_SxCR_EN;
+	while (stream->CR & DMA_SxCR_EN) {
+	}
+}
+
+static void i2c_dma_start(DMA_Stream_TypeDef *stream, uint32_t dir, const uint8_t *mem, uint16_t len)
+{
+	stream->PAR = (uint32_t)&I2C1->DR;
+	stream->M0AR = (uint32_t)mem;
+	stream->NDTR = len;
+	stream->FCR = 0;             // Direct mode
+	stream->CR = I2C_DMA_CHANNEL | dir | DMA_SxCR_MINC | DMA_SxCR_TCIE | DMA_SxCR_TEIE;
+	stream->CR |= DMA_SxCR_EN;
+}
+
+static void i2c_finish(BusXferStatus_t status)
+{
+	I2C1->CR2 &= ~(I2C_CR2_DMAEN | I2C_CR2_LAST | I2C_CR2_ITBUFEN);
+	i2c_xfer = NULL;
+	bus_complete(BUS_I2C1, status);
+}
+
+static void i2c_init(void)
+{
+	RCC->AHB1ENR |= RCC_AHB1ENR_GPIOBEN | RCC_AHB1ENR_DMA1EN;
+	RCC->APB1ENR |= RCC_APB1ENR_I2C1EN;
+	__DSB();
+
+	// PB8 SCL, PB9 SDA: AF4, open drain, pull-up (external 4.7k recommended)
+	GPIOB->MODER = (GPIOB->MODER & ~(GPIO_MODER_MODER8 | GPIO_MODER_MODER9)) |
+	               GPIO_MODER_MODER8_1 | GPIO_MODER_MODER9_1;
+	GPIOB->OTYPER |= GPIO_OTYPER_OT8 | GPIO_OTYPER_OT9;
+	GPIOB->PUPDR = (GPIOB->PUPDR & ~(GPIO_PUPDR_PUPD8 | GPIO_PUPDR_PUPD9)) |
+	               GPIO_PUPDR_PUPD8_0 | GPIO_PUPDR_PUPD9_0;
+	GPIOB->AFR[1] = (GPIOB->AFR[1] & ~(GPIO_AFRH_AFSEL8 | GPIO_AFRH_AFSEL9)) |
+	                (4U << GPIO_AFRH_AFSEL8_Pos) | (4U << GPIO_AFRH_AFSEL9_Pos);
+
+	uint32_t pclk1 = HAL_RCC_GetPCLK1Freq();
+	I2C1->CR1 = I2C_CR1_SWRST;
+	I2C1->CR1 = 0;
+	I2C1->CR2 = (pclk1 / 1000000U) | I2C_CR2_ITEVTEN | I2C_CR2_ITERREN;
+	I2C1->CCR = pclk1 / (2U * I2C_SPEED_HZ);        // Standard mode, 50% duty
+	I2C1->TRISE = pclk1 / 1000000U + 1U;            // 1000 ns max rise time
+	I2C1->CR1 = I2C_CR1_PE;
+
+	HAL_NVIC_SetPriority(I2C1_EV_IRQn, I2C_IRQ_PRIORITY, 0);
+	HAL_NVIC_EnableIRQ(I2C1_EV_IRQn);
+	HAL_NVIC_SetPriority(I2C1_ER_IRQn, I2C_IRQ_PRIORITY, 0);
+	HAL_NVIC_EnableIRQ(I2C1_ER_IRQn);
+	HAL_NVIC_SetPriority(DMA1_Stream6_IRQn, I2C_IRQ_PRIORITY, 0);
+	HAL_NVIC_EnableIRQ(DMA1_Stream6_IRQn);
+	HAL_NVIC_SetPriority(DMA1_Stream0_IRQn, I2C_IRQ_PRIORITY, 0);
+	HAL_NVIC_EnableIRQ(DMA1_Stream0_IRQn);
+}
+
+static void i2c_start(const BusXfer_t *xfer)
+{
+	i2c_xfer = xfer;
+	// An empty transfer is an address-only write, the usual probe
+	i2c_phase = (xfer->tx_len > 0 || xfer->rx_len == 0) ? I2C_PHASE_WRITE : I2C_PHASE_READ;
+	I2C1->CR1 |= I2C_CR1_ACK | I2C_CR1_START;
+}
+
+const BusBackend_t bus_i2c1_backend = { i2c_init, i2c_start };
+
+void bus_i2c1_ev_irq(void)
+{
+	const BusXfer_t *xfer = i2c_xfer;
+	uint32_t sr1 = I2C1->SR1;
+
+	if (xfer == NULL) {
+		(void)I2C1->SR2;
+		return;
+	}
+
+	if (sr1 & I2C_SR1_SB) {
+		// EV5: send the address, reading SR1 above plus this write clears SB
+		I2C1->DR = (uint8_t)((xfer->device << 1) | (i2c_phase == I2C_PHASE_READ ? 1U : 0U));
+	} else if (sr1 & I2C_SR1_ADDR) {
+		// EV6: arm the data phase before clearing ADDR releases the clock
+		if (i2c_phase == I2C_PHASE_WRITE && xfer->tx_len == 0) {
+			// Nothing to write: NDTR=0 would never complete, so stop here
+			(void)I2C1->SR2;
+			I2C1->CR1 |= I2C_CR1_STOP;
+			i2c_finish(BUS_XFER_OK);
+		} else if (i2c_phase == I2C_PHASE_WRITE) {
+			I2C1->CR2 |= I2C_CR2_DMAEN;
+			i2c_dma_start(I2C_DMA_TX, DMA_SxCR_DIR_0, xfer->tx, xfer->tx_len);
+			(void)I2C1->SR2;
+		} else if (xfer->rx_len == 1) {
+			// Single byte: NACK and STOP must be set before ADDR clears
+			I2C1->CR1 &= ~I2C_CR1_ACK;
+			(void)I2C1->SR2;
+			I2C1->CR1 |= I2C_CR1_STOP;
+			I2C1->CR2 |= I2C_CR2_ITBUFEN;
+		} else {
+			// LAST makes the peripheral NACK the final DMA byte on its own
+			I2C1->CR2 |= I2C_CR2_DMAEN | I2C_CR2_LAST;
+			i2c_dma_start(I2C_DMA_RX, 0, xfer->rx, xfer->rx_len);
+			(void)I2C1->SR2;
+		}
+	} else if ((sr1 & I2C_SR1_BTF) && i2c_phase == I2C_PHASE_WRITE && !(I2C1->CR2 & I2C_CR2_DMAEN)) {
+		// Last write byte is on the wire: turn around or stop
+		if (xfer->rx_len > 0) {
+			i2c_phase = I2C_PHASE_READ;
+			I2C1->CR1 |= I2C_CR1_START;
+		} else {
+			I2C1->CR1 |= I2C_CR1_STOP;
+			(void)I2C1->DR;  // Clears BTF
+			i2c_finish(BUS_XFER_OK);
+		}
+	} else if (sr1 & I2C_SR1_RXNE) {
+		xfer->rx[0] = (uint8_t)I2C1->DR;
+		i2c_finish(BUS_XFER_OK);
+	}
+}
+
+void bus_i2c1_er_irq(void)
+{
+	uint32_t sr1 = I2C1->SR1;
+
+	I2C1->SR1 = sr1 & ~I2C_SR1_ERRORS;
+	I2C1->CR1 |= I2C_CR1_STOP;
+	i2c_dma_stop(I2C_DMA_TX);
+	i2c_dma_stop(I2C_DMA_RX);
+	DMA1->HIFCR = I2C_DMA_TX_FLAGS;
+	DMA1->LIFCR = I2C_DMA_RX_FLAGS;
+
+	if (i2c_xfer != NULL) {
+		i2c_finish((sr1 & I2C_SR1_AF) ? BUS_XFER_NACK : BUS_XFER_ERROR);
+	}
+}
+
+void bus_i2c1_dma_tx_irq(void)
+{
+	uint32_t isr = DMA1->HISR;
+	DMA1->HIFCR = I2C_DMA_TX_FLAGS;
+
+	if (isr & DMA_HISR_TEIF6) {
+		I2C1->CR1 |= I2C_CR1_STOP;
+		i2c_finish(BUS_XFER_ERROR);
+	} else if (isr & DMA_HISR_TCIF6) {
+		// All bytes are in the shift path; BTF in the event handler finishes up
+		I2C1->CR2 &= ~I2C_CR2_DMAEN;
+	}
+}
+
+void bus_i2c1_dma_rx_irq(void)
+{
+	uint32_t isr = DMA1->LISR;
+	DMA1->LIFCR = I2C_DMA_RX_FLAGS;
+
+	if (isr & (DMA_LISR_TEIF0 | DMA_LISR_TCIF0)) {
+		I2C1->CR1 |= I2C_CR1_STOP;
+		i2c_finish((isr & DMA_LISR_TEIF0) ? BUS_XFER_ERROR : BUS_XFER_OK);
+	}
+}
@@ -0,0 +1,156 @@
+/*
+ * bus_spi.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+#include "bus.h"
+#include "main.h"
+
+// The HAL SPI driver is not part of this project, so SPI1 and its DMA2
+// streams are driven through their registers. PA5 (the usual SCK) drives
+// LD2, so SPI1 uses its PB3/PB4/PB5 remap. Stream0 belongs to the ADC, so RX
+// takes Stream2.
+//
+// A transfer runs in two DMA phases: the write phase clocks out tx[] and
+// discards what comes back, the read phase clocks out 0xFF and keeps rx[].
+// RX completion ends each phase, since it only fires once the last byte
+// has been shifted in.
+#define SPI_DMA_TX               DMA2_Stream3    // SPI1_TX, channel 3
+#define SPI_DMA_RX               DMA2_Stream2    // SPI1_RX, channel 3
+#define SPI_DMA_CHANNEL          (3U << DMA_SxCR_CHSEL_Pos)
+#define SPI_IRQ_PRIORITY         6               // Below configMAX_SYSCALL, may use FromISR APIs
+#define SPI_BAUD_DIV4            (1U << SPI_CR1_BR_Pos)   // PCLK2 / 4 = 4 MHz
+
+#define SPI_DMA_TX_FLAGS         (DMA_LIFCR_CTCIF3 | DMA_LIFCR_CHTIF3 | DMA_LIFCR_CTEIF3 | DMA_LIFCR_CDMEIF3 | DMA_LIFCR_CFEIF3)
+#define SPI_DMA_RX_FLAGS         (DMA_LIFCR_CTCIF2 | DMA_LIFCR_CHTIF2 | DMA_LIFCR_CTEIF2 | DMA_LIFCR_CDMEIF2 | DMA_LIFCR_CFEIF2)
+
+// Chip selects, indexed by BusXfer_t.device
+typedef struct {
+	GPIO_TypeDef *port;
+	uint32_t pin;
+} SpiChipSelect_t;
+
+static const SpiChipSelect_t spi_cs[] = {
+	{ GPIOB, 6 },
+};
+#define SPI_CS_COUNT             (sizeof(spi_cs) / sizeof(spi_cs[0]))
+
+static const BusXfer_t *spi_xfer;
+static bool spi_reading;
+static uint8_t spi_dummy;        // Fill byte out, discard byte in
+
+static void spi_select(const BusXfer_t *xfer, bool active)
+{
+	const SpiChipSelect_t *cs = &spi_cs[xfer->device];
+	cs->port->BSRR = active ? (1U << (cs->pin + 16U)) : (1U << cs->pin);
+}
+
+static void spi_dma_stop(DMA_Stream_TypeDef *stream)
+{
+	stream->CR &= ~DMA_SxCR_EN;
+	while (stream->CR & DMA_SxCR_EN) {
+	}
+}
+
+static void spi_dma_phase(const uint8_t *tx, uint8_t *rx, uint16_t len)
+{
+	DMA2->LIFCR = SPI_DMA_TX_FLAGS | SPI_DMA_RX_FLAGS;
+
+	// A NULL buffer means the dummy byte, without memory increment
+	SPI_DMA_RX->PAR = (uint32_t)&SPI1->DR;
+	SPI_DMA_RX->M0AR = (uint32_t)((rx != NULL) ? rx : &spi_dummy);
+	SPI_DMA_RX->NDTR = len;
+	SPI_DMA_RX->FCR = 0;
+	SPI_DMA_RX->CR = SPI_DMA_CHANNEL | DMA_SxCR_PL_1 | ((rx != NULL) ? DMA_SxCR_MINC : 0) |
+	                 DMA_SxCR_TCIE | DMA_SxCR_TEIE;
+
+	SPI_DMA_TX->PAR = (uint32_t)&SPI1->DR;
+	SPI_DMA_TX->M0AR = (uint32_t)((tx != NULL) ? tx : &spi_dummy);
+	SPI_DMA_TX->NDTR = len;
+	SPI_DMA_TX->FCR = 0;
+	SPI_DMA_TX->CR = SPI_DMA_CHANNEL | DMA_SxCR_DIR_0 | ((tx != NULL) ? DMA_SxCR_MINC : 0);
+
+	// RX first so no incoming byte is missed
+	SPI_DMA_RX->CR |= DMA_SxCR_EN;
+	SPI_DMA_TX->CR |= DMA_SxCR_EN;
+}
+
+static void spi_init(void)
+{
+	RCC->AHB1ENR |= RCC_AHB1ENR_GPIOBEN | RCC_AHB1ENR_DMA2EN;
+	RCC->APB2ENR |= RCC_APB2ENR_SPI1EN;
+	__DSB();
+
+	// PB3 SCK, PB4 MISO, PB5 MOSI on AF5, high speed
+	GPIOB->MODER = (GPIOB->MODER & ~(GPIO_MODER_MODER3 | GPIO_MODER_MODER4 | GPIO_MODER_MODER5)) |
+	               GPIO_MODER_MODER3_1 | GPIO_MODER_MODER4_1 | GPIO_MODER_MODER5_1;
+	GPIOB->OSPEEDR |= GPIO_OSPEEDR_OSPEED3 | GPIO_OSPEEDR_OSPEED4 | GPIO_OSPEEDR_OSPEED5;
+	GPIOB->AFR[0] = (GPIOB->AFR[0] & ~(GPIO_AFRL_AFSEL3 | GPIO_AFRL_AFSEL4 | GPIO_AFRL_AFSEL5)) |
+	                (5U << GPIO_AFRL_AFSEL3_Pos) | (5U << GPIO_AFRL_AFSEL4_Pos) | (5U << GPIO_AFRL_AFSEL5_Pos);
+
+	// Chip selects: push-pull outputs, idle high
+	for (uint32_t i = 0; i < SPI_CS_COUNT; i++) {
+		const SpiChipSelect_t *cs = &spi_cs[i];
+		cs->port->BSRR = 1U << cs->pin;
+		cs->port->MODER = (cs->port->MODER & ~(3U << (cs->pin * 2U))) | (1U << (cs->pin * 2U));
+	}
+
+	spi_dummy = 0xFF;
+
+	// Master, mode 0, 8-bit, software NSS
+	SPI1->CR1 = SPI_CR1_MSTR | SPI_CR1_SSM | SPI_CR1_SSI | SPI_BAUD_DIV4;
+	SPI1->CR2 = SPI_CR2_RXDMAEN | SPI_CR2_TXDMAEN;
+	SPI1->CR1 |= SPI_CR1_SPE;
+
+	HAL_NVIC_SetPriority(DMA2_Stream2_IRQn, SPI_IRQ_PRIORITY, 0);
+	HAL_NVIC_EnableIRQ(DMA2_Stream2_IRQn);
+}
+
+static void spi_start(const BusXfer_t *xfer)
+{
+	if (xfer->device >= SPI_CS_COUNT) {
+		bus_complete(BUS_SPI1, BUS_XFER_ERROR);
+		return;
+	}
+
+	spi_xfer = xfer;
+	spi_select(xfer, true);
+	if (xfer->tx_len > 0) {
+		spi_reading = false;
+		spi_dma_phase(xfer->tx, NULL, xfer->tx_len);
+	} else if (xfer->rx_len > 0) {
+		spi_reading = true;
+		spi_dma_phase(NULL, xfer->rx, xfer->rx_len);
+	} else {
+		spi_select(xfer, false);
+		spi_xfer = NULL;
+		bus_complete(BUS_SPI1, BUS_XFER_OK);
+	}
+}
+
+const BusBackend_t bus_spi1_backend = { spi_init, spi_start };
+
+void bus_spi1_dma_rx_irq(void)
+{
+	uint32_t isr = DMA2->LISR;
+	const BusXfer_t *xfer = spi_xfer;
+
+	DMA2->LIFCR = SPI_DMA_RX_FLAGS;
+	if (xfer == NULL || !(isr & (DMA_LISR_TCIF2 | DMA_LISR_TEIF2))) {
+		return;
+	}
+
+	if (isr & DMA_LISR_TEIF2) {
+		spi_dma_stop(SPI_DMA_TX);
+	} else if (!spi_reading && xfer->rx_len > 0) {
+		spi_reading = true;
+		spi_dma_phase(NULL, xfer->rx, xfer->rx_len);
+		return;
+	}
+
+	// RX done implies TX done and the bus idle; release CS and move on
+	spi_select(xfer, false);
+	spi_xfer = NULL;
+	bus_complete(BUS_SPI1, (isr & DMA_LISR_TEIF2) ? BUS_XFER_ERROR : BUS_XFER_OK);
+}
@@ -0,0 +1,315 @@
+/*
+ * calib.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+#include "calib.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "kv_store.h"
+#include "cli_registry.h"
+#include "uart_logger.h"
+#include <stdio.h>
+#include <string.h>
+
+// Datasheet typicals for the internal temperature sensor, for a count
+// already scaled to the 3.3 V the VREFINT calibration was taken at
+#define TEMP_V25                 0.76f
+#define TEMP_AVG_SLOPE           0.0025f
+#define CALIB_REF_VDDA           3.3f
+
+#define CALIB_Q16_MAX            32767.0f    // Largest magnitude a Q16.16 entry holds
+
+_Static_assert(sizeof(CalibSpec_t) <= KV_MAX_VALUE_LEN, "a spec fits one settings value");
+
+static const char *const channel_names[CALIB_CHANNELS] = {
+	[ADC_CH_PA0]  = "pa0",
+	[ADC_CH_PA1]  = "pa1",
+	[ADC_CH_TEMP] = "temp",
+};
+
+static CalibLut_t luts[CALIB_CHANNELS];
+static CalibSpec_t specs[CALIB_CHANNELS];
+static CalibLut_t scratch;                   // Built here, then copied in one critical section
+
+static CalibSpec_t default_spec(AdcChannel_t channel)
+{
+	CalibSpec_t spec = { .version = CALIB_SPEC_VERSION, .kind = CALIB_POLY, .count = 2 };
+
+	if (channel == ADC_CH_TEMP) {
+		float volts_per_count = CALIB_REF_VDDA / (float)CALIB_MAX_RAW;
+		spec.y[0] = 25.0f - TEMP_V25 / TEMP_AVG_SLOPE;
+		spec.y[1] = volts_per_count / TEMP_AVG_SLOPE;
+	} else {
+		// External inputs read as percent of full scale
+		spec.y[0] = 0.0f;
+		spec.y[1] = 100.0f / (float)CALIB_MAX_RAW;
+	}
+	return spec;
+}
+
+bool calib_spec_valid(const CalibSpec_t *spec)
+{
+	if (spec == NULL || spec->version != CALIB_SPEC_VERSION) {
+		return false;
+	}
+	if (spec->kind == CALIB_POLY) {
+		return spec->count >= 1 && spec->count <= CALIB_POLY_TERMS;
+	}
+	if (spec->kind != CALIB_POINTS || spec->count < 2 || spec->count > CALIB_MAX_POINTS) {
+		return false;
+	}
+	for (uint32_t i = 1; i < spec->count; i++) {
+		if (!(spec->x[i] > spec->x[i - 1])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+float calib_spec_eval(const CalibSpec_t *spec, float raw)
+{
+	if (spec->kind == CALIB_POLY) {
+		float y = 0.0f;
+		for (int32_t t = (int32_t)spec->count - 1; t >= 0; t--) {
+			y = y * raw + spec->y[t];
+		}
+		return y;
+	}
+
+	if (raw <= spec->x[0]) {
+		return spec->y[0];
+	}
+	for (uint32_t i = 1; i < spec->count; i++) {
+		if (raw <= spec->x[i]) {
+			float t = (raw - spec->x[i - 1]) / (spec->x[i] - spec->x[i - 1]);
+			return spec->y[i - 1] + t * (spec->y[i] - spec->y[i - 1]);
+		}
+	}
+	return spec->y[spec->count - 1];
+}
+
+bool calib_build_lut(const CalibSpec_t *spec, CalibLut_t *lut)
+{
+	if (!calib_spec_valid(spec)) {
+		return false;
+	}
+
+	for (uint32_t i = 0; i < CALIB_LUT_ENTRIES; i++) {
+		float y;
+		if (i < CALIB_LUT_ENTRIES - 1) {
+			y = calib_spec_eval(spec, (float)(i << CALIB_SEGMENT_BITS));
+		} else {
+			// The last entry sits one count past the input range; place it
+			// so the top segment passes exactly through f(CALIB_MAX_RAW)
+			float below = calib_spec_eval(spec, (float)(CALIB_MAX_RAW + 1 - CALIB_SEGMENT_COUNTS));
+			float top = calib_spec_eval(spec, (float)CALIB_MAX_RAW);
+			y = below + (top - below) * (float)CALIB_SEGMENT_COUNTS / (float)(CALIB_SEGMENT_COUNTS - 1);
+		}
+		if (!(y > -CALIB_Q16_MAX && y < CALIB_Q16_MAX)) {
+			return false;
+		}
+		float scaled = y * (float)CALIB_Q16_ONE;
+		lut->q16[i] = (int32_t)(scaled + ((scaled >= 0.0f) ? 0.5f : -0.5f));
+	}
+	return true;
+}
+
+bool calib_load(AdcChannel_t channel, const CalibSpec_t *spec)
+{
+	if (channel >= CALIB_CHANNELS || !calib_build_lut(spec, &scratch)) {
+		return false;
+	}
+
+	taskENTER_CRITICAL();
+	luts[channel] = scratch;
+	specs[channel] = *spec;
+	taskEXIT_CRITICAL();
+	return true;
+}
+
+void calib_load_default(AdcChannel_t channel)
+{
+	CalibSpec_t spec = default_spec(channel);
+	calib_load(channel, &spec);
+}
+
+void calib_init(void)
+{
+	for (uint32_t ch = 0; ch < CALIB_CHANNELS; ch++) {
+		calib_load_default((AdcChannel_t)ch);
+	}
+}
+
+// Saved specs are keyed "calib.<channel>" and stored as the raw struct;
+// its version byte rejects a layout from other firmware
+static void calib_key(AdcChannel_t channel, char *key, uint32_t size)
+{
+	snprintf(key, size, "calib.%s", calib_name(channel));
+}
+
+void calib_load_settings(void)
+{
+	char key[KV_MAX_KEY_LEN + 1];
+
+	for (uint32_t ch = 0; ch < CALIB_CHANNELS; ch++) {
+		CalibSpec_t spec;
+		KvType_t type;
+
+		calib_key((AdcChannel_t)ch, key, sizeof(key));
+		int32_t len = kv_get(key, &type, &spec, sizeof(spec));
+		if (len < 0) {
+			continue;
+		}
+		if (len != (int32_t)sizeof(spec) || type != KV_TYPE_BYTES || !calib_load((AdcChannel_t)ch, &spec)) {
+			log_printf("Saved calibration for %s rejected, using the default\r\n", calib_name((AdcChannel_t)ch));
+		}
+	}
+}
+
+bool calib_get_spec(AdcChannel_t channel, CalibSpec_t *spec)
+{
+	if (channel >= CALIB_CHANNELS || spec == NULL) {
+		return false;
+	}
+
+	taskENTER_CRITICAL();
+	*spec = specs[channel];
+	taskEXIT_CRITICAL();
+	return true;
+}
+
+// A table swap is a 65-word copy under a critical section, so a reader
+// never sees half of one; readers themselves need no lock
+int32_t calib_convert_q16(AdcChannel_t channel, uint32_t raw)
+{
+	return calib_lut_q16(&luts[channel], raw);
+}
+
+float calib_convert(AdcChannel_t channel, uint32_t raw)
+{
+	return calib_q16_to_float(calib_lut_q16(&luts[channel], raw));
+}
+
+int calib_find(const char *name)
+{
+	for (uint32_t n = 0; n < CALIB_CHANNELS; n++) {
+		if (strcmp(name, channel_names[n]) == 0) {
+			return (int)n;
+		}
+	}
+	return -1;
+}
+
+const char *calib_name(AdcChannel_t channel)
+{
+	return (channel < CALIB_CHANNELS) ? channel_names[channel] : "?";
+}
+
+static void calib_show(AdcChannel_t channel)
+{
+	CalibSpec_t spec;
+	calib_get_spec(channel, &spec);
+
+	if (spec.kind == CALIB_POLY) {
+		log_printf("%-5s poly  ", calib_name(channel));
+		for (uint32_t t = 0; t < spec.count; t++) {
+			log_printf(" c%lu=%.6g", t, spec.y[t]);
+		}
+	} else {
+		log_printf("%-5s points", calib_name(channel));
+		for (uint32_t i = 0; i < spec.count; i++) {
+			log_printf(" (%.0f, %.3f)", spec.x[i], spec.y[i]);
+		}
+	}
+	log_printf("\r\n      0 -> %.3f, %u -> %.3f, %u -> %.3f\r\n", calib_convert(channel, 0),
+	           CALIB_MAX_RAW / 2 + 1, calib_convert(channel, CALIB_MAX_RAW / 2 + 1),
+	           CALIB_MAX_RAW, calib_convert(channel, CALIB_MAX_RAW));
+}
+
+// Breakpoints are kept sorted; one at an existing raw count replaces it
+static bool spec_add_point(CalibSpec_t *spec, float raw, float value)
+{
+	uint32_t i = 0;
+
+	while (i < spec->count && spec->x[i] < raw) {
+		i++;
+	}
+	if (i < spec->count && spec->x[i] == raw) {
+		spec->y[i] = value;
+		return true;
+	}
+	if (spec->count >= CALIB_MAX_POINTS) {
+		return false;
+	}
+	memmove(&spec->x[i + 1], &spec->x[i], (spec->count - i) * sizeof(float));
+	memmove(&spec->y[i + 1], &spec->y[i], (spec->count - i) * sizeof(float));
+	spec->x[i] = raw;
+	spec->y[i] = value;
+	spec->count++;
+	return true;
+}
+
+// Breakpoints being entered, applied once there are two
+static CalibSpec_t pending[CALIB_CHANNELS];
+
+// calib | calib <ch> poly <c0> [c1] [c2] [c3] | calib <ch> point <raw> <value> | calib <ch> default
+CLI_COMMAND(calib, "|ssffff", "[<pa0|pa1|temp> poly <c0..c3> | point <raw> <value> | default]",
+            "Show or set raw-to-units calibration tables")
+{
+	if (args->count == 0) {
+		for (uint32_t ch = 0; ch < CALIB_CHANNELS; ch++) {
+			calib_show((AdcChannel_t)ch);
+		}
+		return;
+	}
+
+	int ch = calib_find(args->v[0].s);
+	const char *op = (args->count > 1) ? args->v[1].s : "";
+	bool ok = false;
+
+	if (ch >= 0 && strcmp(op, "default") == 0) {
+		calib_load_default((AdcChannel_t)ch);
+		pending[ch].count = 0;
+		ok = true;
+	} else if (ch >= 0 && strcmp(op, "poly") == 0 && args->count >= 3) {
+		CalibSpec_t spec = { .version = CALIB_SPEC_VERSION, .kind = CALIB_POLY, .count = (uint8_t)(args->count - 2) };
+		for (uint32_t t = 0; t < spec.count; t++) {
+			spec.y[t] = args->v[2 + t].f;
+		}
+		ok = calib_load((AdcChannel_t)ch, &spec);
+		if (ok) {
+			pending[ch].count = 0;
+		}
+	} else if (ch >= 0 && strcmp(op, "point") == 0 && args->count == 4) {
+		CalibSpec_t *spec = &pending[ch];
+		spec->version = CALIB_SPEC_VERSION;
+		spec->kind = CALIB_POINTS;
+		ok = spec_add_point(spec, args->v[2].f, args->v[3].f);
+		if (ok && spec->count < 2) {
+			log_printf("%s: 1 point entered, need 2 to apply\r\n", args->v[0].s);
+			return;
+		}
+		ok = ok && calib_load((AdcChannel_t)ch, spec);
+	} else {
+		log_printf("Usage: calib [<pa0|pa1|temp> poly <c0> [c1] [c2] [c3] | point <raw> <value> | default]\r\n");
+		return;
+	}
+
+	if (!ok) {
+		log_printf("Calibration rejected: bad points or values beyond +/-32767\r\n");
+		return;
+	}
+	calib_show((AdcChannel_t)ch);
+
+	// The default is not stored, so a later change of it still applies
+	char key[KV_MAX_KEY_LEN + 1];
+	CalibSpec_t spec;
+	calib_key((AdcChannel_t)ch, key, sizeof(key));
+	calib_get_spec((AdcChannel_t)ch, &spec);
+	bool saved = (strcmp(op, "default") == 0) ? kv_delete(key) : kv_set(key, KV_TYPE_BYTES, &spec, sizeof(spec));
+	if (!saved) {
+		log_printf("(not saved)\r\n");
+	}
+}
@@ -0,0 +1,99 @@
+/*
+ * calib.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+
+#ifndef CALIB_H_
+#define CALIB_H_
+
+#include "adc_acq.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Raw ADC count to engineering units through a per-channel lookup table.
+// A calibration is described either by breakpoints or by a polynomial in
+// the raw count (CalibSpec_t, also the blob the settings store keeps as
+// "calib.<channel>"). Loading
+// one evaluates it in float once, at every CALIB_SEGMENT_COUNTS-th count,
+// into a Q16.16 table; converting a sample is then a shift, two loads and
+// one multiply-accumulate, with no float math and no branches.
+//
+// The table is linear between entries, so a breakpoint that does not fall
+// on a multiple of 64 counts has its corner rounded off, and strong
+// curvature inside one segment is flattened. calibbench reports the worst
+// deviation from the float evaluation: well under 0.01 units for the
+// default and cubic curves, about 0.2 for its eight-breakpoint curve.
+
+#define CALIB_INPUT_BITS         12
+#define CALIB_SEGMENT_BITS       6
+#define CALIB_SEGMENT_COUNTS     (1U << CALIB_SEGMENT_BITS)
+#define CALIB_LUT_ENTRIES        ((1U << (CALIB_INPUT_BITS - CALIB_SEGMENT_BITS)) + 1)
+#define CALIB_MAX_RAW            ((1U << CALIB_INPUT_BITS) - 1)
+#define CALIB_MAX_POINTS         8
+#define CALIB_POLY_TERMS         4       // Up to cubic
+#define CALIB_Q16_ONE            65536
+
+// Calibrated channels are the external inputs and the temperature sensor
+#define CALIB_CHANNELS           ADC_CH_VREFINT
+
+typedef enum {
+	CALIB_POINTS = 0,            // Piecewise linear through (x[i], y[i]), x ascending; clamped outside
+	CALIB_POLY,                  // y = c0 + c1 x + c2 x^2 + c3 x^3, coefficients in y[0..count-1]
+} CalibKind_t;
+
+typedef struct {
+	uint8_t version;             // CALIB_SPEC_VERSION
+	uint8_t kind;                // CalibKind_t
+	uint8_t count;               // Breakpoints, or polynomial terms
+	uint8_t reserved;
+	float x[CALIB_MAX_POINTS];   // Raw counts, breakpoints only
+	float y[CALIB_MAX_POINTS];
+} CalibSpec_t;
+
+#define CALIB_SPEC_VERSION       1
+
+typedef struct {
+	int32_t q16[CALIB_LUT_ENTRIES];
+} CalibLut_t;
+
+// Table lookup, usable from any context. 'raw' above the 12-bit range is clamped.
+static inline int32_t calib_lut_q16(const CalibLut_t *lut, uint32_t raw)
+{
+	raw = (raw > CALIB_MAX_RAW) ? CALIB_MAX_RAW : raw;
+	uint32_t i = raw >> CALIB_SEGMENT_BITS;
+	int32_t frac = (int32_t)(raw & (CALIB_SEGMENT_COUNTS - 1));
+	int32_t y0 = lut->q16[i];
+	int32_t y1 = lut->q16[i + 1];
+
+	return y0 + (int32_t)(((int64_t)(y1 - y0) * frac) >> CALIB_SEGMENT_BITS);
+}
+
+static inline float calib_q16_to_float(int32_t q16)
+{
+	return (float)q16 * (1.0f / CALIB_Q16_ONE);
+}
+
+// Float evaluation of a spec, used to build tables and as the benchmark baseline
+float calib_spec_eval(const CalibSpec_t *spec, float raw);
+bool calib_spec_valid(const CalibSpec_t *spec);
+bool calib_build_lut(const CalibSpec_t *spec, CalibLut_t *lut);
+
+void calib_init(void);
+// Replaces the defaults with calibrations saved by 'calib'; call after kv_init()
+void calib_load_settings(void);
+
+// Replaces a channel's calibration; false if the spec is invalid or its
+// values do not fit Q16.16
+bool calib_load(AdcChannel_t channel, const CalibSpec_t *spec);
+void calib_load_default(AdcChannel_t channel);
+bool calib_get_spec(AdcChannel_t channel, CalibSpec_t *spec);
+
+int32_t calib_convert_q16(AdcChannel_t channel, uint32_t raw);
+float calib_convert(AdcChannel_t channel, uint32_t raw);
+
+int calib_find(const char *name);
+const char *calib_name(AdcChannel_t channel);
+
+#endif /* CALIB_H_ */
@@ -0,0 +1,139 @@
+/*
+ * calib_bench.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+#include "calib.h"
+#include "cli_registry.h"
+#include "job_worker.h"
+#include "cycle_counter.h"
+#include "uart_logger.h"
+#include <math.h>
+#include <string.h>
+
+#define CALIB_BENCH_SAMPLES     256
+#define CALIB_BENCH_RUNS        5       // Best of N, to filter out preemption
+
+typedef enum {
+	SPEC_POLY3,                  // Cubic, like a linearised thermistor
+	SPEC_POINTS8,                // Eight measured breakpoints
+	SPEC_COUNT
+} BenchSpecId_t;
+
+static const char *const spec_names[SPEC_COUNT] = { "cubic", "8 points" };
+
+static CalibSpec_t bench_specs[SPEC_COUNT] = {
+	[SPEC_POLY3] = { .version = CALIB_SPEC_VERSION, .kind = CALIB_POLY, .count = 4,
+	                 .y = { -40.0f, 0.05f, -4.0e-6f, 4.0e-10f } },
+	[SPEC_POINTS8] = { .version = CALIB_SPEC_VERSION, .kind = CALIB_POINTS, .count = 8,
+	                   .x = { 0.0f, 300.0f, 800.0f, 1500.0f, 2200.0f, 2900.0f, 3600.0f, 4095.0f },
+	                   .y = { -20.0f, -5.0f, 12.0f, 31.0f, 47.5f, 61.0f, 78.0f, 95.0f } },
+};
+
+static uint16_t raw_in[CALIB_BENCH_SAMPLES];
+static float out_f32[CALIB_BENCH_SAMPLES];
+static int32_t out_q16[CALIB_BENCH_SAMPLES];
+static CalibLut_t bench_lut;
+
+// Spread over the whole input range with LCG jitter, so every segment is hit
+static void bench_fill_input(void)
+{
+	uint32_t lcg = 12345;
+
+	for (uint32_t k = 0; k < CALIB_BENCH_SAMPLES; k++) {
+		lcg = lcg * 1664525u + 1013904223u;
+		raw_in[k] = (uint16_t)((k * 16 + (lcg >> 28)) & CALIB_MAX_RAW);
+	}
+}
+
+typedef enum {
+	PATH_FLOAT,                  // calib_spec_eval() per sample
+	PATH_LUT_Q16,                // Table lookup, fixed-point out
+	PATH_LUT_F32,                // Table lookup, converted to float
+	PATH_COUNT
+} BenchPathId_t;
+
+static const char *const path_names[PATH_COUNT] = { "float eval", "LUT Q16.16", "LUT -> float" };
+
+static void bench_run_once(const CalibSpec_t *spec, BenchPathId_t path)
+{
+	switch (path) {
+		case PATH_FLOAT:
+			for (uint32_t k = 0; k < CALIB_BENCH_SAMPLES; k++) {
+				out_f32[k] = calib_spec_eval(spec, (float)raw_in[k]);
+			}
+			break;
+		case PATH_LUT_Q16:
+			for (uint32_t k = 0; k < CALIB_BENCH_SAMPLES; k++) {
+				out_q16[k] = calib_lut_q16(&bench_lut, raw_in[k]);
+			}
+			break;
+		case PATH_LUT_F32:
+			for (uint32_t k = 0; k < CALIB_BENCH_SAMPLES; k++) {
+				out_f32[k] = calib_q16_to_float(calib_lut_q16(&bench_lut, raw_in[k]));
+			}
+			break;
+		default:
+			break;
+	}
+}
+
+// Worst deviation of the table from the float evaluation over every input
+static float bench_max_error(const CalibSpec_t *spec)
+{
+	float worst = 0.0f;
+
+	for (uint32_t raw = 0; raw <= CALIB_MAX_RAW; raw++) {
+		float err = fabsf(calib_q16_to_float(calib_lut_q16(&bench_lut, raw)) - calib_spec_eval(spec, (float)raw));
+		if (err > worst) {
+			worst = err;
+		}
+	}
+	return worst;
+}
+
+static bool calibbench_job(Job_t *job, void *arg)
+{
+	bench_fill_input();
+
+	for (uint32_t s = 0; s < SPEC_COUNT; s++) {
+		const CalibSpec_t *spec = &bench_specs[s];
+		calib_build_lut(spec, &bench_lut);
+
+		for (uint32_t path = 0; path < PATH_COUNT; path++) {
+			uint32_t best = UINT32_MAX;
+
+			for (uint32_t run = 0; run < CALIB_BENCH_RUNS; run++) {
+				if (job_cancel_requested(job)) {
+					return false;
+				}
+				uint32_t start = cycle_counter_now();
+				bench_run_once(spec, (BenchPathId_t)path);
+				uint32_t cycles = cycle_counter_now() - start;
+				if (cycles < best) {
+					best = cycles;
+				}
+			}
+
+			// Tenths of a cycle per sample, in integer math
+			uint32_t per_sample_x10 = (best * 10) / CALIB_BENCH_SAMPLES;
+			log_printf("%-9s %-13s %6lu cycles/block  %4lu.%lu cycles/sample\r\n", spec_names[s],
+			           path_names[path], best, per_sample_x10 / 10, per_sample_x10 % 10);
+		}
+		log_printf("%-9s max table error %.4f over all %u inputs\r\n", spec_names[s],
+		           bench_max_error(spec), CALIB_MAX_RAW + 1);
+		job_set_progress(job, s + 1, SPEC_COUNT);
+	}
+	return true;
+}
+
+CLI_COMMAND(calibbench, "", "", "Benchmark calibration tables against float evaluation")
+{
+	uint32_t id = job_submit("calibbench", calibbench_job, NULL);
+	if (id != 0) {
+		log_printf("Job %lu started: calibbench (%u samples per block)\r\n", id, CALIB_BENCH_SAMPLES);
+	} else {
+		log_printf("Job queue full, try again later\r\n");
+	}
+}
@@ -12,16 +12,24 @@
 #include "app_tasks.h"
 #include "boot_metadata.h"
 #include "ota.h"
+#include "crc32.h"
+#include "msg_pool.h"
+#include "periodic_jobs.h"
+#include "job_worker.h"
+#include "cli_registry.h"
+#include "sensor_snapshot.h"
+#include "FreeRTOS.h"
 
 
-#define LOG_QUEUE_LEN    10
 #define LOG_MSG_LEN      100
-
-static char log_pool[LOG_QUEUE_LEN][LOG_MSG_LEN];
-static uint8_t log_write_index = 0;
+#define CRC_JOB_BLOCK_WORDS  1024   // 4 KB of flash between progress/cancel checks
 
 void log_enqueue_fmt(const char *fmt, ...) {
-	char msg[LOG_MSG_LEN];
+	char *msg = msg_pool_alloc(LOG_MSG_LEN, 0);
+	if (msg == NULL) {
+		return; // Pool exhausted, drop the line rather than block the caller
+	}
+
 	va_list args;
 	va_start(args, fmt);
 	vsnprintf(msg, LOG_MSG_LEN, fmt, args);
@@ -30,18 +38,89 @@ void log_enqueue_fmt(const char *fmt, ...) {
 	osStatus_t status = osMessageQueuePut(loggerQueue, &msg, 0, 100); // 100ms timeout
     if (status == osErrorTimeout) {
         // Queue full, try to clear it by getting one message and discarding
-        char dummy[LOG_MSG_LEN];
-        osMessageQueueGet(loggerQueue, &dummy, NULL, 0);
+        char *dummy;
+        if (osMessageQueueGet(loggerQueue, &dummy, NULL, 0) == osOK) {
+            msg_pool_free(dummy);
+        }
         // Try again
-        osMessageQueuePut(loggerQueue, &msg, 0, 0);
-    } else if (status != osOK) {
+        status = osMessageQueuePut(loggerQueue, &msg, 0, 0);
+    }
+    if (status != osOK) {
         // Silent failure to prevent recursive logging
+        msg_pool_free(msg);
     }
 }
 
 
 static uint32_t command_count = 0;
 
+// Runs on the job worker: CRC of the active slot in resumable blocks
+static bool crc_job(Job_t *job, void *arg)
+{
+	uint32_t current_slot_addr = (boot_metadata->active_slot == SLOT_A) ? SLOT_A_ADDRESS : SLOT_B_ADDRESS;
+	uint32_t image_size = (boot_metadata->image_size > 0) ? boot_metadata->image_size : (192 * 1024);
+	uint32_t size_words = (image_size + 3) / 4;
+	const uint32_t *flash_ptr = (const uint32_t *)current_slot_addr;
+	Crc32Ctx_t ctx;
+
+	log_printf("Calculating CRC for active slot (%s)...\r\n", 
+	           (boot_metadata->active_slot == SLOT_A) ? "SLOT_A" : "SLOT_B");
+
+	crc32_begin(&ctx, crc32_get_backend());
+	for (uint32_t done = 0; done < size_words; ) {
+		if (job_cancel_requested(job)) {
+			crc32_end(&ctx);
+			return false;
+		}
+		uint32_t block = size_words - done;
+		if (block > CRC_JOB_BLOCK_WORDS) {
+			block = CRC_JOB_BLOCK_WORDS;
+		}
+		crc32_feed(&ctx, flash_ptr + done, block);
+		done += block;
+		job_set_progress(job, done, size_words);
+	}
+
+	uint32_t calculated_crc = crc32_end(&ctx);
+	log_printf("Flash CRC32: 0x%08X (%s)\r\n", (unsigned int)calculated_crc, crc32_backend_name(ctx.backend));
+	log_printf("Expected CRC: 0x%08X\r\n", (unsigned int)boot_metadata->crc);
+	
+	if (boot_metadata->crc != 0xFFFFFFFF) {
+		if (calculated_crc == boot_metadata->crc) {
+			log_printf("CRC verification: PASS\r\n");
+		} else {
+			log_printf("CRC verification: FAIL\r\n");
+			return false;
+		}
+	} else {
+		log_printf("CRC verification: SKIPPED (no expected CRC)\r\n");
+	}
+	return true;
+}
+
+// Runs on the job worker: the append erases the metadata sector when the journal is full
+static bool initmetadata_job(Job_t *job, void *arg)
+{
+	log_printf("Initializing metadata...\r\n");
+	HAL_StatusTypeDef status = initialize_metadata();
+	if (status == HAL_OK) {
+		log_printf("Metadata initialized successfully\r\n");
+		return true;
+	}
+	log_printf("Metadata initialization failed: %d\r\n", status);
+	return false;
+}
+
+static void submit_job(const char *name, JobFunc_t func)
+{
+	uint32_t id = job_submit(name, func, NULL);
+	if (id != 0) {
+		log_printf("Job %lu started: %s (use 'bg' for progress, 'cancel %lu' to stop)\r\n", id, name, id);
+	} else {
+		log_printf("Job queue full, try again later\r\n");
+	}
+}
+
 void handle_command(const char *cmd){
 	// Check string validity
 	if (cmd == NULL) {
@@ -49,126 +128,168 @@ void handle_command(const char *cmd){
 		return;
 	}
 	
-	if(strcmp(cmd, "version") == 0){
-		log_printf("Firmware v1.0.2\r\n");
-	}
-	else if(strcmp(cmd, "reboot") == 0){
-		log_printf("Rebooting...\r\n");
-	}
-	else if(strncmp(cmd, "otastart ", 9) == 0){
-		// Parse firmware size: "otastart 12345"
-		uint32_t firmware_size = 0;
-		if (sscanf(cmd + 9, "%lu", &firmware_size) == 1 && firmware_size > 0) {
-			if (otaQueue == NULL) {
-				log_printf("ERROR: otaQueue is NULL!\r\n");
-				return;
-			}
-			
-			// Set expected size for OTA transfer
-			ota_expected_size = firmware_size;
-			ota_received_size = 0;
-			
-			OTAMessage_t otaMsg = {0};
-			otaMsg.command = OTA_CMD_START;
-			
-			osStatus_t status = osMessageQueuePut(otaQueue, &otaMsg, 0, 100);
-			
-			if (status != osOK) {
-				log_printf("Failed to send OTA start, error: %d\r\n", status);
-			} else {
-				log_printf("OTA started, expecting %lu bytes\r\n", firmware_size);
-				log_printf("Ready to receive firmware binary data...\r\n");
-				
-				// Wait for OTA task to complete initialization and set state
-				osDelay(100); // Give OTA task time to erase and set state
-				
-				// Wait for clean state transition
-				osDelay(50); // Allow any pending UART data to arrive and be cleared
-			}
-		} else {
-			log_printf("Usage: otastart <firmware_size_bytes>\r\n");
-			log_printf("Example: otastart 49152\r\n");
-		}
+	cli_dispatch(cmd);
+}
+
+CLI_COMMAND(help, "", "", "List available commands")
+{
+	for (uint32_t c = 0; c < cli_command_count(); c++) {
+		const CliCommand_t *entry = cli_command_at(c);
+		log_printf("%-16s %s\r\n", entry->name, entry->help);
 	}
-	else if(strcmp(cmd, "otastatus") == 0){
-		const char* state_str = "UNKNOWN";
-		switch(ota_state) {
-			case OTA_STATE_IDLE: state_str = "IDLE"; break;
-			case OTA_STATE_RECEIVING: state_str = "RECEIVING"; break;
-			case OTA_STATE_COMPLETE: state_str = "COMPLETE"; break;
-		}
-		log_printf("OTA State: %s\r\n", state_str);
-		log_printf("Expected: %lu bytes, Received: %lu bytes\r\n", ota_expected_size, ota_received_size);
-		if (ota_expected_size > 0) {
-			uint32_t progress = (ota_received_size * 100) / ota_expected_size;
-			log_printf("Progress: %lu%%\r\n", progress);
-		}
+}
+
+CLI_COMMAND(version, "", "", "Show firmware version")
+{
+	log_printf("Firmware v1.0.2\r\n");
+}
+
+CLI_COMMAND(reboot, "", "", "Restart the device")
+{
+	log_printf("Rebooting...\r\n");
+}
+
+CLI_COMMAND(otastart, "u", "<firmware_size_bytes>", "Start OTA with expected file size")
+{
+	uint32_t firmware_size = args->v[0].u;
+	if (firmware_size == 0) {
+		log_printf("Usage: otastart <firmware_size_bytes>\r\n");
+		log_printf("Example: otastart 49152\r\n");
+		return;
 	}
-	else if(strcmp(cmd, "otafinish") == 0){
-		OTAMessage_t otaMsg = {0};
-		otaMsg.command = OTA_CMD_FINISH;
-		
-		if (osMessageQueuePut(otaQueue, &otaMsg, 0, 0) == osOK) {
-			log_printf("OTA finish command sent\r\n");
-		} else {
-			log_printf("Failed to send OTA finish command\r\n");
-		}
+	if (OTATaskHandle == NULL) {
+		log_printf("ERROR: OTATask is not running!\r\n");
+		return;
 	}
-	else if(strcmp(cmd, "crc") == 0){
-		// Calculate and display CRC of current active slot
-		uint32_t current_slot_addr = (boot_metadata->active_slot == SLOT_A) ? SLOT_A_ADDRESS : SLOT_B_ADDRESS;
-		uint32_t image_size = (boot_metadata->image_size > 0) ? boot_metadata->image_size : (192 * 1024);
-		
-		log_printf("Calculating CRC for active slot (%s)...\r\n", 
-		           (boot_metadata->active_slot == SLOT_A) ? "SLOT_A" : "SLOT_B");
-		
-		uint32_t calculated_crc = calculate_flash_crc_ota(current_slot_addr, image_size);
-		
-		log_printf("Flash CRC32: 0x%08X\r\n", (unsigned int)calculated_crc);
-		log_printf("Expected CRC: 0x%08X\r\n", (unsigned int)boot_metadata->crc);
-		
-		if (boot_metadata->crc != 0xFFFFFFFF) {
-			if (calculated_crc == boot_metadata->crc) {
-				log_printf("CRC verification: PASS\r\n");
-			} else {
-				log_printf("CRC verification: FAIL\r\n");
-			}
-		} else {
-			log_printf("CRC verification: SKIPPED (no expected CRC)\r\n");
-		}
+	
+	// Set expected size for OTA transfer
+	ota_expected_size = firmware_size;
+	ota_received_size = 0;
+	
+	uint32_t flags = osThreadFlagsSet(OTATaskHandle, OTA_FLAG_START);
+	
+	if (flags & osFlagsError) {
+		log_printf("Failed to send OTA start, error: %d\r\n", (int)flags);
+	} else {
+		// OTATask erases the slot and switches to RECEIVING on its own;
+		// CLITask keeps draining input meanwhile
+		log_printf("OTA started, expecting %lu bytes\r\n", firmware_size);
+		log_printf("Ready to receive firmware binary data...\r\n");
 	}
-	else if(strcmp(cmd, "initmetadata") == 0){
-		log_printf("Initializing metadata...\r\n");
-		HAL_StatusTypeDef status = initialize_metadata();
-		if (status == HAL_OK) {
-			log_printf("Metadata initialized successfully\r\n");
-		} else {
-			log_printf("Metadata initialization failed: %d\r\n", status);
-		}
+}
+
+CLI_COMMAND(otastatus, "", "", "Check OTA progress and current state")
+{
+	const char* state_str = "UNKNOWN";
+	switch(ota_state) {
+		case OTA_STATE_IDLE: state_str = "IDLE"; break;
+		case OTA_STATE_RECEIVING: state_str = "RECEIVING"; break;
+		case OTA_STATE_COMPLETE: state_str = "COMPLETE"; break;
 	}
-	else if(strcmp(cmd, "clearprotection") == 0){
-		log_printf("Clearing flash protection...\r\n");
-		HAL_StatusTypeDef status = clear_flash_protection();
-		if (status == HAL_OK) {
-			log_printf("Flash protection cleared successfully\r\n");
-			log_printf("Please reset the device for changes to take effect\r\n");
-		} else {
-			log_printf("Flash protection clear failed: %d\r\n", status);
-		}
+	log_printf("OTA State: %s\r\n", state_str);
+	log_printf("Expected: %lu bytes, Received: %lu bytes\r\n", ota_expected_size, ota_received_size);
+	if (ota_expected_size > 0) {
+		uint32_t progress = (ota_received_size * 100) / ota_expected_size;
+		log_printf("Progress: %lu%%\r\n", progress);
+	}
+	if (ota_handoff_stats.chunks > 0) {
+		log_printf("Chunk handoff: avg %lu cycles, max %lu cycles over %lu chunks\r\n",
+		           ota_handoff_stats.total_cycles / ota_handoff_stats.chunks,
+		           ota_handoff_stats.max_cycles, ota_handoff_stats.chunks);
 	}
-	else if(strcmp(cmd, "data") == 0){
-		SensorMessage_t snapshot;
+}
 
-		if(osMutexAcquire(sensor_data_mutex, osWaitForever) == osOK){
-			snapshot = g_sensor_data;
-			osMutexRelease(sensor_data_mutex);
-			log_printf("Temp: %.2f C, Pressure: %.2f%%, Time: %d ms\r\n", snapshot.temperature, snapshot.pressure, snapshot.timestamp_ms);
+CLI_COMMAND(otafinish, "", "", "Manually finish OTA process")
+{
+	if ((osThreadFlagsSet(OTATaskHandle, OTA_FLAG_FINISH) & osFlagsError) == 0) {
+		log_printf("OTA finish command sent\r\n");
+	} else {
+		log_printf("Failed to send OTA finish command\r\n");
+	}
+}
 
-		}else{
-			log_printf("Sensor data access timeout\r\n");
-		}
+CLI_COMMAND(otaabort, "", "", "Abort the OTA transfer")
+{
+	if ((osThreadFlagsSet(OTATaskHandle, OTA_FLAG_ABORT) & osFlagsError) == 0) {
+		log_printf("OTA abort command sent\r\n");
+	} else {
+		log_printf("Failed to send OTA abort command\r\n");
+	}
+}
+
+CLI_COMMAND(crc, "", "", "CRC32 of the active slot (background job)")
+{
+	submit_job("crc", crc_job);
+}
+
+CLI_COMMAND(initmetadata, "", "", "Rewrite boot metadata (background job)")
+{
+	submit_job("initmetadata", initmetadata_job);
+}
+
+CLI_COMMAND(bg, "", "", "List background jobs")
+{
+	JobInfo_t info[JOB_MAX];
+	uint32_t count = job_list(info, JOB_MAX);
+	if (count == 0) {
+		log_printf("No background jobs\r\n");
+	}
+	for (uint32_t j = 0; j < count; j++) {
+		log_printf("Job %lu %s: %s %u%%\r\n", info[j].id, info[j].name,
+		           job_state_name(info[j].state), info[j].progress);
 	}
-	else{
-		log_printf("invalid command: '%s'\r\n", cmd);
+}
+
+CLI_COMMAND(cancel, "u", "<job_id>", "Cancel a background job")
+{
+	if (job_cancel(args->v[0].u)) {
+		log_printf("Cancelling job %lu\r\n", args->v[0].u);
+	} else {
+		log_printf("No active job with that ID\r\n");
+	}
+}
+
+CLI_COMMAND(clearprotection, "", "", "Clear flash write protection")
+{
+	log_printf("Clearing flash protection...\r\n");
+	HAL_StatusTypeDef status = clear_flash_protection();
+	if (status == HAL_OK) {
+		log_printf("Flash protection cleared successfully\r\n");
+		log_printf("Please reset the device for changes to take effect\r\n");
+	} else {
+		log_printf("Flash protection clear failed: %d\r\n", status);
+	}
+}
+
+CLI_COMMAND(data, "", "", "Show current sensor data readings")
+{
+	SensorMessage_t snapshot;
+
+	sensor_snapshot_read(&snapshot);
+	log_printf("Temp: %.2f C, Pressure: %.2f%%, Time: %lu ms\r\n", snapshot.temperature, snapshot.pressure, snapshot.timestamp_ms);
+}
+
+CLI_COMMAND(pools, "", "", "Show message pool usage and heap status")
+{
+	for (uint32_t c = 0; c < MSG_POOL_CLASS_COUNT; c++) {
+		MsgPoolStats_t stats;
+		msg_pool_get_stats(c, &stats);
+		log_printf("%s: %luB x %lu, used %lu, peak %lu, allocs %lu, fails %lu\r\n",
+		           stats.name, stats.block_size, stats.capacity, stats.in_use,
+		           stats.high_water, stats.alloc_count, stats.fail_count);
+	}
+	log_printf("Heap free: %u bytes (min %u), post-boot mallocs: %lu\r\n",
+	           (unsigned int)xPortGetFreeHeapSize(), (unsigned int)xPortGetMinimumEverFreeHeapSize(),
+	           msg_pool_heap_violations());
+}
+
+CLI_COMMAND(jobs, "", "", "Show periodic job timing")
+{
+	for (uint32_t j = 0; j < periodic_job_count(); j++) {
+		PeriodicJobStats_t stats;
+		periodic_job_get_stats(j, &stats);
+		log_printf("%s: every %lu ms, runs %lu, overruns %lu, max late %lu ms, max run %lu ms\r\n",
+		           stats.name, stats.period_ms, stats.runs, stats.overruns,
+		           stats.max_lateness_ms, stats.max_runtime_ms);
 	}
 }
@@ -0,0 +1,215 @@
+/*
+ * cli_registry.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+#include "cli_registry.h"
+#include <string.h>
+#include <stdlib.h>
+#include "uart_logger.h"
+
+#define CLI_SLOT_EMPTY      0xFF
+
+// Provided by the linker script around the .cli_cmds output section
+extern const CliCommand_t __cli_cmds_start[];
+extern const CliCommand_t __cli_cmds_end[];
+
+// The linker scripts refuse to link more than CLI_CMDS_MAX entries of
+// CLI_CMD_SIZE bytes; keep them in step with this header
+_Static_assert(sizeof(void *) != 4 || sizeof(CliCommand_t) == 20, "CLI_CMD_SIZE in the linker scripts");
+_Static_assert(CLI_HASH_SIZE / 2 == 64, "CLI_CMDS_MAX in the linker scripts");
+_Static_assert(CLI_HASH_SIZE <= CLI_SLOT_EMPTY + 1, "slot indices fit a uint8_t");
+
+// Open-addressed index into the command table, built once at boot
+static uint8_t cli_hash_table[CLI_HASH_SIZE];
+static uint32_t cli_indexed = 0;     // Commands [0, cli_indexed) are in the hash table
+static uint8_t cli_ready = 0;
+
+static uint32_t cli_hash(const char *s)
+{
+	uint32_t h = 2166136261u;    // FNV-1a
+	while (*s) {
+		h ^= (uint8_t)*s++;
+		h *= 16777619u;
+	}
+	return h;
+}
+
+uint32_t cli_command_count(void)
+{
+	return (uint32_t)(__cli_cmds_end - __cli_cmds_start);
+}
+
+const CliCommand_t *cli_command_at(uint32_t index)
+{
+	return (index < cli_command_count()) ? &__cli_cmds_start[index] : NULL;
+}
+
+void cli_registry_init(void)
+{
+	uint32_t count = cli_command_count();
+
+	memset(cli_hash_table, CLI_SLOT_EMPTY, sizeof(cli_hash_table));
+
+	// Cannot happen with the linker check in place; the rest stay reachable
+	// through the linear scan in cli_find()
+	if (count > CLI_HASH_SIZE / 2) {
+		log_printf("CLI: %lu commands exceed hash table capacity %u, not indexed:", count, CLI_HASH_SIZE / 2);
+		for (uint32_t c = CLI_HASH_SIZE / 2; c < count; c++) {
+			log_printf(" %s", __cli_cmds_start[c].name);
+		}
+		log_printf("\r\n");
+		count = CLI_HASH_SIZE / 2;
+	}
+	cli_indexed = count;
+
+	for (uint32_t c = 0; c < count; c++) {
+		uint32_t slot = cli_hash(__cli_cmds_start[c].name) & (CLI_HASH_SIZE - 1);
+
+		while (cli_hash_table[slot] != CLI_SLOT_EMPTY) {
+			if (strcmp(__cli_cmds_start[cli_hash_table[slot]].name, __cli_cmds_start[c].name) == 0) {
+				log_printf("CLI: duplicate command '%s' ignored\r\n", __cli_cmds_start[c].name);
+				break;
+			}
+			slot = (slot + 1) & (CLI_HASH_SIZE - 1);
+		}
+		if (cli_hash_table[slot] == CLI_SLOT_EMPTY) {
+			cli_hash_table[slot] = (uint8_t)c;
+		}
+	}
+	cli_ready = 1;
+}
+
+const CliCommand_t *cli_find(const char *name)
+{
+	if (!cli_ready) {
+		return NULL;
+	}
+
+	uint32_t slot = cli_hash(name) & (CLI_HASH_SIZE - 1);
+	// The table is at most half full, so a miss ends at an empty slot quickly
+	while (cli_hash_table[slot] != CLI_SLOT_EMPTY) {
+		const CliCommand_t *entry = &__cli_cmds_start[cli_hash_table[slot]];
+		if (strcmp(entry->name, name) == 0) {
+			return entry;
+		}
+		slot = (slot + 1) & (CLI_HASH_SIZE - 1);
+	}
+	for (uint32_t c = cli_indexed; c < cli_command_count(); c++) {
+		if (strcmp(__cli_cmds_start[c].name, name) == 0) {
+			return &__cli_cmds_start[c];
+		}
+	}
+	return NULL;
+}
+
+// Splits a line in place on spaces. Double quotes group a token with spaces.
+uint32_t cli_tokenize(char *line, char **argv, uint32_t max_args)
+{
+	uint32_t argc = 0;
+	char *p = line;
+
+	while (*p != '\0' && argc < max_args) {
+		while (*p == ' ' || *p == '\t') {
+			p++;
+		}
+		if (*p == '\0') {
+			break;
+		}
+
+		if (*p == '"') {
+			argv[argc++] = ++p;
+			while (*p != '\0' && *p != '"') {
+				p++;
+			}
+		} else {
+			argv[argc++] = p;
+			while (*p != '\0' && *p != ' ' && *p != '\t') {
+				p++;
+			}
+		}
+		if (*p != '\0') {
+			*p++ = '\0';
+		}
+	}
+	return argc;
+}
+
+static int cli_parse_arg(char type, const char *token, CliArg_t *out)
+{
+	char *end = NULL;
+
+	switch (type) {
+		case 'u':
+			if (*token == '-') {
+				return 0;
+			}
+			out->u = strtoul(token, &end, 0);
+			break;
+		case 'i':
+			out->i = strtol(token, &end, 0);
+			break;
+		case 'f':
+			out->f = strtof(token, &end);
+			break;
+		case 's':
+			out->s = token;
+			return 1;
+		default:
+			return 0;
+	}
+	return (end != token && *end == '\0');
+}
+
+static void cli_usage(const CliCommand_t *cmd)
+{
+	log_printf("Usage: %s %s\r\n", cmd->name, cmd->usage);
+}
+
+void cli_dispatch(const char *line)
+{
+	char buf[CLI_MAX_LINE];
+	char *argv[CLI_MAX_ARGS + 1];
+	CliArgs_t args;
+
+	strncpy(buf, line, sizeof(buf) - 1);
+	buf[sizeof(buf) - 1] = '\0';
+
+	// One extra slot so surplus arguments are detected rather than dropped
+	uint32_t argc = cli_tokenize(buf, argv, CLI_MAX_ARGS + 1);
+	if (argc == 0) {
+		return;
+	}
+
+	const CliCommand_t *cmd = cli_find(argv[0]);
+	if (cmd == NULL) {
+		log_printf("invalid command: '%s'\r\n", line);
+		return;
+	}
+
+	const char *schema = cmd->schema;
+	uint8_t optional = 0;
+	memset(&args, 0, sizeof(args));
+
+	for (uint32_t a = 1; a < argc; a++) {
+		if (*schema == '|') {
+			optional = 1;
+			schema++;
+		}
+		if (*schema == '\0' || !cli_parse_arg(*schema, argv[a], &args.v[args.count])) {
+			cli_usage(cmd);
+			return;
+		}
+		args.count++;
+		schema++;
+	}
+
+	// Anything left in the schema must be optional
+	if (*schema != '\0' && *schema != '|' && !optional) {
+		cli_usage(cmd);
+		return;
+	}
+
+	cmd->handler(&args);
+}
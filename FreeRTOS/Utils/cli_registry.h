@@ -0,0 +1,63 @@
+/*
+ * cli_registry.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+
+#ifndef CLI_REGISTRY_H_
+#define CLI_REGISTRY_H_
+
+#include <stdint.h>
+
+#define CLI_MAX_ARGS        6
+#define CLI_MAX_LINE        64      // Matches the CLITask command buffer
+#define CLI_HASH_SIZE       128     // Power of two, at least twice the command count
+
+// Argument schema characters:
+//   'u' uint32 (decimal or 0x hex), 'i' int32, 'f' float, 's' string token
+//   '|' every argument after it is optional
+// e.g. "u|u" takes one required and one optional unsigned argument.
+typedef union {
+	uint32_t u;
+	int32_t i;
+	float f;
+	const char *s;
+} CliArg_t;
+
+typedef struct {
+	uint32_t count;              // Arguments actually supplied
+	CliArg_t v[CLI_MAX_ARGS];
+} CliArgs_t;
+
+typedef void (*CliHandler_t)(const CliArgs_t *args);
+
+typedef struct {
+	const char *name;
+	const char *schema;
+	const char *usage;           // Printed after the name on a parse error
+	const char *help;
+	CliHandler_t handler;
+} CliCommand_t;
+
+// Registers a command from any module. The entry lands in the .cli_cmds
+// linker section, so no central list has to be edited:
+//
+//   CLI_COMMAND(version, "", "", "Show firmware version") {
+//       log_printf("...");
+//   }
+#define CLI_COMMAND(cmd, schema_str, usage_str, help_str)                      \
+	static void cli_cmd_##cmd(const CliArgs_t *args);                          \
+	static const CliCommand_t cli_entry_##cmd                                  \
+		__attribute__((used, section(".cli_cmds"), aligned(4))) =              \
+		{ #cmd, schema_str, usage_str, help_str, cli_cmd_##cmd };              \
+	static void cli_cmd_##cmd(const CliArgs_t *args)
+
+void cli_registry_init(void);
+uint32_t cli_tokenize(char *line, char **argv, uint32_t max_args);
+const CliCommand_t *cli_find(const char *name);
+void cli_dispatch(const char *line);
+uint32_t cli_command_count(void);
+const CliCommand_t *cli_command_at(uint32_t index);
+
+#endif /* CLI_REGISTRY_H_ */
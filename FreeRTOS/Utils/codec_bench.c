@@ -0,0 +1,124 @@
+/*
+ * codec_bench.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+#include "ts_codec.h"
+#include "cli_registry.h"
+#include "job_worker.h"
+#include "cycle_counter.h"
+#include "uart_logger.h"
+#include <string.h>
+
+#define CODEC_BENCH_SAMPLES     256
+#define CODEC_BENCH_CHANNELS    2
+#define CODEC_RAW_SAMPLE_BYTES  12      // sizeof(SensorMessage_t)
+
+typedef enum {
+	TRACE_IDLE,                  // Nothing changes: the best case
+	TRACE_DRIFT,                 // Slow drift quantised to 0.01, like a real sensor
+	TRACE_NOISY,                 // Low-passed noise with full float mantissas
+	TRACE_COUNT
+} TraceId_t;
+
+static const char *const trace_names[TRACE_COUNT] = { "idle", "drift", "noisy" };
+
+static uint32_t trace_ts[CODEC_BENCH_SAMPLES];
+static float trace_values[CODEC_BENCH_SAMPLES][CODEC_BENCH_CHANNELS];
+static uint8_t codec_buf[(TS_CODEC_WORST_BITS(CODEC_BENCH_CHANNELS) * CODEC_BENCH_SAMPLES + 7) / 8];
+
+static float quantise(float v)
+{
+	int32_t centi = (int32_t)(v * 100.0f + ((v >= 0.0f) ? 0.5f : -0.5f));
+	return (float)centi / 100.0f;
+}
+
+// 10 ms sampling with an occasional 1 ms late sample, as the scheduler produces
+static void trace_fill(TraceId_t id)
+{
+	uint32_t lcg = 2463534242u;
+	uint32_t ts = 100000;
+	float temp = 24.0f;
+	float press = 101.3f;
+	float noise = 0.0f;
+
+	for (uint32_t k = 0; k < CODEC_BENCH_SAMPLES; k++) {
+		lcg = lcg * 1664525u + 1013904223u;
+		ts += 10 + (((lcg >> 28) == 0) ? 1 : 0);
+		trace_ts[k] = ts;
+
+		switch (id) {
+			case TRACE_IDLE:
+				break;
+			case TRACE_DRIFT:
+				temp += 0.002f;
+				press += ((lcg >> 16) & 1) ? 0.001f : -0.001f;
+				break;
+			default:
+				noise += 0.2f * ((float)(lcg >> 20) / 4096.0f - 0.5f - noise);
+				break;
+		}
+
+		if (id == TRACE_NOISY) {
+			trace_values[k][0] = temp + noise;
+			trace_values[k][1] = press - noise;
+		} else {
+			trace_values[k][0] = quantise(temp);
+			trace_values[k][1] = quantise(press);
+		}
+	}
+}
+
+static bool codecbench_job(Job_t *job, void *arg)
+{
+	for (uint32_t id = 0; id < TRACE_COUNT; id++) {
+		TsCodec_t codec;
+
+		if (job_cancel_requested(job)) {
+			return false;
+		}
+		trace_fill((TraceId_t)id);
+
+		uint32_t start = cycle_counter_now();
+		ts_encoder_init(&codec, codec_buf, sizeof(codec_buf), CODEC_BENCH_CHANNELS);
+		for (uint32_t k = 0; k < CODEC_BENCH_SAMPLES; k++) {
+			ts_encoder_add(&codec, trace_ts[k], trace_values[k]);
+		}
+		uint32_t encode_cycles = cycle_counter_now() - start;
+		uint32_t bytes = ts_encoder_bytes(&codec);
+
+		bool match = true;
+		start = cycle_counter_now();
+		ts_decoder_init(&codec, codec_buf, bytes, CODEC_BENCH_CHANNELS);
+		for (uint32_t k = 0; k < CODEC_BENCH_SAMPLES; k++) {
+			uint32_t ts;
+			float values[CODEC_BENCH_CHANNELS];
+			ts_decoder_next(&codec, &ts, values);
+			match &= (ts == trace_ts[k]) && memcmp(values, trace_values[k], sizeof(values)) == 0;
+		}
+		uint32_t decode_cycles = cycle_counter_now() - start;
+
+		uint32_t raw_bytes = CODEC_BENCH_SAMPLES * CODEC_RAW_SAMPLE_BYTES;
+		uint32_t ratio_x10 = (raw_bytes * 10) / bytes;
+		log_printf("%-6s %4lu bytes (%2lu.%lux vs raw), %3lu bits/sample, enc %lu cyc/sample, dec %lu cyc/sample, %s\r\n",
+		           trace_names[id], bytes, ratio_x10 / 10, ratio_x10 % 10,
+		           (bytes * 8) / CODEC_BENCH_SAMPLES, encode_cycles / CODEC_BENCH_SAMPLES,
+		           decode_cycles / CODEC_BENCH_SAMPLES, match ? "round-trip OK" : "ROUND-TRIP MISMATCH");
+		job_set_progress(job, id + 1, TRACE_COUNT);
+		if (!match) {
+			return false;
+		}
+	}
+	return true;
+}
+
+CLI_COMMAND(codecbench, "", "", "Benchmark Gorilla compression on sample traces")
+{
+	uint32_t id = job_submit("codecbench", codecbench_job, NULL);
+	if (id != 0) {
+		log_printf("Job %lu started: codecbench (%u samples per trace)\r\n", id, CODEC_BENCH_SAMPLES);
+	} else {
+		log_printf("Job queue full, try again later\r\n");
+	}
+}
@@ -0,0 +1,119 @@
+/*
+ * crc32.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+#include "crc32.h"
+#include "main.h"
+#include "cmsis_os.h"
+#include "ota.h"
+#include "kv_store.h"
+#include "cli_registry.h"
+#include "uart_logger.h"
+#include <string.h>
+
+// The HAL CRC driver is not used here; the unit is driven through its registers
+#define CRC_BACKEND_KEY          "crc.backend"
+
+static const char *const backend_names[CRC_BACKEND_COUNT] = { "sw", "hw" };
+
+static osMutexId_t crc_lock;                     // Owns the CRC unit
+static volatile CrcBackend_t selected = CRC_BACKEND_HW;
+
+void crc32_init(void)
+{
+	crc_lock = osMutexNew(NULL);
+
+	RCC->AHB1ENR |= RCC_AHB1ENR_CRCEN;
+	__DSB();
+}
+
+void crc32_load_settings(void)
+{
+	// A saved "dma" (2) from older firmware is out of range and keeps hw
+	uint32_t backend = kv_get_u32(CRC_BACKEND_KEY, CRC_BACKEND_HW);
+
+	if (backend < CRC_BACKEND_COUNT) {
+		selected = (CrcBackend_t)backend;
+	}
+}
+
+void crc32_set_backend(CrcBackend_t backend)
+{
+	if (backend < CRC_BACKEND_COUNT) {
+		selected = backend;
+	}
+}
+
+CrcBackend_t crc32_get_backend(void)
+{
+	return selected;
+}
+
+const char *crc32_backend_name(CrcBackend_t backend)
+{
+	return (backend < CRC_BACKEND_COUNT) ? backend_names[backend] : "?";
+}
+
+void crc32_begin(Crc32Ctx_t *ctx, CrcBackend_t backend)
+{
+	ctx->backend = backend;
+	ctx->crc = 0xFFFFFFFF;
+
+	if (backend != CRC_BACKEND_SW) {
+		osMutexAcquire(crc_lock, osWaitForever);
+		CRC->CR = CRC_CR_RESET;
+	}
+}
+
+void crc32_feed(Crc32Ctx_t *ctx, const uint32_t *data, uint32_t words)
+{
+	switch (ctx->backend) {
+		case CRC_BACKEND_HW:
+			for (uint32_t i = 0; i < words; i++) {
+				CRC->DR = __RBIT(data[i]);
+			}
+			break;
+		default:
+			ctx->crc = crc32_update_words(ctx->crc, data, words);
+			break;
+	}
+}
+
+uint32_t crc32_end(Crc32Ctx_t *ctx)
+{
+	if (ctx->backend == CRC_BACKEND_SW) {
+		return ~ctx->crc;
+	}
+	uint32_t crc = ~__RBIT(CRC->DR);
+	osMutexRelease(crc_lock);
+	return crc;
+}
+
+uint32_t crc32_compute(const uint32_t *data, uint32_t words)
+{
+	Crc32Ctx_t ctx;
+
+	crc32_begin(&ctx, selected);
+	crc32_feed(&ctx, data, words);
+	return crc32_end(&ctx);
+}
+
+// crcmode | crcmode <sw|hw>
+CLI_COMMAND(crcmode, "|s", "[sw|hw]", "Show or select the CRC-32 backend")
+{
+	if (args->count == 0) {
+		log_printf("CRC backend: %s\r\n", crc32_backend_name(selected));
+		return;
+	}
+	for (uint32_t b = 0; b < CRC_BACKEND_COUNT; b++) {
+		if (strcmp(args->v[0].s, backend_names[b]) == 0) {
+			crc32_set_backend((CrcBackend_t)b);
+			bool saved = kv_set_u32(CRC_BACKEND_KEY, b);
+			log_printf("CRC backend: %s%s\r\n", backend_names[b], saved ? "" : " (not saved)");
+			return;
+		}
+	}
+	log_printf("Usage: crcmode [sw|hw]\r\n");
+}
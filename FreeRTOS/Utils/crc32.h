@@ -0,0 +1,59 @@
+/*
+ * crc32.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+
+#ifndef CRC32_H_
+#define CRC32_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// zlib CRC-32 over word-aligned data (flash images, metadata), the value
+// ota_update.py computes, on one of two backends chosen at run time:
+//
+//   sw   crc32_update_words(), bit-serial, no peripherals
+//   hw   CRC unit fed by the CPU
+//
+// The F446 CRC unit is fixed at MSB-first CRC-32 with no input or output
+// reflection, so each word goes in bit-reversed (RBIT) and the result is
+// bit-reversed and inverted; that gives the LSB-first zlib value. There is
+// no DMA backend: without the REV_IN option of later parts the CPU would
+// still RBIT every word into RAM first, which costs as much as writing it
+// to the unit directly.
+//
+// The unit has one running register and no way to load a state, so a
+// hardware calculation owns it from crc32_begin() to crc32_end(); other
+// callers block in crc32_begin() until then.
+
+typedef enum {
+	CRC_BACKEND_SW = 0,
+	CRC_BACKEND_HW,
+	CRC_BACKEND_COUNT
+} CrcBackend_t;
+
+typedef struct {
+	CrcBackend_t backend;
+	uint32_t crc;                // Running register, sw backend only
+} Crc32Ctx_t;
+
+// Creates the unit's mutex; call before the heap is locked
+void crc32_init(void);
+void crc32_load_settings(void);
+
+void crc32_set_backend(CrcBackend_t backend);
+CrcBackend_t crc32_get_backend(void);
+const char *crc32_backend_name(CrcBackend_t backend);
+
+// Incremental calculation, so long checks can run in resumable blocks.
+// Every crc32_begin() must be paired with crc32_end().
+void crc32_begin(Crc32Ctx_t *ctx, CrcBackend_t backend);
+void crc32_feed(Crc32Ctx_t *ctx, const uint32_t *data, uint32_t words);
+uint32_t crc32_end(Crc32Ctx_t *ctx);
+
+// One-shot on the selected backend
+uint32_t crc32_compute(const uint32_t *data, uint32_t words);
+
+#endif /* CRC32_H_ */
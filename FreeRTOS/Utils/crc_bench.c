@@ -0,0 +1,66 @@
+/*
+ * crc_bench.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+#include "crc32.h"
+#include "boot_metadata.h"
+#include "cli_registry.h"
+#include "job_worker.h"
+#include "cycle_counter.h"
+#include "uart_logger.h"
+
+#define CRC_BENCH_BYTES         (192U * 1024U)   // A whole slot, as the bootloader checks it
+#define CRC_BENCH_WORDS         (CRC_BENCH_BYTES / 4)
+#define CRC_BENCH_RUNS          3                // Best of N, to filter out preemption
+
+static bool crcbench_job(Job_t *job, void *arg)
+{
+	const uint32_t *slot = (const uint32_t *)SLOT_A_ADDRESS;
+	uint32_t sw_cycles = 0;
+	uint32_t sw_crc = 0;
+
+	for (uint32_t b = 0; b < CRC_BACKEND_COUNT; b++) {
+		uint32_t best = UINT32_MAX;
+		uint32_t crc = 0;
+
+		for (uint32_t run = 0; run < CRC_BENCH_RUNS; run++) {
+			if (job_cancel_requested(job)) {
+				return false;
+			}
+			Crc32Ctx_t ctx;
+			uint32_t start = cycle_counter_now();
+			crc32_begin(&ctx, (CrcBackend_t)b);
+			crc32_feed(&ctx, slot, CRC_BENCH_WORDS);
+			crc = crc32_end(&ctx);
+			uint32_t cycles = cycle_counter_now() - start;
+			if (cycles < best) {
+				best = cycles;
+			}
+		}
+
+		if (b == CRC_BACKEND_SW) {
+			sw_cycles = best;
+			sw_crc = crc;
+		}
+		// Hundredths of a cycle per byte, in integer math
+		uint32_t per_byte_x100 = (uint32_t)(((uint64_t)best * 100) / CRC_BENCH_BYTES);
+		log_printf("%-3s %9lu cycles %6lu us  %2lu.%02lu cycles/byte  x%lu  0x%08lX%s\r\n",
+		           crc32_backend_name((CrcBackend_t)b), best, cycles_to_us(best),
+		           per_byte_x100 / 100, per_byte_x100 % 100, (best > 0) ? sw_cycles / best : 0, crc,
+		           (crc == sw_crc) ? "" : "  MISMATCH");
+		job_set_progress(job, b + 1, CRC_BACKEND_COUNT);
+	}
+	return true;
+}
+
+CLI_COMMAND(crcbench, "", "", "Benchmark CRC-32 backends over a full slot")
+{
+	uint32_t id = job_submit("crcbench", crcbench_job, NULL);
+	if (id != 0) {
+		log_printf("Job %lu started: crcbench (%u KB, best of %u)\r\n", id, CRC_BENCH_BYTES / 1024, CRC_BENCH_RUNS);
+	} else {
+		log_printf("Job queue full, try again later\r\n");
+	}
+}
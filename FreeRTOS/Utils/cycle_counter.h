@@ -0,0 +1,32 @@
+/*
+ * cycle_counter.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+
+#ifndef CYCLE_COUNTER_H_
+#define CYCLE_COUNTER_H_
+
+#include "main.h"
+
+// DWT cycle counter, used for on-target benchmarks and sub-tick timestamps.
+// Wraps every 2^32 cycles (~268 s at 16 MHz); differences stay valid across one wrap.
+static inline void cycle_counter_init(void)
+{
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+static inline uint32_t cycle_counter_now(void)
+{
+	return DWT->CYCCNT;
+}
+
+static inline uint32_t cycles_to_us(uint32_t cycles)
+{
+	return cycles / (SystemCoreClock / 1000000U);
+}
+
+#endif /* CYCLE_COUNTER_H_ */
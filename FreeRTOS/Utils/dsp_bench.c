@@ -0,0 +1,250 @@
+/*
+ * dsp_bench.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+#include "dsp_filter.h"
+#include "cli_registry.h"
+#include "job_worker.h"
+#include "cycle_counter.h"
+#include "uart_logger.h"
+#include "FreeRTOS.h"
+#include "timers.h"
+#include <string.h>
+
+#define BENCH_SAMPLES       256
+#define BENCH_RUNS          5       // Best of N, to filter out preemption
+#define BENCH_FIR_TAPS      16
+#define FPU_CTX_ROUNDS      100
+
+// libgcc's software float routines. They always use the base (integer
+// register) calling convention, which lets the hard-float build time the
+// soft-float path without a second toolchain profile.
+extern float __aeabi_fadd(float a, float b) __attribute__((pcs("aapcs")));
+extern float __aeabi_fsub(float a, float b) __attribute__((pcs("aapcs")));
+extern float __aeabi_fmul(float a, float b) __attribute__((pcs("aapcs")));
+
+static float in_f32[BENCH_SAMPLES];
+static float out_f32[BENCH_SAMPLES];
+static int32_t in_q31[BENCH_SAMPLES];
+static int32_t out_q31[BENCH_SAMPLES];
+static int16_t in_q15[BENCH_SAMPLES];
+static int16_t out_q15[BENCH_SAMPLES];
+static DspFirF32_t fir_f32;
+static DspFirQ15_t fir_q15;
+static float fir_taps_f32[BENCH_FIR_TAPS];
+static int16_t fir_taps_q15[BENCH_FIR_TAPS];
+
+// Triangle wave plus LCG noise, kept within half scale for the Q31 filter
+static void bench_fill_input(void)
+{
+	uint32_t lcg = 12345;
+
+	for (uint32_t k = 0; k < BENCH_SAMPLES; k++) {
+		uint32_t phase = k % 64;
+		float tri = (phase < 32) ? (float)phase / 32.0f : (float)(64 - phase) / 32.0f;
+		lcg = lcg * 1664525u + 1013904223u;
+		float noise = (float)(lcg >> 24) / 2560.0f;
+		float x = 0.4f * (tri - 0.5f) + noise;
+
+		in_f32[k] = x;
+		in_q31[k] = (int32_t)(x * 2147483648.0f);
+		in_q15[k] = (int16_t)(x * 32768.0f);
+	}
+
+	for (uint32_t t = 0; t < BENCH_FIR_TAPS; t++) {
+		fir_taps_f32[t] = 1.0f / BENCH_FIR_TAPS;
+		fir_taps_q15[t] = (int16_t)(32768 / BENCH_FIR_TAPS);
+	}
+}
+
+static void lowpass_soft_block(DspLowPassF32_t *f, const float *in, float *out, uint32_t n)
+{
+	float y = f->y;
+	for (uint32_t k = 0; k < n; k++) {
+		y = __aeabi_fadd(y, __aeabi_fmul(f->alpha, __aeabi_fsub(in[k], y)));
+		out[k] = y;
+	}
+	f->y = y;
+}
+
+static void fir_soft_block(const float *coeffs, const float *in, float *out, uint32_t n)
+{
+	for (uint32_t k = 0; k < n; k++) {
+		float acc = 0.0f;
+		for (uint32_t t = 0; t < BENCH_FIR_TAPS && t <= k; t++) {
+			acc = __aeabi_fadd(acc, __aeabi_fmul(coeffs[t], in[k - t]));
+		}
+		out[k] = acc;
+	}
+}
+
+typedef enum {
+	BENCH_LOWPASS_F32,
+	BENCH_LOWPASS_SOFT,
+	BENCH_LOWPASS_Q31,
+	BENCH_FIR_F32,
+	BENCH_FIR_SOFT,
+	BENCH_FIR_Q15,
+	BENCH_MOVAVG_F32,
+	BENCH_DECIMATE_F32,
+	BENCH_COUNT
+} BenchId_t;
+
+static const char *const bench_names[BENCH_COUNT] = {
+	"lowpass f32 (FPU)", "lowpass soft-float", "lowpass Q31",
+	"fir16 f32 (FPU)", "fir16 soft-float", "fir16 Q15 SMLALD",
+	"movavg16 f32", "decimate4 f32"
+};
+
+static void bench_run_once(BenchId_t id)
+{
+	DspLowPassF32_t lp;
+	DspLowPassQ31_t lpq;
+	DspMovAvgF32_t ma;
+	DspDecimatorF32_t dec;
+	uint32_t outs = 0;
+
+	switch (id) {
+		case BENCH_LOWPASS_F32:
+			dsp_lowpass_f32_init(&lp, 0.1f);
+			dsp_lowpass_f32_block(&lp, in_f32, out_f32, BENCH_SAMPLES);
+			break;
+		case BENCH_LOWPASS_SOFT:
+			dsp_lowpass_f32_init(&lp, 0.1f);
+			lowpass_soft_block(&lp, in_f32, out_f32, BENCH_SAMPLES);
+			break;
+		case BENCH_LOWPASS_Q31:
+			dsp_lowpass_q31_init(&lpq, 0.1f);
+			dsp_lowpass_q31_block(&lpq, in_q31, out_q31, BENCH_SAMPLES);
+			break;
+		case BENCH_FIR_F32:
+			dsp_fir_f32_init(&fir_f32, fir_taps_f32, BENCH_FIR_TAPS);
+			dsp_fir_f32_block(&fir_f32, in_f32, out_f32, BENCH_SAMPLES);
+			break;
+		case BENCH_FIR_SOFT:
+			fir_soft_block(fir_taps_f32, in_f32, out_f32, BENCH_SAMPLES);
+			break;
+		case BENCH_FIR_Q15:
+			dsp_fir_q15_init(&fir_q15, fir_taps_q15, BENCH_FIR_TAPS);
+			dsp_fir_q15_block(&fir_q15, in_q15, out_q15, BENCH_SAMPLES);
+			break;
+		case BENCH_MOVAVG_F32:
+			dsp_movavg_f32_init(&ma, BENCH_FIR_TAPS);
+			for (uint32_t k = 0; k < BENCH_SAMPLES; k++) {
+				out_f32[k] = dsp_movavg_f32(&ma, in_f32[k]);
+			}
+			break;
+		case BENCH_DECIMATE_F32:
+			dsp_decimator_f32_init(&dec, 4);
+			for (uint32_t k = 0; k < BENCH_SAMPLES; k++) {
+				outs += dsp_decimator_f32(&dec, in_f32[k], &out_f32[outs]);
+			}
+			break;
+		default:
+			break;
+	}
+}
+
+static bool dspbench_job(Job_t *job, void *arg)
+{
+	bench_fill_input();
+
+	for (uint32_t id = 0; id < BENCH_COUNT; id++) {
+		uint32_t best = UINT32_MAX;
+
+		for (uint32_t run = 0; run < BENCH_RUNS; run++) {
+			if (job_cancel_requested(job)) {
+				return false;
+			}
+			uint32_t start = cycle_counter_now();
+			bench_run_once((BenchId_t)id);
+			uint32_t cycles = cycle_counter_now() - start;
+			if (cycles < best) {
+				best = cycles;
+			}
+		}
+
+		// Tenths of a cycle per sample, in integer math
+		uint32_t per_sample_x10 = (best * 10) / BENCH_SAMPLES;
+		log_printf("%-20s %6lu cycles/block  %4lu.%lu cycles/sample\r\n", bench_names[id],
+		           best, per_sample_x10 / 10, per_sample_x10 % 10);
+		job_set_progress(job, id + 1, BENCH_COUNT);
+	}
+	return true;
+}
+
+// Runs on the timer service task between the test's yields and overwrites
+// every FP register, so a missing FP context save shows up as a mismatch.
+static void fpu_clobber(void *param, uint32_t value)
+{
+	__asm volatile (
+		"vmov.f32 s0, #-1.0\n vmov.f32 s1, #-1.0\n vmov.f32 s2, #-1.0\n vmov.f32 s3, #-1.0\n"
+		"vmov.f32 s4, #-1.0\n vmov.f32 s5, #-1.0\n vmov.f32 s6, #-1.0\n vmov.f32 s7, #-1.0\n"
+		"vmov.f32 s8, #-1.0\n vmov.f32 s9, #-1.0\n vmov.f32 s10, #-1.0\n vmov.f32 s11, #-1.0\n"
+		"vmov.f32 s12, #-1.0\n vmov.f32 s13, #-1.0\n vmov.f32 s14, #-1.0\n vmov.f32 s15, #-1.0\n"
+		"vmov.f32 s16, #-1.0\n vmov.f32 s17, #-1.0\n vmov.f32 s18, #-1.0\n vmov.f32 s19, #-1.0\n"
+		"vmov.f32 s20, #-1.0\n vmov.f32 s21, #-1.0\n vmov.f32 s22, #-1.0\n vmov.f32 s23, #-1.0\n"
+		"vmov.f32 s24, #-1.0\n vmov.f32 s25, #-1.0\n vmov.f32 s26, #-1.0\n vmov.f32 s27, #-1.0\n"
+		"vmov.f32 s28, #-1.0\n vmov.f32 s29, #-1.0\n vmov.f32 s30, #-1.0\n vmov.f32 s31, #-1.0\n"
+		::: "s0", "s1", "s2", "s3", "s4", "s5", "s6", "s7", "s8", "s9", "s10", "s11",
+		    "s12", "s13", "s14", "s15", "s16", "s17", "s18", "s19", "s20", "s21", "s22",
+		    "s23", "s24", "s25", "s26", "s27", "s28", "s29", "s30", "s31");
+}
+
+// Float state lives in callee-saved s16+ across osDelay(), so it survives
+// only if the port saves and restores the FP context on every switch
+static float fpu_ctx_series(bool yield)
+{
+	float a = 1.0f, b = 0.5f, c = 0.25f;
+
+	for (uint32_t r = 0; r < FPU_CTX_ROUNDS; r++) {
+		a = a * 1.0001f + b;
+		b = b * 0.9999f + c;
+		c = c + 0.001f;
+		if (yield) {
+			xTimerPendFunctionCall(fpu_clobber, NULL, 0, 0);
+			osDelay(1);
+		}
+	}
+	return a + b + c;
+}
+
+static bool fputest_job(Job_t *job, void *arg)
+{
+	float expected = fpu_ctx_series(false);
+	float actual = fpu_ctx_series(true);
+	bool pass = memcmp(&expected, &actual, sizeof(float)) == 0;
+
+	log_printf("FPU context switch test: %s\r\n", pass ? "PASS" : "FAIL");
+	return pass;
+}
+
+CLI_COMMAND(fpu, "", "", "Show FPU state and test FP context switching")
+{
+	uint32_t cp_access = (SCB->CPACR >> 20) & 0xF;
+	uint32_t fpccr = FPU->FPCCR;
+
+	log_printf("FPU: CP10/CP11 %s, automatic state save %s, lazy stacking %s\r\n",
+	           (cp_access == 0xF) ? "full access" : "disabled",
+	           (fpccr & FPU_FPCCR_ASPEN_Msk) ? "on" : "off",
+	           (fpccr & FPU_FPCCR_LSPEN_Msk) ? "on" : "off");
+
+	uint32_t id = job_submit("fputest", fputest_job, NULL);
+	if (id != 0) {
+		log_printf("Job %lu started: fputest\r\n", id);
+	} else {
+		log_printf("Job queue full, try again later\r\n");
+	}
+}
+
+CLI_COMMAND(dspbench, "", "", "Benchmark FPU, soft-float and fixed-point filters")
+{
+	uint32_t id = job_submit("dspbench", dspbench_job, NULL);
+	if (id != 0) {
+		log_printf("Job %lu started: dspbench (%u samples per block)\r\n", id, BENCH_SAMPLES);
+	} else {
+		log_printf("Job queue full, try again later\r\n");
+	}
+}
@@ -0,0 +1,189 @@
+/*
+ * dsp_filter.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+#include "dsp_filter.h"
+#include "main.h"
+#include <string.h>
+
+void dsp_lowpass_f32_init(DspLowPassF32_t *f, float alpha)
+{
+	f->alpha = alpha;
+	f->y = 0.0f;
+	f->primed = false;
+}
+
+float dsp_lowpass_f32(DspLowPassF32_t *f, float x)
+{
+	if (!f->primed) {
+		f->y = x;
+		f->primed = true;
+	}
+	f->y += f->alpha * (x - f->y);   // Single VFMA on the M4F
+	return f->y;
+}
+
+void dsp_lowpass_f32_block(DspLowPassF32_t *f, const float *in, float *out, uint32_t n)
+{
+	float y = f->y;
+	float alpha = f->alpha;
+
+	if (n > 0 && !f->primed) {
+		y = in[0];
+		f->primed = true;
+	}
+	for (uint32_t k = 0; k < n; k++) {
+		y += alpha * (in[k] - y);
+		out[k] = y;
+	}
+	f->y = y;
+}
+
+void dsp_lowpass_q31_init(DspLowPassQ31_t *f, float alpha)
+{
+	f->alpha = (alpha >= 1.0f) ? INT32_MAX : (int32_t)(alpha * 2147483648.0f);
+	f->y = 0;
+}
+
+void dsp_lowpass_q31_block(DspLowPassQ31_t *f, const int32_t *in, int32_t *out, uint32_t n)
+{
+	int32_t y = f->y;
+	int32_t alpha = f->alpha;
+
+	for (uint32_t k = 0; k < n; k++) {
+		int32_t diff = __QSUB(in[k], y);
+		// y += diff * alpha in Q31; the 64-bit product maps to one SMLAL
+		int64_t acc = ((int64_t)y << 31) + (int64_t)diff * alpha;
+		y = (int32_t)(acc >> 31);
+		out[k] = y;
+	}
+	f->y = y;
+}
+
+bool dsp_movavg_f32_init(DspMovAvgF32_t *f, uint16_t len)
+{
+	if (len == 0 || len > DSP_MOVAVG_MAX_LEN) {
+		return false;
+	}
+	memset(f, 0, sizeof(*f));
+	f->len = len;
+	return true;
+}
+
+float dsp_movavg_f32(DspMovAvgF32_t *f, float x)
+{
+	// Running sum keeps the cost O(1) regardless of window length
+	f->sum += x - f->buf[f->pos];
+	f->buf[f->pos] = x;
+	f->pos = (f->pos + 1 == f->len) ? 0 : f->pos + 1;
+	if (f->fill < f->len) {
+		f->fill++;
+	}
+	return f->sum / (float)f->fill;
+}
+
+bool dsp_decimator_f32_init(DspDecimatorF32_t *d, uint16_t factor)
+{
+	if (factor == 0) {
+		return false;
+	}
+	d->acc = 0.0f;
+	d->factor = factor;
+	d->count = 0;
+	return true;
+}
+
+bool dsp_decimator_f32(DspDecimatorF32_t *d, float x, float *out)
+{
+	d->acc += x;
+	if (++d->count < d->factor) {
+		return false;
+	}
+	*out = d->acc / (float)d->factor;
+	d->acc = 0.0f;
+	d->count = 0;
+	return true;
+}
+
+bool dsp_fir_f32_init(DspFirF32_t *f, const float *coeffs, uint16_t num_taps)
+{
+	if (num_taps == 0 || num_taps > DSP_FIR_MAX_TAPS) {
+		return false;
+	}
+	memset(f->state, 0, sizeof(f->state));
+	f->coeffs = coeffs;
+	f->num_taps = num_taps;
+	return true;
+}
+
+void dsp_fir_f32_block(DspFirF32_t *f, const float *in, float *out, uint32_t n)
+{
+	uint32_t history = f->num_taps - 1;
+
+	while (n > 0) {
+		uint32_t block = (n > DSP_FIR_MAX_BLOCK) ? DSP_FIR_MAX_BLOCK : n;
+		memcpy(&f->state[history], in, block * sizeof(float));
+
+		for (uint32_t k = 0; k < block; k++) {
+			const float *x = &f->state[k + history];   // Newest sample for this output
+			float acc = 0.0f;
+			for (uint32_t t = 0; t < f->num_taps; t++) {
+				acc += f->coeffs[t] * x[-(int32_t)t];
+			}
+			out[k] = acc;
+		}
+
+		memmove(f->state, &f->state[block], history * sizeof(float));
+		in += block;
+		out += block;
+		n -= block;
+	}
+}
+
+bool dsp_fir_q15_init(DspFirQ15_t *f, const int16_t *coeffs, uint16_t num_taps)
+{
+	if (num_taps == 0 || num_taps > DSP_FIR_MAX_TAPS || (num_taps & 1) != 0) {
+		return false;
+	}
+	memset(f->state, 0, sizeof(f->state));
+	for (uint16_t t = 0; t < num_taps; t++) {
+		f->coeffs_rev[t] = coeffs[num_taps - 1 - t];
+	}
+	f->num_taps = num_taps;
+	return true;
+}
+
+// Reads two adjacent Q15 values as one word; the M4 handles unaligned LDR
+static inline uint32_t read_q15x2(const int16_t *p)
+{
+	uint32_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+void dsp_fir_q15_block(DspFirQ15_t *f, const int16_t *in, int16_t *out, uint32_t n)
+{
+	uint32_t history = f->num_taps - 1;
+
+	while (n > 0) {
+		uint32_t block = (n > DSP_FIR_MAX_BLOCK) ? DSP_FIR_MAX_BLOCK : n;
+		memcpy(&f->state[history], in, block * sizeof(int16_t));
+
+		for (uint32_t k = 0; k < block; k++) {
+			// Window runs oldest to newest, matching the reversed coefficients
+			const int16_t *x = &f->state[k];
+			int64_t acc = 0;
+			for (uint32_t t = 0; t < f->num_taps; t += 2) {
+				acc = __SMLALD(read_q15x2(&x[t]), read_q15x2(&f->coeffs_rev[t]), acc);
+			}
+			out[k] = (int16_t)__SSAT((int32_t)(acc >> 15), 16);
+		}
+
+		memmove(f->state, &f->state[block], history * sizeof(int16_t));
+		in += block;
+		out += block;
+		n -= block;
+	}
+}
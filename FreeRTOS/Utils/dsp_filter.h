@@ -0,0 +1,81 @@
+/*
+ * dsp_filter.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+
+#ifndef DSP_FILTER_H_
+#define DSP_FILTER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define DSP_MOVAVG_MAX_LEN      32
+#define DSP_FIR_MAX_TAPS        32
+#define DSP_FIR_MAX_BLOCK       64
+
+// One-pole IIR low-pass: y += alpha * (x - y), alpha in (0, 1]
+typedef struct {
+	float alpha;
+	float y;
+	bool primed;                 // First sample seeds y so there is no ramp from 0
+} DspLowPassF32_t;
+
+// Same filter in Q31; inputs should stay within half of full scale so
+// x - y cannot saturate
+typedef struct {
+	int32_t alpha;
+	int32_t y;
+} DspLowPassQ31_t;
+
+typedef struct {
+	float buf[DSP_MOVAVG_MAX_LEN];
+	float sum;
+	uint16_t len;
+	uint16_t pos;
+	uint16_t fill;
+} DspMovAvgF32_t;
+
+// Averages every 'factor' input samples into one output
+typedef struct {
+	float acc;
+	uint16_t factor;
+	uint16_t count;
+} DspDecimatorF32_t;
+
+// Direct-form FIR, coefficients in time order. The state holds the last
+// num_taps - 1 inputs so blocks can be processed back to back.
+typedef struct {
+	const float *coeffs;
+	float state[DSP_FIR_MAX_TAPS - 1 + DSP_FIR_MAX_BLOCK];
+	uint16_t num_taps;
+} DspFirF32_t;
+
+typedef struct {
+	int16_t coeffs_rev[DSP_FIR_MAX_TAPS];   // Time-reversed so pairs load as one word
+	int16_t state[DSP_FIR_MAX_TAPS - 1 + DSP_FIR_MAX_BLOCK];
+	uint16_t num_taps;
+} DspFirQ15_t;
+
+void dsp_lowpass_f32_init(DspLowPassF32_t *f, float alpha);
+float dsp_lowpass_f32(DspLowPassF32_t *f, float x);
+void dsp_lowpass_f32_block(DspLowPassF32_t *f, const float *in, float *out, uint32_t n);
+
+void dsp_lowpass_q31_init(DspLowPassQ31_t *f, float alpha);
+void dsp_lowpass_q31_block(DspLowPassQ31_t *f, const int32_t *in, int32_t *out, uint32_t n);
+
+bool dsp_movavg_f32_init(DspMovAvgF32_t *f, uint16_t len);
+float dsp_movavg_f32(DspMovAvgF32_t *f, float x);
+
+bool dsp_decimator_f32_init(DspDecimatorF32_t *d, uint16_t factor);
+bool dsp_decimator_f32(DspDecimatorF32_t *d, float x, float *out);
+
+bool dsp_fir_f32_init(DspFirF32_t *f, const float *coeffs, uint16_t num_taps);
+void dsp_fir_f32_block(DspFirF32_t *f, const float *in, float *out, uint32_t n);
+
+// num_taps must be even; two taps are accumulated per SMLALD
+bool dsp_fir_q15_init(DspFirQ15_t *f, const int16_t *coeffs, uint16_t num_taps);
+void dsp_fir_q15_block(DspFirQ15_t *f, const int16_t *in, int16_t *out, uint32_t n);
+
+#endif /* DSP_FILTER_H_ */
@@ -0,0 +1,30 @@
+/*
+ * flash_ctrl.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+#include "flash_ctrl.h"
+#include "cmsis_os.h"
+
+static const osMutexAttr_t flash_ctrl_attr = {
+	.name = "FlashCtrl",
+	.attr_bits = osMutexRecursive
+};
+
+static osMutexId_t flash_ctrl_mutex;
+
+void flash_ctrl_init(void)
+{
+	flash_ctrl_mutex = osMutexNew(&flash_ctrl_attr);
+}
+
+void flash_ctrl_lock(void)
+{
+	osMutexAcquire(flash_ctrl_mutex, osWaitForever);
+}
+
+void flash_ctrl_unlock(void)
+{
+	osMutexRelease(flash_ctrl_mutex);
+}
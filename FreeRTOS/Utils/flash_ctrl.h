@@ -0,0 +1,25 @@
+/*
+ * flash_ctrl.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+
+#ifndef FLASH_CTRL_H_
+#define FLASH_CTRL_H_
+
+// One owner at a time for the flash controller. HAL_FLASH_Unlock/Lock,
+// the error flag clears and the program/erase in between are one sequence;
+// two tasks interleaving them relock or clear flags under each other's
+// operation. Every unlock...lock in OTA, the flash log (and the settings
+// store on it) and the boot metadata journal runs with this held. It is
+// recursive, so a holder may call another module that takes it too.
+//
+// Lock order: the flash log lock first, then this one.
+
+// Call before anything touches flash, before the heap is locked
+void flash_ctrl_init(void);
+void flash_ctrl_lock(void);
+void flash_ctrl_unlock(void);
+
+#endif /* FLASH_CTRL_H_ */
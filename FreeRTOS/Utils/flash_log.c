@@ -0,0 +1,884 @@
+/*
+ * flash_log.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+#include "stm32f4xx_hal.h"
+#include "flash_log.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "cmsis_os2.h"
+#include "app_tasks.h"
+#include "ota.h"
+#include "flash_ctrl.h"
+#include "job_worker.h"
+#include "kv_store.h"
+#include "telemetry.h"
+#include "ts_codec.h"
+#include "msg_pool.h"
+#include "cli_registry.h"
+#include "uart_logger.h"
+#include <string.h>
+
+#define FLASH_LOG_BLANK          0xFFFFFFFFU
+#define FLASH_LOG_CHANNELS       SENSOR_COUNT
+#define FLASH_LOG_HEADER_WORDS   (sizeof(FlashLogHeader_t) / 4)
+#define FLASH_LOG_DUMP_FRAME_SIZE MSG_POOL_LARGE_SIZE
+
+_Static_assert(sizeof(FlashLogHeader_t) == 24, "entry header is six words");
+_Static_assert(TELEMETRY_HEADER_SIZE + FLASH_LOG_PAYLOAD_MAX + TELEMETRY_CRC_SIZE <= FLASH_LOG_DUMP_FRAME_SIZE,
+               "an entry payload fits one export frame");
+
+typedef struct {
+	uint32_t base;
+	uint32_t sector;             // FLASH_SECTOR_x
+} FlashLogSector_t;
+
+static const FlashLogSector_t log_sectors[FLASH_LOG_SECTORS] = {
+	{ 0x08004000, FLASH_SECTOR_1 },
+	{ 0x08008000, FLASH_SECTOR_2 },
+};
+
+// An entry being assembled, laid out exactly as it will be programmed
+typedef struct {
+	FlashLogHeader_t hdr;
+	uint8_t payload[FLASH_LOG_PAYLOAD_MAX];
+} FlashLogBlock_t;
+
+// Index points are every 'stride'-th entry, oldest first. When the table
+// fills, every other point is dropped and the stride doubles, so it always
+// spans the whole log; a lookup is a binary search plus a walk of at most
+// 'stride' entries.
+typedef struct {
+	uint32_t t_first;
+	uint32_t addr;
+} FlashLogPoint_t;
+
+#define FLASH_LOG_PERIOD_KEY     "log.period"
+
+static const osMutexAttr_t log_lock_attr = {
+	.name = "FlashLog",
+	.attr_bits = osMutexRecursive
+};
+
+// Flash layout, owned by whoever holds log_lock
+static osMutexId_t log_lock;
+static FlashLogRotateFunc_t rotate_hook;
+static FlashLogBlock_t record_block;             // Staging for flash_log_append_record()
+static FlashLogBlock_t carry_block;              // Staging for the rotate hook
+static uint32_t head;                            // Sector being appended to
+static uint32_t used_end[FLASH_LOG_SECTORS];     // First unused address in each sector
+static uint32_t next_seq;
+static uint32_t newest_s;
+static FlashLogPoint_t points[FLASH_LOG_INDEX_SIZE];
+static uint32_t point_count;
+static uint32_t stride = 1;
+static uint32_t since_point;
+
+// RAM side, shared between the aggregate stage and the writer job; block
+// hand-over happens in short critical sections
+static FlashLogBlock_t blocks[2];
+static TsCodec_t codec;                          // Encoding into blocks[fill]
+static uint8_t fill;
+static volatile bool sealed[2];
+static volatile bool write_queued;
+
+// Log clock: seconds carried on from the newest logged sample, advanced by
+// the ms difference between samples so the 49.7-day wrap of the uint32 ms
+// clock does not stop it
+static uint32_t log_base_s;
+static uint32_t clock_s;
+static uint32_t clock_rem_ms;
+static uint32_t clock_last_ms;
+
+// Period averaging, aggregate stage only
+static volatile uint32_t period_s = FLASH_LOG_DEFAULT_PERIOD_S;
+static bool bucket_open;
+static uint32_t bucket_s;
+static uint32_t min_bucket_s;                    // Next bucket starts no earlier
+static float sums[FLASH_LOG_CHANNELS];
+static uint32_t counts[FLASH_LOG_CHANNELS];
+static float last_values[FLASH_LOG_CHANNELS];
+
+static bool log_ready = false;
+static bool boot_overlap = false;                // Sector 1 holds bootloader code: never write
+static FlashLogStats_t stats;
+
+static uint32_t sector_end(uint32_t n)
+{
+	return log_sectors[n].base + FLASH_LOG_SECTOR_SIZE;
+}
+
+static uint32_t entry_size(uint32_t len)
+{
+	return sizeof(FlashLogHeader_t) + ((len + 3) & ~3U);
+}
+
+// Covers the header from 'len' on, and the payload in whole words
+static uint32_t entry_crc(const FlashLogHeader_t *hdr, const uint8_t *payload)
+{
+	uint32_t crc = crc32_update_words(0xFFFFFFFF, &((const uint32_t *)hdr)[1], FLASH_LOG_HEADER_WORDS - 2);
+	crc = crc32_update_words(crc, (const uint32_t *)payload, (hdr->len + 3) / 4);
+	return ~crc;
+}
+
+static bool region_blank(uint32_t addr, uint32_t end)
+{
+	for (; addr < end; addr += 4) {
+		if (*(const uint32_t *)addr != FLASH_LOG_BLANK) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool program_words(uint32_t addr, const uint32_t *words, uint32_t count)
+{
+	for (uint32_t i = 0; i < count; i++) {
+		if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, addr + i * 4, words[i]) != HAL_OK) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Takes the flash controller from OTA and the metadata journal until flash_end()
+static bool flash_begin(void)
+{
+	flash_ctrl_lock();
+	__HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_EOP | FLASH_FLAG_OPERR | FLASH_FLAG_WRPERR |
+	                       FLASH_FLAG_PGAERR | FLASH_FLAG_PGPERR | FLASH_FLAG_PGSERR);
+	if (HAL_FLASH_Unlock() == HAL_OK) {
+		return true;
+	}
+	flash_ctrl_unlock();
+	return false;
+}
+
+static void flash_end(void)
+{
+	HAL_FLASH_Lock();
+	flash_ctrl_unlock();
+}
+
+// Cursor over valid entries in log order, oldest sector first
+typedef struct {
+	uint32_t sector;
+	uint32_t addr;
+} LogCursor_t;
+
+static LogCursor_t cursor_oldest(void)
+{
+	uint32_t oldest = (head + 1) % FLASH_LOG_SECTORS;
+	return (LogCursor_t){ oldest, log_sectors[oldest].base };
+}
+
+static uint32_t sector_of(uint32_t addr)
+{
+	return (addr - log_sectors[0].base) / FLASH_LOG_SECTOR_SIZE;
+}
+
+// Next valid entry in sector 'n' at or after *addr, or NULL at its end
+static const FlashLogHeader_t *sector_next(uint32_t n, uint32_t *addr)
+{
+	while (*addr + sizeof(FlashLogHeader_t) <= used_end[n]) {
+		const FlashLogHeader_t *hdr = (const FlashLogHeader_t *)*addr;
+		if (hdr->len > FLASH_LOG_PAYLOAD_MAX) {
+			break;
+		}
+		*addr += entry_size(hdr->len);
+		if (hdr->magic == FLASH_LOG_MAGIC) {
+			return hdr;
+		}
+	}
+	*addr = used_end[n];
+	return NULL;
+}
+
+static const FlashLogHeader_t *cursor_next(LogCursor_t *cur)
+{
+	for (;;) {
+		const FlashLogHeader_t *hdr = sector_next(cur->sector, &cur->addr);
+		if (hdr != NULL || cur->sector == head) {
+			return hdr;
+		}
+		cur->sector = (cur->sector + 1) % FLASH_LOG_SECTORS;
+		cur->addr = log_sectors[cur->sector].base;
+	}
+}
+
+static void index_add(uint32_t t_first, uint32_t addr)
+{
+	if (since_point == 0) {
+		if (point_count == FLASH_LOG_INDEX_SIZE) {
+			for (uint32_t i = 0; i < FLASH_LOG_INDEX_SIZE / 2; i++) {
+				points[i] = points[i * 2];
+			}
+			point_count = FLASH_LOG_INDEX_SIZE / 2;
+			stride *= 2;
+		}
+		points[point_count++] = (FlashLogPoint_t){ t_first, addr };
+	}
+	since_point = (since_point + 1) % stride;
+}
+
+// The sector about to be erased is always the oldest, so its points lead
+static void index_drop_sector(uint32_t n)
+{
+	uint32_t drop = 0;
+
+	while (drop < point_count && sector_of(points[drop].addr) == n) {
+		drop++;
+	}
+	memmove(points, &points[drop], (point_count - drop) * sizeof(FlashLogPoint_t));
+	point_count -= drop;
+}
+
+// Last point at or before 't', or the oldest entry if there is none
+static LogCursor_t index_seek(uint32_t t)
+{
+	uint32_t lo = 0;
+	uint32_t hi = point_count;
+
+	while (lo < hi) {
+		uint32_t mid = (lo + hi) / 2;
+		if (points[mid].t_first <= t) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	if (lo == 0) {
+		return cursor_oldest();
+	}
+	return (LogCursor_t){ sector_of(points[lo - 1].addr), points[lo - 1].addr };
+}
+
+// Walks one sector at boot: counts entries, zeroes the magic of any that
+// fail their CRC, and finds where appending can resume
+static void sector_scan(uint32_t n, uint32_t *max_seq, bool *found)
+{
+	uint32_t addr = log_sectors[n].base;
+	uint32_t end = sector_end(n);
+
+	while (addr + sizeof(FlashLogHeader_t) <= end) {
+		const FlashLogHeader_t *hdr = (const FlashLogHeader_t *)addr;
+		const uint32_t *words = (const uint32_t *)addr;
+
+		if (words[0] == FLASH_LOG_BLANK && words[1] == FLASH_LOG_BLANK) {
+			break;
+		}
+		if (hdr->len > FLASH_LOG_PAYLOAD_MAX || addr + entry_size(hdr->len) > end) {
+			// Torn length word: nothing after it can be trusted
+			addr = end;
+			break;
+		}
+
+		if (hdr->magic != FLASH_LOG_MAGIC) {
+			stats.torn++;
+		} else if (entry_crc(hdr, (const uint8_t *)(hdr + 1)) != hdr->crc) {
+			stats.corrupt++;
+			uint32_t zero = 0;
+			if (flash_begin()) {
+				program_words(addr, &zero, 1);
+				flash_end();
+			}
+		} else if (!*found || hdr->seq > *max_seq) {
+			*max_seq = hdr->seq;
+			*found = true;
+			head = n;
+		}
+		addr += entry_size(hdr->len);
+	}
+
+	// Programmed words past the last entry mean a write we cannot parse
+	if (!region_blank(addr, end)) {
+		addr = end;
+	}
+	used_end[n] = addr;
+}
+
+// Bootloaders built before their linker region was cut to sector 0 may
+// run on into sector 1. Their reset vector pointing past sector 0, or code
+// filling sector 0 to its last word and carrying on into sector 1 where no
+// log entry header parses, means the log must keep its hands off.
+static bool bootloader_overlaps(void)
+{
+	const uint32_t *boot = (const uint32_t *)FLASH_BASE;
+	const uint32_t *head_words = (const uint32_t *)log_sectors[0].base;
+	const FlashLogHeader_t *hdr = (const FlashLogHeader_t *)log_sectors[0].base;
+
+	if (boot[1] >= log_sectors[0].base && boot[1] < sector_end(FLASH_LOG_SECTORS - 1)) {
+		return true;
+	}
+	if (head_words[-1] == FLASH_LOG_BLANK ||
+	    (head_words[0] == FLASH_LOG_BLANK && head_words[1] == FLASH_LOG_BLANK)) {
+		return false;
+	}
+	// A first entry may be whole, torn (no magic yet) or zeroed at a past boot
+	bool magic_ok = hdr->magic == FLASH_LOG_MAGIC || hdr->magic == FLASH_LOG_BLANK || hdr->magic == 0;
+	bool type_ok = hdr->type == FLASH_LOG_TYPE_SAMPLES || hdr->type == FLASH_LOG_TYPE_KV;
+	return !(magic_ok && type_ok && hdr->len <= FLASH_LOG_PAYLOAD_MAX);
+}
+
+void flash_log_init(void)
+{
+	uint32_t max_seq = 0;
+	bool found = false;
+
+	log_lock = osMutexNew(&log_lock_attr);
+
+	// Not even the boot scan may write: it zeroes the magic of bad entries
+	if (bootloader_overlaps()) {
+		boot_overlap = true;
+		for (uint32_t n = 0; n < FLASH_LOG_SECTORS; n++) {
+			used_end[n] = log_sectors[n].base;
+		}
+		return;
+	}
+
+	head = 0;
+	for (uint32_t n = 0; n < FLASH_LOG_SECTORS; n++) {
+		sector_scan(n, &max_seq, &found);
+	}
+	next_seq = found ? max_seq + 1 : 0;
+
+	LogCursor_t cur = cursor_oldest();
+	const FlashLogHeader_t *hdr;
+	while ((hdr = cursor_next(&cur)) != NULL) {
+		if (hdr->type == FLASH_LOG_TYPE_SAMPLES) {
+			index_add(hdr->t_first, (uint32_t)hdr);
+			newest_s = hdr->t_last;
+		}
+		stats.entries++;
+	}
+
+	// Carry log time on from the newest sample
+	log_base_s = (stats.entries > 0) ? newest_s + 1 : 0;
+	min_bucket_s = log_base_s;
+	clock_last_ms = xTaskGetTickCount() * portTICK_PERIOD_MS;
+	clock_s = log_base_s + clock_last_ms / 1000;
+	clock_rem_ms = clock_last_ms % 1000;
+
+	ts_encoder_init(&codec, blocks[0].payload, FLASH_LOG_PAYLOAD_MAX, FLASH_LOG_CHANNELS);
+	log_ready = true;
+}
+
+// Erases the oldest sector and makes it the head. Its entries leave the
+// index and the counts only once the erase has happened, so a refused
+// hook or a failed erase leaves both describing what is still in flash.
+static bool log_rotate(void)
+{
+	uint32_t next = (head + 1) % FLASH_LOG_SECTORS;
+	uint32_t addr = log_sectors[next].base;
+	uint32_t dropped = 0;
+
+	while (sector_next(next, &addr) != NULL) {
+		dropped++;
+	}
+
+	if (rotate_hook != NULL && !rotate_hook(log_sectors[next].base, sector_end(next))) {
+		return false;
+	}
+
+	if (!region_blank(log_sectors[next].base, sector_end(next))) {
+		FLASH_EraseInitTypeDef erase = {
+			.TypeErase = FLASH_TYPEERASE_SECTORS,
+			.VoltageRange = FLASH_VOLTAGE_RANGE_3,
+			.Sector = log_sectors[next].sector,
+			.NbSectors = 1
+		};
+		uint32_t sector_error;
+		if (HAL_FLASHEx_Erase(&erase, &sector_error) != HAL_OK) {
+			return false;
+		}
+		stats.erases++;
+	}
+	stats.entries -= dropped;
+	index_drop_sector(next);
+
+	head = next;
+	used_end[next] = log_sectors[next].base;
+	return true;
+}
+
+// Programs one sealed block and returns its address, or 0. The length goes
+// first and the magic last, so an interrupted write is recognisable at boot.
+// Only carried records may use the reserve, and they never rotate.
+static uint32_t log_append(FlashLogBlock_t *block, bool carry)
+{
+	FlashLogHeader_t *hdr = &block->hdr;
+	uint32_t size = entry_size(hdr->len);
+	uint32_t reserve = carry ? 0 : FLASH_LOG_RESERVE;
+
+	if (used_end[head] + size > sector_end(head) - reserve) {
+		if (carry || !log_rotate()) {
+			return 0;
+		}
+	}
+
+	uint32_t addr = used_end[head];
+	const uint32_t *words = (const uint32_t *)block;
+	hdr->magic = FLASH_LOG_MAGIC;
+	hdr->seq = next_seq;
+	hdr->crc = entry_crc(hdr, block->payload);
+
+	// Reserve the space before programming anything, so a failed write is
+	// stepped over rather than overwritten
+	used_end[head] = addr + size;
+
+	bool ok = program_words(addr + 4, &words[1], 1) &&
+	          program_words(addr + sizeof(FlashLogHeader_t), (const uint32_t *)block->payload, (hdr->len + 3) / 4) &&
+	          program_words(addr + 8, &words[2], FLASH_LOG_HEADER_WORDS - 2) &&
+	          program_words(addr, &words[0], 1);
+	if (!ok) {
+		// Walkers stop at a blank length, so retire the rest of the sector
+		used_end[head] = sector_end(head);
+		return 0;
+	}
+
+	next_seq++;
+	if (hdr->type == FLASH_LOG_TYPE_SAMPLES) {
+		newest_s = hdr->t_last;
+		index_add(hdr->t_first, addr);
+	}
+	stats.entries++;
+	return addr;
+}
+
+static bool flash_log_write_job(Job_t *job, void *arg)
+{
+	// Cleared before looking, so a block sealed from here on queues a new job
+	write_queued = false;
+
+	// Stay out of the way of an update in flight: a log erase would stall
+	// the stream. flash_begin() is what keeps the controller itself safe.
+	if (ota_state != OTA_STATE_IDLE) {
+		return true;
+	}
+
+	osMutexAcquire(log_lock, osWaitForever);
+	for (uint32_t n = 0; n < 2; n++) {
+		if (!sealed[n]) {
+			continue;
+		}
+		if (flash_begin()) {
+			if (log_append(&blocks[n], false) != 0) {
+				stats.blocks_written++;
+			} else {
+				stats.write_errors++;
+			}
+			flash_end();
+		} else {
+			stats.write_errors++;
+		}
+		sealed[n] = false;
+	}
+	osMutexRelease(log_lock);
+	return true;
+}
+
+static void writer_kick(void)
+{
+	if ((sealed[0] || sealed[1]) && !write_queued && ota_state == OTA_STATE_IDLE) {
+		write_queued = true;
+		if (job_submit("flashlog", flash_log_write_job, NULL) == 0) {
+			write_queued = false;
+		}
+	}
+}
+
+// Caller holds a critical section
+static void block_seal(void)
+{
+	FlashLogBlock_t *block = &blocks[fill];
+	uint32_t len = ts_encoder_bytes(&codec);
+
+	memset(&block->payload[len], 0xFF, ((len + 3) & ~3U) - len);
+	block->hdr.len = (uint16_t)len;
+	block->hdr.type = FLASH_LOG_TYPE_SAMPLES;
+	block->hdr.count = (uint8_t)codec.count;
+	sealed[fill] = true;
+
+	fill ^= 1;
+	ts_encoder_init(&codec, blocks[fill].payload, FLASH_LOG_PAYLOAD_MAX, FLASH_LOG_CHANNELS);
+}
+
+// Caller holds a critical section
+static bool block_add(uint32_t t, const float *values)
+{
+	if (codec.count == UINT8_MAX || !ts_encoder_add(&codec, t, values)) {
+		// Full: hand it to the writer, unless the other block is still waiting
+		if (sealed[fill ^ 1]) {
+			return false;
+		}
+		block_seal();
+		ts_encoder_add(&codec, t, values);
+	}
+
+	if (codec.count == 1) {
+		blocks[fill].hdr.t_first = t;
+	}
+	blocks[fill].hdr.t_last = t;
+	return true;
+}
+
+static void bucket_emit(void)
+{
+	float values[FLASH_LOG_CHANNELS];
+
+	// A channel with no samples this period repeats its last value
+	for (uint32_t ch = 0; ch < FLASH_LOG_CHANNELS; ch++) {
+		if (counts[ch] > 0) {
+			last_values[ch] = sums[ch] / (float)counts[ch];
+		}
+		values[ch] = last_values[ch];
+	}
+
+	taskENTER_CRITICAL();
+	bool ok = block_add(bucket_s, values);
+	taskEXIT_CRITICAL();
+
+	if (ok) {
+		stats.samples_logged++;
+	} else {
+		stats.samples_dropped++;
+	}
+	min_bucket_s = bucket_s + 1;
+	bucket_open = false;
+	writer_kick();
+}
+
+void flash_log_add(SensorId_t id, float value, uint32_t time_ms)
+{
+	if (!log_ready || id >= FLASH_LOG_CHANNELS) {
+		return;
+	}
+
+	// A sample stamped before the previous one (another source) does not
+	// move the clock back
+	uint32_t delta = time_ms - clock_last_ms;
+	if ((int32_t)delta > 0) {
+		taskENTER_CRITICAL();    // Against flash_log_now()
+		clock_rem_ms += delta;
+		clock_s += clock_rem_ms / 1000;
+		clock_rem_ms %= 1000;
+		clock_last_ms = time_ms;
+		taskEXIT_CRITICAL();
+	}
+
+	uint32_t t = clock_s;
+	uint32_t period = period_s;
+	uint32_t start = t - (t % period);
+
+	// Keep bucket times increasing across resets and period changes
+	uint32_t min_start = bucket_open ? bucket_s : min_bucket_s;
+	if (start < min_start) {
+		start = min_start;
+	}
+
+	if (bucket_open && start != bucket_s) {
+		bucket_emit();
+	}
+	if (!bucket_open) {
+		bucket_open = true;
+		bucket_s = start;
+		memset(sums, 0, sizeof(sums));
+		memset(counts, 0, sizeof(counts));
+	}
+	sums[id] += value;
+	counts[id]++;
+}
+
+bool flash_log_flush(void)
+{
+	bool ok = true;
+
+	taskENTER_CRITICAL();
+	if (codec.count > 0) {
+		ok = !sealed[fill ^ 1];
+		if (ok) {
+			block_seal();
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	writer_kick();
+	return ok;
+}
+
+void flash_log_set_period(uint32_t seconds)
+{
+	period_s = (seconds == 0) ? 1 : seconds;
+}
+
+void flash_log_load_settings(void)
+{
+	flash_log_set_period(kv_get_u32(FLASH_LOG_PERIOD_KEY, FLASH_LOG_DEFAULT_PERIOD_S));
+}
+
+void flash_log_lock(void)
+{
+	osMutexAcquire(log_lock, osWaitForever);
+}
+
+void flash_log_unlock(void)
+{
+	osMutexRelease(log_lock);
+}
+
+void flash_log_set_rotate_hook(FlashLogRotateFunc_t fn)
+{
+	rotate_hook = fn;
+}
+
+static void record_stage(FlashLogBlock_t *block, uint8_t type, const void *payload, uint32_t len)
+{
+	memset(&block->hdr, 0, sizeof(block->hdr));
+	block->hdr.len = (uint16_t)len;
+	block->hdr.type = type;
+	block->hdr.count = 1;
+	memcpy(block->payload, payload, len);
+	memset(&block->payload[len], 0xFF, ((len + 3) & ~3U) - len);
+}
+
+uint32_t flash_log_append_record(uint8_t type, const void *payload, uint32_t len)
+{
+	uint32_t addr = 0;
+
+	if (len > FLASH_LOG_PAYLOAD_MAX || type == FLASH_LOG_TYPE_SAMPLES) {
+		return 0;
+	}
+
+	osMutexAcquire(log_lock, osWaitForever);
+	if (log_ready && ota_state == OTA_STATE_IDLE && flash_begin()) {
+		record_stage(&record_block, type, payload, len);
+		addr = log_append(&record_block, false);
+		flash_end();
+	}
+	if (addr == 0) {
+		stats.write_errors++;
+	}
+	osMutexRelease(log_lock);
+	return addr;
+}
+
+// Only from the rotate hook: the lock is held and flash is unlocked
+uint32_t flash_log_carry_record(const FlashLogHeader_t *hdr)
+{
+	record_stage(&carry_block, hdr->type, hdr + 1, hdr->len);
+	return log_append(&carry_block, true);
+}
+
+void flash_log_walk(uint8_t type, FlashLogRecordFunc_t fn, void *arg)
+{
+	osMutexAcquire(log_lock, osWaitForever);
+	LogCursor_t cur = cursor_oldest();
+	const FlashLogHeader_t *hdr;
+	while ((hdr = cursor_next(&cur)) != NULL) {
+		if (hdr->type == type) {
+			fn(hdr, arg);
+		}
+	}
+	osMutexRelease(log_lock);
+}
+
+uint32_t flash_log_now(void)
+{
+	uint32_t now_ms = xTaskGetTickCount() * portTICK_PERIOD_MS;
+
+	taskENTER_CRITICAL();
+	int32_t since = (int32_t)(now_ms - clock_last_ms);
+	uint32_t s = clock_s + (clock_rem_ms + ((since > 0) ? (uint32_t)since : 0)) / 1000;
+	taskEXIT_CRITICAL();
+	return s;
+}
+
+static const FlashLogHeader_t *range_next(LogCursor_t *cur, uint32_t from, uint32_t to);
+
+void flash_log_get_stats(FlashLogStats_t *out)
+{
+	osMutexAcquire(log_lock, osWaitForever);
+	*out = stats;
+	out->boot_overlap = boot_overlap;
+	out->period_s = period_s;
+	out->bytes_total = FLASH_LOG_SECTORS * FLASH_LOG_SECTOR_SIZE;
+	out->bytes_used = 0;
+	for (uint32_t n = 0; n < FLASH_LOG_SECTORS; n++) {
+		out->bytes_used += used_end[n] - log_sectors[n].base;
+	}
+	LogCursor_t cur = cursor_oldest();
+	const FlashLogHeader_t *oldest = range_next(&cur, 0, UINT32_MAX);
+	out->oldest_s = (oldest != NULL) ? oldest->t_first : 0;
+	out->newest_s = newest_s;
+	out->next_seq = next_seq;
+	out->index_points = point_count;
+	out->index_stride = stride;
+	osMutexRelease(log_lock);
+
+	out->now_s = flash_log_now();
+	taskENTER_CRITICAL();
+	out->pending_samples = codec.count;
+	for (uint32_t n = 0; n < 2; n++) {
+		out->pending_samples += sealed[n] ? blocks[n].hdr.count : 0;
+	}
+	taskEXIT_CRITICAL();
+}
+
+// Entries overlapping [from, to], oldest first. Caller holds log_lock.
+static const FlashLogHeader_t *range_next(LogCursor_t *cur, uint32_t from, uint32_t to)
+{
+	const FlashLogHeader_t *hdr;
+
+	while ((hdr = cursor_next(cur)) != NULL) {
+		if (hdr->type != FLASH_LOG_TYPE_SAMPLES) {
+			continue;
+		}
+		if (hdr->t_first > to) {
+			return NULL;
+		}
+		if (hdr->t_last >= from) {
+			return hdr;
+		}
+	}
+	return NULL;
+}
+
+uint32_t flash_log_query(uint32_t from, uint32_t to, FlashLogVisitFunc_t fn, void *arg)
+{
+	uint32_t visited = 0;
+
+	osMutexAcquire(log_lock, osWaitForever);
+	LogCursor_t cur = index_seek(from);
+	const FlashLogHeader_t *hdr;
+	while ((hdr = range_next(&cur, from, to)) != NULL) {
+		TsCodec_t dec;
+		uint32_t t;
+		float values[FLASH_LOG_CHANNELS];
+
+		ts_decoder_init(&dec, (const uint8_t *)(hdr + 1), hdr->len, FLASH_LOG_CHANNELS);
+		for (uint32_t k = 0; k < hdr->count && ts_decoder_next(&dec, &t, values); k++) {
+			if (t >= from && t <= to) {
+				fn(t, values, arg);
+				visited++;
+			}
+		}
+	}
+	osMutexRelease(log_lock);
+	return visited;
+}
+
+// Erases every sample; records carried by the rotate hook survive, and
+// sequence numbers and log time carry on
+static bool flash_log_erase_all(void)
+{
+	bool ok = true;
+
+	osMutexAcquire(log_lock, osWaitForever);
+	if (!log_ready || ota_state != OTA_STATE_IDLE || !flash_begin()) {
+		osMutexRelease(log_lock);
+		return false;
+	}
+	for (uint32_t n = 0; n < FLASH_LOG_SECTORS && ok; n++) {
+		ok = log_rotate();
+	}
+	flash_end();
+	point_count = 0;
+	stride = 1;
+	since_point = 0;
+	osMutexRelease(log_lock);
+	return ok;
+}
+
+static void print_sample(uint32_t t, const float *values, void *arg)
+{
+	log_printf("%lu,%.2f,%.2f\r\n", t, values[SENSOR_TEMPERATURE], values[SENSOR_PRESSURE]);
+}
+
+// Sends each entry overlapping [from, to] as a TELEMETRY_FRAME_FLASHLOG
+// frame, payload copied straight from flash without decoding
+static void flash_log_dump(uint32_t from, uint32_t to)
+{
+	uint8_t *frame = msg_pool_alloc(FLASH_LOG_DUMP_FRAME_SIZE, 100);
+	if (frame == NULL) {
+		log_printf("No buffer for flash log export\r\n");
+		return;
+	}
+
+	log_printf("# flashlog dump %lu..%lu\r\n", from, to);
+
+	uint16_t frames = 0;
+	uint32_t samples = 0;
+	osMutexAcquire(log_lock, osWaitForever);
+	LogCursor_t cur = index_seek(from);
+	const FlashLogHeader_t *hdr;
+	while ((hdr = range_next(&cur, from, to)) != NULL) {
+		memcpy(&frame[TELEMETRY_HEADER_SIZE], hdr + 1, hdr->len);
+		uint16_t len = telemetry_frame_seal(frame, TELEMETRY_FRAME_FLASHLOG, hdr->count, frames++,
+		                                    hdr->t_first, hdr->len);
+		uart_logger_write(frame, len);
+		samples += hdr->count;
+	}
+	osMutexRelease(log_lock);
+	msg_pool_free(frame);
+
+	log_printf("# %lu samples in %u frames\r\n", samples, frames);
+}
+
+static void flash_log_show(void)
+{
+	FlashLogStats_t s;
+	flash_log_get_stats(&s);
+
+	if (s.boot_overlap) {
+		log_printf("Flash log: off, sector 1 holds bootloader code; update the bootloader\r\n");
+		return;
+	}
+	log_printf("Flash log: %lu entries, %lu/%lu bytes, seq %lu, period %lu s\r\n",
+	           s.entries, s.bytes_used, s.bytes_total, s.next_seq, s.period_s);
+	log_printf("  Log time: now %lu s, oldest %lu s, newest %lu s\r\n", s.now_s, s.oldest_s, s.newest_s);
+	log_printf("  Samples: %lu logged, %lu in RAM, %lu dropped\r\n",
+	           s.samples_logged, s.pending_samples, s.samples_dropped);
+	log_printf("  Flash: %lu blocks written, %lu erases, %lu write errors\r\n",
+	           s.blocks_written, s.erases, s.write_errors);
+	log_printf("  Index: %lu points, 1 per %lu entries; at boot %lu torn, %lu corrupt\r\n",
+	           s.index_points, s.index_stride, s.torn, s.corrupt);
+}
+
+// flashlog | flashlog read|dump [span_s] [end_ago_s] | flashlog flush|erase | flashlog period <s>
+CLI_COMMAND(flashlog, "|suu", "[read|dump [span_s] [end_ago_s] | flush | erase | period <s>]",
+            "Sensor log kept in flash across resets")
+{
+	if (args->count == 0) {
+		flash_log_show();
+		return;
+	}
+
+	const char *op = args->v[0].s;
+	if (strcmp(op, "read") == 0 || strcmp(op, "dump") == 0) {
+		uint32_t now = flash_log_now();
+		uint32_t span = (args->count > 1) ? args->v[1].u : 3600;
+		uint32_t end_ago = (args->count > 2) ? args->v[2].u : 0;
+		uint32_t to = (end_ago < now) ? now - end_ago : 0;
+		uint32_t from = (span < to) ? to - span : 0;
+
+		if (op[0] == 'd') {
+			flash_log_dump(from, to);
+		} else {
+			log_printf("# log_s,temp,pressure\r\n");
+			uint32_t count = flash_log_query(from, to, print_sample, NULL);
+			log_printf("# %lu samples\r\n", count);
+		}
+	} else if (strcmp(op, "flush") == 0 && args->count == 1) {
+		log_printf(flash_log_flush() ? "Flash log block queued for writing\r\n" : "Writer busy, try again\r\n");
+	} else if (strcmp(op, "erase") == 0 && args->count == 1) {
+		log_printf(flash_log_erase_all() ? "Flash log erased\r\n" : "Flash log erase failed\r\n");
+	} else if (strcmp(op, "period") == 0 && args->count == 2) {
+		flash_log_set_period(args->v[1].u);
+		bool saved = kv_set_u32(FLASH_LOG_PERIOD_KEY, period_s);
+		log_printf("Flash log period %lu s%s\r\n", period_s, saved ? "" : " (not saved)");
+	} else {
+		log_printf("Usage: flashlog [read|dump [span_s] [end_ago_s] | flush | erase | period <s>]\r\n");
+	}
+}
@@ -0,0 +1,146 @@
+/*
+ * flash_log.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+
+#ifndef FLASH_LOG_H_
+#define FLASH_LOG_H_
+
+#include "sensor_sched.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Append-only sensor log in flash sectors 1 and 2, which sit between the
+// bootloader and the boot metadata and are otherwise unused. Samples are
+// averaged over a period and Gorilla-compressed into a 256-byte block in
+// RAM; a full block is programmed as one entry, so flash sees a program
+// burst every few minutes rather than a write per sample. The sectors are
+// used as a ring: when the newest is full the older one is erased, so the
+// log always holds between one and two sectors of history.
+//
+// Entry layout, word aligned:
+//   0  magic       FLASH_LOG_MAGIC, programmed last
+//   4  len         uint16 payload bytes, programmed first
+//   6  type        FLASH_LOG_TYPE_*
+//   7  count       samples in the payload
+//   8  seq         uint32, +1 per entry across sectors and resets
+//  12  t_first     log time of the first sample, seconds
+//  16  t_last      log time of the last sample
+//  20  crc         CRC-32 of bytes 4..19 and the payload words
+//  24  payload     ts_codec bitstream of (log time, temp, pressure)
+//
+// Power loss while programming leaves an entry with a length but no magic;
+// the scan at boot steps over it, zeroes the magic of any entry that fails
+// its CRC, and resumes appending at the first blank word. Only the block
+// still in RAM is lost.
+//
+// Other stores can keep their own record types in the same sectors (the
+// settings store in kv_store.c does). Appends stop FLASH_LOG_RESERVE bytes
+// short of a sector's end; the reserve takes the records a rotate hook
+// carries forward out of the sector about to be erased, so live records
+// survive rotation and are never only in RAM.
+//
+// Log time is seconds of uptime carried on from the newest entry found at
+// boot, so it increases across resets; time spent powered off is not in it.
+// It advances by the difference between sample times, so it keeps running
+// when the 32-bit ms tick wraps after 49.7 days.
+//
+// The bootloader must be updated before the first app with the log: one
+// linked when its region was 32K may extend into sector 1, and OTA only
+// replaces the app. flash_log_init() checks for that and leaves both
+// sectors alone (the log and settings are then off) if it finds code there.
+//
+// Flash endurance is 10k erases per sector. At the default 10 s period an
+// entry holds about 36 samples, a sector fills in about 6 hours and each is
+// erased every 13 hours or so: some 14 years of continuous logging. Each
+// erase stalls the CPU for a few hundred ms, as OTA erases already do.
+
+#define FLASH_LOG_SECTORS        2
+#define FLASH_LOG_SECTOR_SIZE    (16U * 1024U)
+#define FLASH_LOG_BLOCK_SIZE     256     // Header plus payload of one entry
+#define FLASH_LOG_MAGIC          0x4C4F4753U
+#define FLASH_LOG_TYPE_SAMPLES   1
+#define FLASH_LOG_TYPE_KV        2
+#define FLASH_LOG_RESERVE        3072    // Per sector, for records carried on rotation
+#define FLASH_LOG_INDEX_SIZE     64      // Sparse block index; see flash_log.c
+#define FLASH_LOG_DEFAULT_PERIOD_S 10
+
+typedef struct {
+	uint32_t magic;
+	uint16_t len;
+	uint8_t type;
+	uint8_t count;
+	uint32_t seq;
+	uint32_t t_first;
+	uint32_t t_last;
+	uint32_t crc;
+} FlashLogHeader_t;
+
+#define FLASH_LOG_PAYLOAD_MAX    (FLASH_LOG_BLOCK_SIZE - sizeof(FlashLogHeader_t))
+
+typedef struct {
+	uint32_t period_s;
+	uint32_t entries;            // Valid entries in flash
+	uint32_t bytes_used;
+	uint32_t bytes_total;
+	uint32_t oldest_s;
+	uint32_t newest_s;
+	uint32_t now_s;              // Current log time
+	uint32_t next_seq;
+	uint32_t index_points;
+	uint32_t index_stride;       // Entries per index point
+	uint32_t pending_samples;    // Encoded in RAM, not yet in flash
+	uint32_t samples_logged;
+	uint32_t samples_dropped;    // Both RAM blocks full
+	uint32_t blocks_written;
+	uint32_t erases;
+	uint32_t write_errors;
+	uint32_t torn;               // Found at boot without a magic
+	uint32_t corrupt;            // Found at boot with a bad CRC
+	bool boot_overlap;           // Log off: the bootloader runs into sector 1
+} FlashLogStats_t;
+
+// Scans flash and rebuilds the index; call before the heap is locked
+void flash_log_init(void);
+
+// Called from the aggregate stage for every sample; only touches RAM
+void flash_log_add(SensorId_t id, float value, uint32_t time_ms);
+
+// Seals the partial RAM block and queues it for programming
+bool flash_log_flush(void);
+void flash_log_set_period(uint32_t period_s);
+uint32_t flash_log_now(void);
+void flash_log_get_stats(FlashLogStats_t *stats);
+
+// Calls 'fn' for every sample with a log time in [from, to], oldest first,
+// using the index to skip straight to the first entry that can hold one.
+// Returns the number of samples visited.
+typedef void (*FlashLogVisitFunc_t)(uint32_t t, const float *values, void *arg);
+uint32_t flash_log_query(uint32_t from, uint32_t to, FlashLogVisitFunc_t fn, void *arg);
+
+// Record interface for stores sharing the log sectors. The lock is
+// recursive and must be held while reading records in place, since
+// rotation moves and erases them.
+void flash_log_lock(void);
+void flash_log_unlock(void);
+
+// Appends one record and returns its address, or 0 if flash is busy with
+// an OTA update or the write failed
+uint32_t flash_log_append_record(uint8_t type, const void *payload, uint32_t len);
+
+// Called with the lock held before the sector [base, end) is erased; it
+// must re-append every live record it owns there with
+// flash_log_carry_record(), and return false to stop the erase
+typedef bool (*FlashLogRotateFunc_t)(uint32_t base, uint32_t end);
+void flash_log_set_rotate_hook(FlashLogRotateFunc_t fn);
+uint32_t flash_log_carry_record(const FlashLogHeader_t *hdr);
+
+// Calls 'fn' for every record of 'type', oldest first
+typedef void (*FlashLogRecordFunc_t)(const FlashLogHeader_t *hdr, void *arg);
+void flash_log_walk(uint8_t type, FlashLogRecordFunc_t fn, void *arg);
+
+void flash_log_load_settings(void);
+
+#endif /* FLASH_LOG_H_ */
@@ -0,0 +1,168 @@
+/*
+ * job_worker.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+#include "job_worker.h"
+#include "uart_logger.h"
+
+struct Job {
+	uint32_t id;
+	const char *name;
+	JobFunc_t func;
+	void *arg;
+	volatile JobState_t state;
+	volatile uint8_t progress;
+	volatile bool cancel;
+};
+
+static Job_t jobs[JOB_MAX];
+static uint32_t next_job_id = 1;
+static osMessageQueueId_t jobQueue;
+
+static const osMutexAttr_t job_mutex_attr = {
+	.name = "JobMutex"
+};
+static osMutexId_t job_mutex;
+
+void job_worker_init(void)
+{
+	job_mutex = osMutexNew(&job_mutex_attr);
+	jobQueue = osMessageQueueNew(JOB_MAX, sizeof(Job_t *), NULL);
+	if (job_mutex == NULL || jobQueue == NULL) {
+		log_printf("Job worker creation failed\r\n");
+	}
+}
+
+uint32_t job_submit(const char *name, JobFunc_t func, void *arg)
+{
+	Job_t *job = NULL;
+	uint32_t id = 0;
+
+	if (osMutexAcquire(job_mutex, osWaitForever) != osOK) {
+		return 0;
+	}
+
+	// Finished jobs keep their slot until it is needed, so 'bg' can show results
+	for (uint32_t j = 0; j < JOB_MAX && job == NULL; j++) {
+		if (jobs[j].state == JOB_STATE_FREE) {
+			job = &jobs[j];
+		}
+	}
+	for (uint32_t j = 0; j < JOB_MAX && job == NULL; j++) {
+		JobState_t state = jobs[j].state;
+		if (state == JOB_STATE_DONE || state == JOB_STATE_FAILED || state == JOB_STATE_CANCELLED) {
+			job = &jobs[j];
+		}
+	}
+
+	if (job != NULL) {
+		job->id = next_job_id++;
+		job->name = name;
+		job->func = func;
+		job->arg = arg;
+		job->progress = 0;
+		job->cancel = false;
+		job->state = JOB_STATE_QUEUED;
+
+		if (osMessageQueuePut(jobQueue, &job, 0, 0) == osOK) {
+			id = job->id;
+		} else {
+			job->state = JOB_STATE_FREE;
+		}
+	}
+
+	osMutexRelease(job_mutex);
+	return id;
+}
+
+bool job_cancel(uint32_t id)
+{
+	bool found = false;
+
+	if (osMutexAcquire(job_mutex, osWaitForever) != osOK) {
+		return false;
+	}
+
+	for (uint32_t j = 0; j < JOB_MAX; j++) {
+		if (jobs[j].id == id && (jobs[j].state == JOB_STATE_QUEUED || jobs[j].state == JOB_STATE_RUNNING)) {
+			// A queued job is skipped by the worker; a running one sees the flag
+			jobs[j].cancel = true;
+			found = true;
+		}
+	}
+
+	osMutexRelease(job_mutex);
+	return found;
+}
+
+bool job_cancel_requested(const Job_t *job)
+{
+	return job->cancel;
+}
+
+void job_set_progress(Job_t *job, uint32_t done, uint32_t total)
+{
+	if (total > 0) {
+		job->progress = (uint8_t)((uint64_t)done * 100 / total);
+	}
+}
+
+uint32_t job_list(JobInfo_t *out, uint32_t max)
+{
+	uint32_t count = 0;
+
+	for (uint32_t j = 0; j < JOB_MAX && count < max; j++) {
+		if (jobs[j].state != JOB_STATE_FREE) {
+			out[count].id = jobs[j].id;
+			out[count].name = jobs[j].name;
+			out[count].state = jobs[j].state;
+			out[count].progress = jobs[j].progress;
+			count++;
+		}
+	}
+	return count;
+}
+
+const char *job_state_name(JobState_t state)
+{
+	switch (state) {
+		case JOB_STATE_QUEUED: return "QUEUED";
+		case JOB_STATE_RUNNING: return "RUNNING";
+		case JOB_STATE_DONE: return "DONE";
+		case JOB_STATE_FAILED: return "FAILED";
+		case JOB_STATE_CANCELLED: return "CANCELLED";
+		default: return "FREE";
+	}
+}
+
+void JobWorkerTaskFunc(void *argument)
+{
+	Job_t *job;
+
+	for (;;) {
+		if (osMessageQueueGet(jobQueue, &job, NULL, osWaitForever) != osOK) {
+			continue;
+		}
+
+		if (job->cancel) {
+			job->state = JOB_STATE_CANCELLED;
+			log_printf("[JOB %lu] %s cancelled before start\r\n", job->id, job->name);
+			continue;
+		}
+
+		job->state = JOB_STATE_RUNNING;
+		bool ok = job->func(job, job->arg);
+
+		if (job->cancel) {
+			job->state = JOB_STATE_CANCELLED;
+		} else {
+			job->state = ok ? JOB_STATE_DONE : JOB_STATE_FAILED;
+			if (ok) {
+				job->progress = 100;
+			}
+		}
+		log_printf("[JOB %lu] %s finished: %s\r\n", job->id, job->name, job_state_name(job->state));
+	}
+}
@@ -0,0 +1,52 @@
+/*
+ * job_worker.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+
+#ifndef JOB_WORKER_H_
+#define JOB_WORKER_H_
+
+#include "cmsis_os2.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Long-running CLI commands run on a low-priority worker so CLITask keeps
+// draining cliRxQueue. Jobs run one at a time in submission order.
+#define JOB_MAX         4
+
+typedef enum {
+	JOB_STATE_FREE,
+	JOB_STATE_QUEUED,
+	JOB_STATE_RUNNING,
+	JOB_STATE_DONE,
+	JOB_STATE_FAILED,
+	JOB_STATE_CANCELLED
+} JobState_t;
+
+typedef struct Job Job_t;
+
+// Returns true on success. Long jobs should call job_set_progress() and
+// return early when job_cancel_requested() turns true.
+typedef bool (*JobFunc_t)(Job_t *job, void *arg);
+
+typedef struct {
+	uint32_t id;
+	const char *name;
+	JobState_t state;
+	uint8_t progress;       // Percent complete
+} JobInfo_t;
+
+void job_worker_init(void);
+void JobWorkerTaskFunc(void *argument);
+
+// Returns the job ID, or 0 if the job table or queue is full
+uint32_t job_submit(const char *name, JobFunc_t func, void *arg);
+bool job_cancel(uint32_t id);
+bool job_cancel_requested(const Job_t *job);
+void job_set_progress(Job_t *job, uint32_t done, uint32_t total);
+uint32_t job_list(JobInfo_t *out, uint32_t max);
+const char *job_state_name(JobState_t state);
+
+#endif /* JOB_WORKER_H_ */
@@ -0,0 +1,337 @@
+/*
+ * kv_store.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+#include "kv_store.h"
+#include "flash_log.h"
+#include "cli_registry.h"
+#include "uart_logger.h"
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Record payload: this head, then the key (no terminator), then the value
+typedef struct {
+	uint8_t key_len;
+	uint8_t value_len;
+	uint8_t type;                // KvType_t
+	uint8_t reserved;
+} KvRecordHead_t;
+
+#define KV_RECORD_MAX            (sizeof(KvRecordHead_t) + KV_MAX_KEY_LEN + KV_MAX_VALUE_LEN)
+
+_Static_assert((KV_HASH_SLOTS & (KV_HASH_SLOTS - 1)) == 0 && KV_HASH_SLOTS > KV_MAX_KEYS,
+               "hash table is a power of two with a free slot");
+_Static_assert(KV_MAX_KEYS * (sizeof(FlashLogHeader_t) + ((KV_RECORD_MAX + 3) & ~3U)) <= FLASH_LOG_RESERVE,
+               "a full set of live records fits the log's rotation reserve");
+
+// Open addressing with linear probing; addr 0 marks an empty slot
+typedef struct {
+	uint32_t hash;
+	uint32_t addr;               // Newest record of the key, in flash
+} KvSlot_t;
+
+static KvSlot_t slots[KV_HASH_SLOTS];
+static KvStats_t stats;
+
+// FNV-1a
+static uint32_t key_hash(const char *key, uint32_t len)
+{
+	uint32_t h = 2166136261u;
+
+	for (uint32_t i = 0; i < len; i++) {
+		h = (h ^ (uint8_t)key[i]) * 16777619u;
+	}
+	return h;
+}
+
+static const KvRecordHead_t *record_head(uint32_t addr)
+{
+	return (const KvRecordHead_t *)(addr + sizeof(FlashLogHeader_t));
+}
+
+static const char *record_key(uint32_t addr)
+{
+	return (const char *)(record_head(addr) + 1);
+}
+
+static const uint8_t *record_value(uint32_t addr)
+{
+	return (const uint8_t *)record_key(addr) + record_head(addr)->key_len;
+}
+
+// Slot holding 'key', or the empty slot where it would go
+static KvSlot_t *slot_find(const char *key, uint32_t len, uint32_t hash)
+{
+	uint32_t i = hash & (KV_HASH_SLOTS - 1);
+
+	while (slots[i].addr != 0) {
+		if (slots[i].hash == hash && record_head(slots[i].addr)->key_len == len &&
+		    memcmp(record_key(slots[i].addr), key, len) == 0) {
+			break;
+		}
+		i = (i + 1) & (KV_HASH_SLOTS - 1);
+	}
+	return &slots[i];
+}
+
+// Backward-shift deletion keeps every probe chain unbroken without tombstones
+static void slot_remove(KvSlot_t *slot)
+{
+	uint32_t hole = (uint32_t)(slot - slots);
+	uint32_t i = hole;
+
+	for (;;) {
+		i = (i + 1) & (KV_HASH_SLOTS - 1);
+		if (slots[i].addr == 0) {
+			break;
+		}
+		uint32_t home = slots[i].hash & (KV_HASH_SLOTS - 1);
+		// Move it back unless its home lies cyclically in (hole, i]
+		if (((i - home) & (KV_HASH_SLOTS - 1)) >= ((i - hole) & (KV_HASH_SLOTS - 1))) {
+			slots[hole] = slots[i];
+			hole = i;
+		}
+	}
+	slots[hole].addr = 0;
+	stats.keys--;
+}
+
+// Applies one record to the table; caller holds the flash log lock
+static void index_record(uint32_t addr)
+{
+	const KvRecordHead_t *head = record_head(addr);
+	uint32_t hash = key_hash(record_key(addr), head->key_len);
+	KvSlot_t *slot = slot_find(record_key(addr), head->key_len, hash);
+
+	if (head->type == KV_TYPE_DELETED) {
+		if (slot->addr != 0) {
+			slot_remove(slot);
+		}
+		return;
+	}
+	if (slot->addr == 0) {
+		if (stats.keys >= KV_MAX_KEYS) {
+			return;
+		}
+		stats.keys++;
+	}
+	slot->hash = hash;
+	slot->addr = addr;
+}
+
+static void replay_record(const FlashLogHeader_t *hdr, void *arg)
+{
+	const KvRecordHead_t *head = (const KvRecordHead_t *)(hdr + 1);
+
+	if (head->key_len == 0 || head->key_len > KV_MAX_KEY_LEN || head->value_len > KV_MAX_VALUE_LEN ||
+	    sizeof(*head) + head->key_len + head->value_len > hdr->len) {
+		return;
+	}
+	index_record((uint32_t)hdr);
+}
+
+// Rotate hook: re-appends the live records in the sector about to be erased
+static bool kv_carry(uint32_t base, uint32_t end)
+{
+	for (uint32_t i = 0; i < KV_HASH_SLOTS; i++) {
+		if (slots[i].addr < base || slots[i].addr >= end) {
+			continue;
+		}
+		uint32_t addr = flash_log_carry_record((const FlashLogHeader_t *)slots[i].addr);
+		if (addr == 0) {
+			stats.failures++;
+			return false;
+		}
+		slots[i].addr = addr;
+		stats.carried++;
+	}
+	return true;
+}
+
+void kv_init(void)
+{
+	flash_log_walk(FLASH_LOG_TYPE_KV, replay_record, NULL);
+	flash_log_set_rotate_hook(kv_carry);
+}
+
+int32_t kv_get(const char *key, KvType_t *type, void *value, uint32_t max_len)
+{
+	uint32_t len = strlen(key);
+	int32_t copied = -1;
+
+	if (len == 0 || len > KV_MAX_KEY_LEN) {
+		return -1;
+	}
+
+	flash_log_lock();
+	KvSlot_t *slot = slot_find(key, len, key_hash(key, len));
+	if (slot->addr != 0) {
+		const KvRecordHead_t *head = record_head(slot->addr);
+		copied = (head->value_len < max_len) ? head->value_len : (int32_t)max_len;
+		memcpy(value, record_value(slot->addr), copied);
+		if (type != NULL) {
+			*type = (KvType_t)head->type;
+		}
+	}
+	flash_log_unlock();
+	return copied;
+}
+
+static bool kv_write(const char *key, KvType_t type, const void *value, uint32_t len)
+{
+	uint32_t key_len = strlen(key);
+	uint32_t hash = key_hash(key, key_len);
+	uint8_t record[KV_RECORD_MAX];
+	bool ok = false;
+
+	if (key_len == 0 || key_len > KV_MAX_KEY_LEN || len > KV_MAX_VALUE_LEN) {
+		return false;
+	}
+
+	flash_log_lock();
+	KvSlot_t *slot = slot_find(key, key_len, hash);
+	if (type == KV_TYPE_DELETED && slot->addr == 0) {
+		ok = true;
+	} else if (slot->addr != 0 && type != KV_TYPE_DELETED && record_head(slot->addr)->type == type &&
+	           record_head(slot->addr)->value_len == len && memcmp(record_value(slot->addr), value, len) == 0) {
+		// Same value already stored: no flash write
+		stats.unchanged++;
+		ok = true;
+	} else if (slot->addr == 0 && stats.keys >= KV_MAX_KEYS) {
+		stats.failures++;
+	} else {
+		KvRecordHead_t head = { (uint8_t)key_len, (uint8_t)len, (uint8_t)type, 0 };
+		memcpy(record, &head, sizeof(head));
+		memcpy(&record[sizeof(head)], key, key_len);
+		memcpy(&record[sizeof(head) + key_len], value, len);
+
+		uint32_t addr = flash_log_append_record(FLASH_LOG_TYPE_KV, record, sizeof(head) + key_len + len);
+		if (addr != 0) {
+			// The append may have rotated the log and moved records; look again
+			index_record(addr);
+			stats.writes++;
+			ok = true;
+		} else {
+			stats.failures++;
+		}
+	}
+	flash_log_unlock();
+	return ok;
+}
+
+bool kv_set(const char *key, KvType_t type, const void *value, uint32_t len)
+{
+	return (type != KV_TYPE_DELETED) && kv_write(key, type, value, len);
+}
+
+bool kv_delete(const char *key)
+{
+	return kv_write(key, KV_TYPE_DELETED, NULL, 0);
+}
+
+uint32_t kv_get_u32(const char *key, uint32_t fallback)
+{
+	KvType_t type;
+	uint32_t value;
+
+	if (kv_get(key, &type, &value, sizeof(value)) != (int32_t)sizeof(value) || type != KV_TYPE_U32) {
+		return fallback;
+	}
+	return value;
+}
+
+bool kv_set_u32(const char *key, uint32_t value)
+{
+	return kv_set(key, KV_TYPE_U32, &value, sizeof(value));
+}
+
+void kv_get_stats(KvStats_t *out)
+{
+	flash_log_lock();
+	*out = stats;
+	flash_log_unlock();
+}
+
+static void kv_show_slot(uint32_t addr)
+{
+	const KvRecordHead_t *head = record_head(addr);
+	const uint8_t *value = record_value(addr);
+	uint32_t u32;
+
+	log_printf("  %-15.*s ", head->key_len, record_key(addr));
+	switch (head->type) {
+		case KV_TYPE_U32:
+			memcpy(&u32, value, sizeof(u32));
+			log_printf("%lu\r\n", u32);
+			break;
+		case KV_TYPE_STRING:
+			log_printf("\"%.*s\"\r\n", head->value_len, (const char *)value);
+			break;
+		default:
+			for (uint32_t i = 0; i < head->value_len; i++) {
+				log_printf("%02X", value[i]);
+			}
+			log_printf("\r\n");
+			break;
+	}
+}
+
+static bool is_number(const char *s)
+{
+	if (*s == '\0') {
+		return false;
+	}
+	for (; *s != '\0'; s++) {
+		if (!isdigit((unsigned char)*s)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// config | config set <key> <value> | config del <key>
+CLI_COMMAND(config, "|sss", "[set <key> <value> | del <key>]", "Settings kept in flash")
+{
+	if (args->count == 0) {
+		KvStats_t s;
+		kv_get_stats(&s);
+		log_printf("Settings: %lu/%u keys, %lu writes, %lu unchanged, %lu carried, %lu failed\r\n",
+		           s.keys, KV_MAX_KEYS, s.writes, s.unchanged, s.carried, s.failures);
+
+		flash_log_lock();
+		for (uint32_t i = 0; i < KV_HASH_SLOTS; i++) {
+			if (slots[i].addr != 0) {
+				kv_show_slot(slots[i].addr);
+			}
+		}
+		flash_log_unlock();
+		return;
+	}
+
+	const char *op = args->v[0].s;
+	bool ok;
+	if (strcmp(op, "set") == 0 && args->count == 3) {
+		// Plain numbers are stored as u32 so modules can read them back directly
+		const char *text = args->v[2].s;
+		if (is_number(text)) {
+			ok = kv_set_u32(args->v[1].s, (uint32_t)strtoul(text, NULL, 10));
+		} else {
+			ok = kv_set(args->v[1].s, KV_TYPE_STRING, text, strlen(text));
+		}
+	} else if (strcmp(op, "del") == 0 && args->count == 2) {
+		ok = kv_delete(args->v[1].s);
+	} else {
+		log_printf("Usage: config [set <key> <value> | del <key>]\r\n");
+		return;
+	}
+
+	if (!ok) {
+		log_printf("Not saved: key 1-%u chars, value up to %u bytes, at most %u keys, no OTA running\r\n",
+		           KV_MAX_KEY_LEN, KV_MAX_VALUE_LEN, KV_MAX_KEYS);
+		return;
+	}
+	log_printf("Saved\r\n");
+}
@@ -0,0 +1,58 @@
+/*
+ * kv_store.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+
+#ifndef KV_STORE_H_
+#define KV_STORE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Persistent settings as key/value records appended to the flash log
+// sectors (FLASH_LOG_TYPE_KV). A change is one new record, a few dozen
+// word programs, never an erase; the newest record of a key wins, and a
+// delete is a record too. Sector erases happen only as the log rotates,
+// and the live records in the outgoing sector are re-appended first, so
+// that is also the garbage collection.
+//
+// At boot the records are replayed oldest first into a RAM hash table of
+// key -> record address, so a read is a hash probe and a copy out of flash.
+
+#define KV_MAX_KEYS              24
+#define KV_MAX_KEY_LEN           15
+#define KV_MAX_VALUE_LEN         68      // A CalibSpec_t
+#define KV_HASH_SLOTS            32      // Power of two, above KV_MAX_KEYS
+
+typedef enum {
+	KV_TYPE_BYTES = 0,
+	KV_TYPE_U32,
+	KV_TYPE_STRING,
+	KV_TYPE_DELETED,
+} KvType_t;
+
+typedef struct {
+	uint32_t keys;
+	uint32_t writes;             // Records appended for set/delete
+	uint32_t unchanged;          // Sets skipped because the value was already stored
+	uint32_t carried;            // Records re-appended ahead of a sector erase
+	uint32_t failures;
+} KvStats_t;
+
+// Call after flash_log_init(), before the heap is locked
+void kv_init(void);
+
+// Copies the value into 'value' and returns its length, or -1 if the key
+// is not set. 'type' may be NULL.
+int32_t kv_get(const char *key, KvType_t *type, void *value, uint32_t max_len);
+bool kv_set(const char *key, KvType_t type, const void *value, uint32_t len);
+bool kv_delete(const char *key);
+
+uint32_t kv_get_u32(const char *key, uint32_t fallback);
+bool kv_set_u32(const char *key, uint32_t value);
+
+void kv_get_stats(KvStats_t *stats);
+
+#endif /* KV_STORE_H_ */
@@ -0,0 +1,166 @@
+/*
+ * msg_pool.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+#include "msg_pool.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "freertos_mpool.h"
+#include "uart_logger.h"
+
+typedef struct {
+	const char *name;
+	uint32_t block_size;
+	uint32_t block_count;
+	uint8_t *mem;
+	uint32_t mem_size;
+	StaticMemPool_t cb;
+	osMemoryPoolId_t id;
+	uint32_t in_use;
+	uint32_t high_water;
+	uint32_t alloc_count;
+	uint32_t fail_count;
+} MsgPoolClass_t;
+
+static uint32_t small_mem[MEMPOOL_ARR_SIZE(MSG_POOL_SMALL_COUNT, MSG_POOL_SMALL_SIZE) / 4];
+static uint32_t medium_mem[MEMPOOL_ARR_SIZE(MSG_POOL_MEDIUM_COUNT, MSG_POOL_MEDIUM_SIZE) / 4];
+static uint32_t large_mem[MEMPOOL_ARR_SIZE(MSG_POOL_LARGE_COUNT, MSG_POOL_LARGE_SIZE) / 4];
+
+static MsgPoolClass_t pool_classes[MSG_POOL_CLASS_COUNT] = {
+	{ "PoolSmall",  MSG_POOL_SMALL_SIZE,  MSG_POOL_SMALL_COUNT,  (uint8_t *)small_mem,  sizeof(small_mem)  },
+	{ "PoolMedium", MSG_POOL_MEDIUM_SIZE, MSG_POOL_MEDIUM_COUNT, (uint8_t *)medium_mem, sizeof(medium_mem) },
+	{ "PoolLarge",  MSG_POOL_LARGE_SIZE,  MSG_POOL_LARGE_COUNT,  (uint8_t *)large_mem,  sizeof(large_mem)  },
+};
+
+static volatile uint8_t heap_locked = 0;
+static volatile uint32_t heap_violations = 0;
+
+void msg_pool_init(void)
+{
+	for (uint32_t c = 0; c < MSG_POOL_CLASS_COUNT; c++) {
+		MsgPoolClass_t *pc = &pool_classes[c];
+		osMemoryPoolAttr_t attr = {
+			.name = pc->name,
+			.cb_mem = &pc->cb,
+			.cb_size = sizeof(pc->cb),
+			.mp_mem = pc->mem,
+			.mp_size = pc->mem_size
+		};
+
+		pc->id = osMemoryPoolNew(pc->block_count, pc->block_size, &attr);
+		if (pc->id == NULL) {
+			log_printf("%s creation failed\r\n", pc->name);
+		}
+	}
+}
+
+static void pool_account(MsgPoolClass_t *pc, void *block)
+{
+	UBaseType_t isrm = taskENTER_CRITICAL_FROM_ISR();
+	if (block != NULL) {
+		pc->alloc_count++;
+		pc->in_use++;
+		if (pc->in_use > pc->high_water) {
+			pc->high_water = pc->in_use;
+		}
+	} else {
+		pc->fail_count++;
+	}
+	taskEXIT_CRITICAL_FROM_ISR(isrm);
+}
+
+void *msg_pool_alloc(uint32_t size, uint32_t timeout)
+{
+	MsgPoolClass_t *first_fit = NULL;
+
+	// Fast path: take the first class with a free block, never blocking
+	for (uint32_t c = 0; c < MSG_POOL_CLASS_COUNT; c++) {
+		MsgPoolClass_t *pc = &pool_classes[c];
+		if (pc->block_size < size || pc->id == NULL) {
+			continue;
+		}
+		if (first_fit == NULL) {
+			first_fit = pc;
+		}
+
+		void *block = osMemoryPoolAlloc(pc->id, 0);
+		pool_account(pc, block);
+		if (block != NULL) {
+			return block;
+		}
+	}
+
+	// Every fitting class is empty; wait on the tightest one if allowed.
+	// osMemoryPoolAlloc() ignores timeouts from ISR context on its own.
+	if (first_fit == NULL || timeout == 0 || __get_IPSR() != 0) {
+		return NULL;
+	}
+
+	void *block = osMemoryPoolAlloc(first_fit->id, timeout);
+	pool_account(first_fit, block);
+	return block;
+}
+
+void msg_pool_free(void *block)
+{
+	if (block == NULL) {
+		return;
+	}
+
+	for (uint32_t c = 0; c < MSG_POOL_CLASS_COUNT; c++) {
+		MsgPoolClass_t *pc = &pool_classes[c];
+		if ((uint8_t *)block >= pc->mem && (uint8_t *)block < pc->mem + pc->mem_size) {
+			if (osMemoryPoolFree(pc->id, block) == osOK) {
+				UBaseType_t isrm = taskENTER_CRITICAL_FROM_ISR();
+				pc->in_use--;
+				taskEXIT_CRITICAL_FROM_ISR(isrm);
+			}
+			return;
+		}
+	}
+
+	// Not one of ours - a stray heap pointer or a double free
+	configASSERT(0);
+}
+
+void msg_pool_get_stats(uint32_t class_index, MsgPoolStats_t *stats)
+{
+	if (class_index >= MSG_POOL_CLASS_COUNT || stats == NULL) {
+		return;
+	}
+
+	MsgPoolClass_t *pc = &pool_classes[class_index];
+	UBaseType_t isrm = taskENTER_CRITICAL_FROM_ISR();
+	stats->name = pc->name;
+	stats->block_size = pc->block_size;
+	stats->capacity = pc->block_count;
+	stats->in_use = pc->in_use;
+	stats->high_water = pc->high_water;
+	stats->alloc_count = pc->alloc_count;
+	stats->fail_count = pc->fail_count;
+	taskEXIT_CRITICAL_FROM_ISR(isrm);
+}
+
+void msg_pool_lock_heap(void)
+{
+	heap_locked = 1;
+}
+
+// Hooked into heap_4 through traceMALLOC (see FreeRTOSConfig.h)
+void msg_pool_heap_trace(void *ptr, uint32_t size)
+{
+	(void)ptr;
+	(void)size;
+
+	if (heap_locked) {
+		heap_violations++;
+		configASSERT(0);
+	}
+}
+
+uint32_t msg_pool_heap_violations(void)
+{
+	return heap_violations;
+}
@@ -0,0 +1,46 @@
+/*
+ * msg_pool.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+
+#ifndef MSG_POOL_H_
+#define MSG_POOL_H_
+
+#include "cmsis_os2.h"
+#include <stdint.h>
+
+// Size classes, smallest first. Blocks are handed out from the smallest class
+// that fits the request and fall through to larger classes when it is empty.
+#define MSG_POOL_SMALL_SIZE      32
+#define MSG_POOL_SMALL_COUNT     8
+#define MSG_POOL_MEDIUM_SIZE     128     // log lines (LOG_MSG_LEN)
+#define MSG_POOL_MEDIUM_COUNT    12
+#define MSG_POOL_LARGE_SIZE      268     // A 256-byte bulk payload plus a small header
+#define MSG_POOL_LARGE_COUNT     4       // Telemetry frames in flight
+
+#define MSG_POOL_CLASS_COUNT     3
+
+typedef struct {
+	const char *name;
+	uint32_t block_size;
+	uint32_t capacity;
+	uint32_t in_use;
+	uint32_t high_water;     // Most blocks ever in use at once
+	uint32_t alloc_count;
+	uint32_t fail_count;     // Requests this class could not serve
+} MsgPoolStats_t;
+
+void msg_pool_init(void);
+void *msg_pool_alloc(uint32_t size, uint32_t timeout);
+void msg_pool_free(void *block);
+void msg_pool_get_stats(uint32_t class_index, MsgPoolStats_t *stats);
+
+// Once locked, any pvPortMalloc() trips configASSERT. Called after all
+// kernel objects are created so runtime traffic can only use the pools.
+void msg_pool_lock_heap(void);
+void msg_pool_heap_trace(void *ptr, uint32_t size);
+uint32_t msg_pool_heap_violations(void);
+
+#endif /* MSG_POOL_H_ */
@@ -7,6 +7,8 @@
 #include "stm32f4xx_hal.h"
 #include "boot_metadata.h"
 #include "uart_logger.h"
+#include "crc32.h"
+#include "flash_ctrl.h"
 #include <string.h>
 
 // Function to wait for flash operations to complete
@@ -23,7 +25,7 @@ static HAL_StatusTypeDef wait_for_flash_ready(uint32_t timeout_ms)
     return HAL_OK;
 }
 
-HAL_StatusTypeDef clear_flash_protection(void)
+static HAL_StatusTypeDef clear_flash_protection_locked(void)
 {
     log_printf("Clearing flash protection...\r\n");
 
@@ -85,11 +87,21 @@ HAL_StatusTypeDef clear_flash_protection(void)
     return HAL_OK;
 }
 
+// The public flash operations hold the flash controller (flash_ctrl.h)
+// for their whole unlock...lock sequence
+HAL_StatusTypeDef clear_flash_protection(void)
+{
+    flash_ctrl_lock();
+    HAL_StatusTypeDef status = clear_flash_protection_locked();
+    flash_ctrl_unlock();
+    return status;
+}
+
 //extern uint32_t slot_to_erase_addr;
 //extern uint32_t sectors_to_erase[2];
 FLASH_EraseInitTypeDef eraseInit;
 
-HAL_StatusTypeDef erase_slot()
+static HAL_StatusTypeDef erase_slot_locked(void)
 {
     // Wait for any ongoing flash operations to complete
     HAL_StatusTypeDef ready_status = wait_for_flash_ready(5000);
@@ -157,9 +169,17 @@ HAL_StatusTypeDef erase_slot()
     return HAL_OK;
 }
 
+HAL_StatusTypeDef erase_slot()
+{
+    flash_ctrl_lock();
+    HAL_StatusTypeDef status = erase_slot_locked();
+    flash_ctrl_unlock();
+    return status;
+}
 
 
-HAL_StatusTypeDef ota_write_firmware(uint32_t offset, uint8_t *data, uint32_t len)
+
+static HAL_StatusTypeDef ota_write_firmware_locked(uint32_t offset, uint8_t *data, uint32_t len)
 {
     if (!ota_slot_check()) {
         log_printf("Invalid metadata! Aborting write.\r\n");
@@ -228,10 +248,18 @@ HAL_StatusTypeDef ota_write_firmware(uint32_t offset, uint8_t *data, uint32_t le
     return status;
 }
 
-uint32_t calculate_crc32_ota(uint32_t *data, uint32_t length_words)
+HAL_StatusTypeDef ota_write_firmware(uint32_t offset, uint8_t *data, uint32_t len)
+{
+    flash_ctrl_lock();
+    HAL_StatusTypeDef status = ota_write_firmware_locked(offset, data, len);
+    flash_ctrl_unlock();
+    return status;
+}
+
+// Folds words into a running CRC register; callers seed with 0xFFFFFFFF and
+// invert the final value, which lets long checks run in resumable blocks
+uint32_t crc32_update_words(uint32_t crc, const uint32_t *data, uint32_t length_words)
 {
-    uint32_t crc = 0xFFFFFFFF;
-    
     for (uint32_t i = 0; i < length_words; i++) {
         uint32_t word = data[i];
         
@@ -250,7 +278,13 @@ uint32_t calculate_crc32_ota(uint32_t *data, uint32_t length_words)
         }
     }
     
-    return ~crc;
+    return crc;
+}
+
+// Selected backend (crcmode); the CRC unit is much faster than the bit-serial loop
+uint32_t calculate_crc32_ota(uint32_t *data, uint32_t length_words)
+{
+    return crc32_compute(data, length_words);
 }
 
 uint32_t calculate_flash_crc_ota(uint32_t start_addr, uint32_t size_bytes)
@@ -268,7 +302,7 @@ uint32_t calculate_flash_crc_ota(uint32_t start_addr, uint32_t size_bytes)
     return crc;
 }
 
-HAL_StatusTypeDef update_boot_metadata(uint32_t new_slot, uint32_t firmware_crc, uint32_t firmware_size)
+static HAL_StatusTypeDef update_boot_metadata_locked(uint32_t new_slot, uint32_t firmware_crc, uint32_t firmware_size)
 {
     // Create new metadata structure
     BootMetadata_t new_metadata;
@@ -293,59 +327,41 @@ HAL_StatusTypeDef update_boot_metadata(uint32_t new_slot, uint32_t firmware_crc,
         return status;
     }
     
-    // Erase metadata sector
-    // STM32F446RE sector mapping: 
-    // Sector 3: 0x0800C000-0x0800FFFF (16KB) - contains metadata at 0x0800C000
-    FLASH_EraseInitTypeDef eraseInit = {
-        .TypeErase = FLASH_TYPEERASE_SECTORS,
-        .VoltageRange = FLASH_VOLTAGE_RANGE_3,
-        .Sector = FLASH_SECTOR_3,  // Correct sector for 0x0800C000
-        .NbSectors = 1
-    };
-    
-    uint32_t sectorError;
-    status = HAL_FLASHEx_Erase(&eraseInit, &sectorError);
-    if (status != HAL_OK) {
-        log_printf("Metadata sector erase failed: %d, error: 0x%08X\r\n", status, sectorError);
-        HAL_FLASH_Lock();
-        return status;
-    }
-    
-    // Write new metadata word by word
-    uint32_t *metadata_ptr = (uint32_t *)&new_metadata;
-    uint32_t metadata_words = sizeof(BootMetadata_t) / 4;
-    
-    for (uint32_t i = 0; i < metadata_words; i++) {
-        status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, 
-                                   METADATA_ADDRESS + (i * 4), 
-                                   metadata_ptr[i]);
-        if (status != HAL_OK) {
-            log_printf("Metadata write failed at word %lu, status: %d\r\n", i, status);
-            HAL_FLASH_Lock();
-            return status;
-        }
-    }
-    
+    // Append to the metadata journal; the sector is erased only when full
+    status = boot_metadata_append(&new_metadata);
     HAL_FLASH_Lock();
     
-    // Verify the write was successful
-    BootMetadata_t *verify_metadata = (BootMetadata_t *)METADATA_ADDRESS;
-    if (verify_metadata->is_valid == VALID_MARKER && 
-        verify_metadata->active_slot == new_slot &&
-        verify_metadata->crc == firmware_crc) {
-        log_printf("Metadata updated and verified successfully\r\n");
+    // boot_metadata is reloaded from flash by the append
+    if (status == HAL_OK &&
+        boot_metadata->is_valid == VALID_MARKER && 
+        boot_metadata->active_slot == new_slot &&
+        boot_metadata->crc == firmware_crc) {
+        if (boot_metadata_journaled()) {
+            log_printf("Metadata updated and verified successfully (record %lu, %lu left before erase)\r\n",
+                       boot_metadata_seq(), boot_metadata_free_records());
+        } else {
+            log_printf("Metadata updated and verified successfully (single record, bootloader has no journal)\r\n");
+        }
         return HAL_OK;
     } else {
-        log_printf("Metadata verification failed after write!\r\n");
+        log_printf("Metadata verification failed after write! status: %d\r\n", status);
         log_printf("  Written - valid:0x%08X slot:%lu crc:0x%08X\r\n", 
                    VALID_MARKER, new_slot, (unsigned int)firmware_crc);
         log_printf("  Read    - valid:0x%08X slot:%lu crc:0x%08X\r\n", 
-                   (unsigned int)verify_metadata->is_valid, verify_metadata->active_slot, 
-                   (unsigned int)verify_metadata->crc);
-        return HAL_ERROR;
+                   (unsigned int)boot_metadata->is_valid, boot_metadata->active_slot, 
+                   (unsigned int)boot_metadata->crc);
+        return (status != HAL_OK) ? status : HAL_ERROR;
     }
 }
 
+HAL_StatusTypeDef update_boot_metadata(uint32_t new_slot, uint32_t firmware_crc, uint32_t firmware_size)
+{
+    flash_ctrl_lock();
+    HAL_StatusTypeDef status = update_boot_metadata_locked(new_slot, firmware_crc, firmware_size);
+    flash_ctrl_unlock();
+    return status;
+}
+
 HAL_StatusTypeDef initialize_metadata()
 {
     log_printf("Initializing default metadata...\r\n");
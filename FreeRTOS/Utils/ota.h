@@ -10,6 +10,7 @@
 
 void ota_erase_slot();
 HAL_StatusTypeDef ota_write_firmware(uint32_t offset, uint8_t *data, uint32_t len);
+uint32_t crc32_update_words(uint32_t crc, const uint32_t *data, uint32_t length_words);
 uint32_t calculate_crc32_ota(uint32_t *data, uint32_t length_words);
 uint32_t calculate_flash_crc_ota(uint32_t start_addr, uint32_t size_bytes);
 HAL_StatusTypeDef update_boot_metadata(uint32_t new_slot, uint32_t firmware_crc, uint32_t firmware_size);
@@ -0,0 +1,114 @@
+/*
+ * periodic_jobs.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+#include "periodic_jobs.h"
+#include "FreeRTOS.h"
+#include "timers.h"
+#include "uart_logger.h"
+
+typedef struct {
+	const char *name;
+	PeriodicJobFunc_t func;
+	void *arg;
+	uint32_t period_ms;
+	uint32_t next_due;
+	osTimerId_t timer;
+	StaticTimer_t timer_cb;
+	uint32_t runs;
+	uint32_t overruns;
+	uint32_t max_lateness_ms;
+	uint32_t max_runtime_ms;
+} PeriodicJob_t;
+
+static PeriodicJob_t jobs[PERIODIC_JOB_MAX];
+static uint32_t job_count = 0;
+
+// Runs on the timer service task; every job shares its stack
+static void periodic_job_dispatch(void *argument)
+{
+	PeriodicJob_t *job = (PeriodicJob_t *)argument;
+	uint32_t start = osKernelGetTickCount();
+	uint32_t lateness = start - job->next_due;
+
+	// A negative lateness only happens on the very first run
+	if ((int32_t)lateness < 0) {
+		lateness = 0;
+	}
+
+	job->func(job->arg);
+
+	uint32_t runtime = osKernelGetTickCount() - start;
+	job->runs++;
+	if (lateness > job->max_lateness_ms) {
+		job->max_lateness_ms = lateness;
+	}
+	if (runtime > job->max_runtime_ms) {
+		job->max_runtime_ms = runtime;
+	}
+	if (lateness >= job->period_ms || runtime >= job->period_ms) {
+		job->overruns++;
+	}
+
+	// The timer reloads relative to its own expiry time, so track the same grid
+	job->next_due += job->period_ms;
+	if ((int32_t)(start - job->next_due) >= 0) {
+		job->next_due = start + job->period_ms;
+	}
+}
+
+int32_t periodic_job_add(const char *name, PeriodicJobFunc_t func, void *arg, uint32_t period_ms)
+{
+	if (job_count >= PERIODIC_JOB_MAX || func == NULL || period_ms == 0) {
+		log_printf("Periodic job '%s' rejected\r\n", name);
+		return -1;
+	}
+
+	PeriodicJob_t *job = &jobs[job_count];
+	job->name = name;
+	job->func = func;
+	job->arg = arg;
+	job->period_ms = period_ms;
+
+	const osTimerAttr_t attr = {
+		.name = name,
+		.cb_mem = &job->timer_cb,
+		.cb_size = sizeof(job->timer_cb)
+	};
+
+	job->timer = osTimerNew(periodic_job_dispatch, osTimerPeriodic, job, &attr);
+	if (job->timer == NULL) {
+		log_printf("Periodic job '%s' timer creation failed\r\n", name);
+		return -1;
+	}
+
+	job->next_due = osKernelGetTickCount() + period_ms;
+	if (osTimerStart(job->timer, pdMS_TO_TICKS(period_ms)) != osOK) {
+		log_printf("Periodic job '%s' failed to start\r\n", name);
+		return -1;
+	}
+
+	return (int32_t)job_count++;
+}
+
+uint32_t periodic_job_count(void)
+{
+	return job_count;
+}
+
+void periodic_job_get_stats(uint32_t index, PeriodicJobStats_t *stats)
+{
+	if (index >= job_count || stats == NULL) {
+		return;
+	}
+
+	PeriodicJob_t *job = &jobs[index];
+	stats->name = job->name;
+	stats->period_ms = job->period_ms;
+	stats->runs = job->runs;
+	stats->overruns = job->overruns;
+	stats->max_lateness_ms = job->max_lateness_ms;
+	stats->max_runtime_ms = job->max_runtime_ms;
+}
@@ -0,0 +1,36 @@
+/*
+ * periodic_jobs.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+
+#ifndef PERIODIC_JOBS_H_
+#define PERIODIC_JOBS_H_
+
+#include "cmsis_os2.h"
+#include <stdint.h>
+
+// Low-rate housekeeping runs as timer-service callbacks, sharing the single
+// timer task stack instead of costing a dedicated task each. Jobs must be
+// short and must never block.
+#define PERIODIC_JOB_MAX    8
+
+typedef void (*PeriodicJobFunc_t)(void *arg);
+
+typedef struct {
+	const char *name;
+	uint32_t period_ms;
+	uint32_t runs;
+	uint32_t overruns;         // Dispatched a full period late or ran longer than a period
+	uint32_t max_lateness_ms;
+	uint32_t max_runtime_ms;
+} PeriodicJobStats_t;
+
+// Timer control blocks are static, so jobs can be added at any time up to
+// PERIODIC_JOB_MAX
+int32_t periodic_job_add(const char *name, PeriodicJobFunc_t func, void *arg, uint32_t period_ms);
+uint32_t periodic_job_count(void);
+void periodic_job_get_stats(uint32_t index, PeriodicJobStats_t *stats);
+
+#endif /* PERIODIC_JOBS_H_ */
@@ -0,0 +1,181 @@
+/*
+ * pubsub.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+#include "pubsub.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "main.h"
+#include "app_tasks.h"
+#include "alarm.h"
+#include "cli_registry.h"
+#include "uart_logger.h"
+#include <string.h>
+
+typedef struct {
+	const char *name;
+	volatile uint32_t head;      // Sequence number of the next item; written by the publisher only
+	uint32_t mask;
+	uint32_t item_size;
+	uint8_t *slots;
+	uint32_t subscriber_count;
+	PubSubSubscriber_t *subscribers[PUBSUB_MAX_SUBSCRIBERS];
+} PubSubTopic_t;
+
+// Slot storage for one topic, sized and checked at compile time
+#define PUBSUB_TOPIC_STORAGE(name, type, count)                                         \
+	_Static_assert(((count) & ((count) - 1)) == 0, #name " slots must be a power of two"); \
+	_Static_assert(PUBSUB_GUARD_SLOTS < (count), #name " guard leaves no slots to read"); \
+	static type name##_slots[count]
+
+#define PUBSUB_TOPIC(topic_name, storage, count)                                        \
+	{ .name = (topic_name), .mask = (count) - 1, .item_size = sizeof(storage##_slots[0]), \
+	  .slots = (uint8_t *)storage##_slots }
+
+PUBSUB_TOPIC_STORAGE(sensor, SensorMessage_t, PUBSUB_SENSOR_SLOTS);
+PUBSUB_TOPIC_STORAGE(alarm, AlarmEvent_t, PUBSUB_ALARM_SLOTS);
+
+static PubSubTopic_t topics[TOPIC_COUNT] = {
+	[TOPIC_SENSOR] = PUBSUB_TOPIC("sensor", sensor, PUBSUB_SENSOR_SLOTS),
+	[TOPIC_ALARM]  = PUBSUB_TOPIC("alarm", alarm, PUBSUB_ALARM_SLOTS),
+};
+
+static inline uint8_t *topic_slot(const PubSubTopic_t *t, uint32_t seq)
+{
+	return t->slots + (seq & t->mask) * t->item_size;
+}
+
+bool pubsub_subscribe(TopicId_t topic, PubSubSubscriber_t *sub)
+{
+	if (topic >= TOPIC_COUNT || sub == NULL) {
+		return false;
+	}
+
+	PubSubTopic_t *t = &topics[topic];
+	if (t->subscriber_count >= PUBSUB_MAX_SUBSCRIBERS) {
+		log_printf("[PUBSUB] Too many subscribers on '%s'\r\n", t->name);
+		return false;
+	}
+
+	sub->topic = topic;
+	sub->cursor = t->head;       // Only items published from now on
+	sub->received = 0;
+	sub->overruns = 0;
+	t->subscribers[t->subscriber_count++] = sub;
+	return true;
+}
+
+void *pubsub_claim(TopicId_t topic)
+{
+	PubSubTopic_t *t = &topics[topic];
+	return topic_slot(t, t->head);
+}
+
+void pubsub_commit(TopicId_t topic)
+{
+	PubSubTopic_t *t = &topics[topic];
+	__DMB();                     // Slot contents land before the index that publishes them
+	t->head = t->head + 1;
+}
+
+void pubsub_notify(TopicId_t topic)
+{
+	PubSubTopic_t *t = &topics[topic];
+
+	for (uint32_t i = 0; i < t->subscriber_count; i++) {
+		PubSubSubscriber_t *sub = t->subscribers[i];
+		if (sub->thread != NULL && *sub->thread != NULL) {
+			osThreadFlagsSet(*sub->thread, sub->flag);
+		}
+	}
+}
+
+void pubsub_publish(TopicId_t topic, const void *item)
+{
+	memcpy(pubsub_claim(topic), item, topics[topic].item_size);
+	pubsub_commit(topic);
+	pubsub_notify(topic);
+}
+
+const void *pubsub_next(PubSubSubscriber_t *sub)
+{
+	PubSubTopic_t *t = &topics[sub->topic];
+	uint32_t head = t->head;
+	uint32_t lag = head - sub->cursor;
+
+	if (lag == 0) {
+		return NULL;
+	}
+
+	// Too close to being lapped: drop the oldest items rather than read a
+	// slot the publisher is about to reuse
+	uint32_t limit = t->mask + 1 - PUBSUB_GUARD_SLOTS;
+	if (lag > limit) {
+		sub->overruns += lag - limit;
+		sub->cursor = head - limit;
+	}
+
+	__DMB();                     // Index read before the slot it covers
+	return topic_slot(t, sub->cursor);
+}
+
+bool pubsub_release(PubSubSubscriber_t *sub)
+{
+	PubSubTopic_t *t = &topics[sub->topic];
+
+	__DMB();                     // Slot read before checking whether it was reused
+	bool intact = (t->head - sub->cursor) <= t->mask;
+	sub->cursor++;
+	if (intact) {
+		sub->received++;
+	} else {
+		sub->overruns++;
+	}
+	return intact;
+}
+
+uint32_t pubsub_pending(const PubSubSubscriber_t *sub)
+{
+	return topics[sub->topic].head - sub->cursor;
+}
+
+void pubsub_get_topic_stats(TopicId_t topic, PubSubTopicStats_t *stats)
+{
+	if (topic >= TOPIC_COUNT || stats == NULL) {
+		return;
+	}
+
+	const PubSubTopic_t *t = &topics[topic];
+	stats->name = t->name;
+	stats->published = t->head;
+	stats->slots = t->mask + 1;
+	stats->item_size = t->item_size;
+	stats->subscribers = t->subscriber_count;
+}
+
+const PubSubSubscriber_t *pubsub_subscriber_at(TopicId_t topic, uint32_t index)
+{
+	if (topic >= TOPIC_COUNT || index >= topics[topic].subscriber_count) {
+		return NULL;
+	}
+	return topics[topic].subscribers[index];
+}
+
+// topics
+CLI_COMMAND(topics, "", "", "Publish/subscribe topics and per-subscriber lag")
+{
+	for (uint32_t n = 0; n < TOPIC_COUNT; n++) {
+		PubSubTopicStats_t stats;
+		pubsub_get_topic_stats((TopicId_t)n, &stats);
+		log_printf("%s: %lu published, %lu x %lu B slots, %lu subscriber(s)\r\n",
+		           stats.name, stats.published, stats.slots, stats.item_size, stats.subscribers);
+
+		for (uint32_t i = 0; i < stats.subscribers; i++) {
+			const PubSubSubscriber_t *sub = pubsub_subscriber_at((TopicId_t)n, i);
+			log_printf("  %-12s received %-8lu overruns %-6lu lag %lu\r\n",
+			           sub->name, sub->received, sub->overruns, pubsub_pending(sub));
+		}
+	}
+}
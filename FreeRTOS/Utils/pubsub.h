@@ -0,0 +1,79 @@
+/*
+ * pubsub.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+
+#ifndef PUBSUB_H_
+#define PUBSUB_H_
+
+#include "cmsis_os2.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Statically configured topic bus. Each topic has one publisher and a ring
+// of slots; subscribers read the slots in place through their own cursor,
+// so a publish costs one write however many subscribers there are, and
+// nothing is locked. The publisher never waits: a subscriber that falls a
+// whole ring behind skips ahead and has the skipped items counted as
+// overruns.
+
+typedef enum {
+	TOPIC_SENSOR = 0,            // SensorMessage_t, from the pipeline's publish stage
+	TOPIC_ALARM,                 // AlarmEvent_t, from the pipeline's aggregate stage
+	TOPIC_COUNT
+} TopicId_t;
+
+#define PUBSUB_SENSOR_SLOTS      64      // Must be a power of two
+#define PUBSUB_ALARM_SLOTS       32
+#define PUBSUB_MAX_SUBSCRIBERS   4       // Per topic
+
+// A subscriber reading more than SLOTS - GUARD behind is moved up first, so
+// the publisher has GUARD items to go before it can reach the slot being read
+#define PUBSUB_GUARD_SLOTS       8
+
+typedef struct {
+	const char *name;
+	osThreadId_t *thread;        // Notified with 'flag' after each publish batch
+	uint32_t flag;
+	uint32_t cursor;             // Sequence number of the next item to read
+	uint32_t received;
+	uint32_t overruns;           // Items skipped or overwritten before being read
+	TopicId_t topic;
+} PubSubSubscriber_t;
+
+#define PUBSUB_SUBSCRIBER(sub_name, thread_handle, thread_flag) \
+	{ .name = (sub_name), .thread = &(thread_handle), .flag = (thread_flag) }
+
+typedef struct {
+	const char *name;
+	uint32_t published;
+	uint32_t slots;
+	uint32_t item_size;
+	uint32_t subscribers;
+} PubSubTopicStats_t;
+
+// Registration happens at init, before the scheduler starts
+bool pubsub_subscribe(TopicId_t topic, PubSubSubscriber_t *sub);
+
+// Publisher side. claim() returns the slot for the next item, to be filled
+// in place; commit() makes it visible; notify() wakes the subscribers and
+// can be batched over several commits.
+void *pubsub_claim(TopicId_t topic);
+void pubsub_commit(TopicId_t topic);
+void pubsub_notify(TopicId_t topic);
+void pubsub_publish(TopicId_t topic, const void *item);
+
+// Subscriber side. next() returns the oldest unread item in place, or NULL
+// when caught up. release() finishes with it and returns false if the
+// publisher may have overwritten the slot meanwhile, in which case the
+// item is counted as an overrun and whatever was read from it is suspect.
+const void *pubsub_next(PubSubSubscriber_t *sub);
+bool pubsub_release(PubSubSubscriber_t *sub);
+uint32_t pubsub_pending(const PubSubSubscriber_t *sub);
+
+void pubsub_get_topic_stats(TopicId_t topic, PubSubTopicStats_t *stats);
+const PubSubSubscriber_t *pubsub_subscriber_at(TopicId_t topic, uint32_t index);
+
+#endif /* PUBSUB_H_ */
@@ -0,0 +1,139 @@
+/*
+ * quantile.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+#include "quantile.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "cli_registry.h"
+#include "uart_logger.h"
+#include "sensor_sched.h"
+#include <string.h>
+
+// Target side: one sketch per metric; the sketch itself is in quantile_sketch.c
+
+typedef struct {
+	const char *name;
+	const char *unit;
+	bool enabled;
+	QuantileSketch_t sketch;
+} QuantileMetricSlot_t;
+
+_Static_assert((int)QMETRIC_TEMPERATURE == (int)SENSOR_TEMPERATURE && (int)QMETRIC_PRESSURE == (int)SENSOR_PRESSURE,
+               "sensor metrics follow SensorId_t");
+
+static QuantileMetricSlot_t metrics[QMETRIC_COUNT] = {
+	[QMETRIC_TEMPERATURE]  = { "temp",     "C",  false },
+	[QMETRIC_PRESSURE]     = { "pressure", "%",  false },
+	[QMETRIC_OTA_WRITE]    = { "ota_write",   "us", true },
+	[QMETRIC_OTA_HANDOFF]  = { "ota_handoff", "us", true },
+	[QMETRIC_DRDY_LATENCY] = { "drdy",     "us", true },
+	[QMETRIC_BUS_LATENCY]  = { "bus",      "us", true },
+};
+
+void quantile_record(QuantileMetric_t metric, float value)
+{
+	if (metric >= QMETRIC_COUNT || !metrics[metric].enabled) {
+		return;
+	}
+
+	// Bounded: three sketches, at most three marker moves each
+	UBaseType_t isrm = taskENTER_CRITICAL_FROM_ISR();
+	quantile_sketch_add(&metrics[metric].sketch, value);
+	taskEXIT_CRITICAL_FROM_ISR(isrm);
+}
+
+void quantile_enable(QuantileMetric_t metric, bool enabled)
+{
+	if (metric < QMETRIC_COUNT) {
+		metrics[metric].enabled = enabled;
+	}
+}
+
+void quantile_reset(QuantileMetric_t metric)
+{
+	if (metric >= QMETRIC_COUNT) {
+		return;
+	}
+
+	UBaseType_t isrm = taskENTER_CRITICAL_FROM_ISR();
+	quantile_sketch_reset(&metrics[metric].sketch);
+	taskEXIT_CRITICAL_FROM_ISR(isrm);
+}
+
+void quantile_get_stats(QuantileMetric_t metric, QuantileStats_t *stats)
+{
+	if (metric >= QMETRIC_COUNT || stats == NULL) {
+		return;
+	}
+
+	QuantileMetricSlot_t *slot = &metrics[metric];
+	stats->name = slot->name;
+	stats->unit = slot->unit;
+	stats->enabled = slot->enabled;
+
+	UBaseType_t isrm = taskENTER_CRITICAL_FROM_ISR();
+	stats->count = slot->sketch.count;
+	stats->min = slot->sketch.min;
+	stats->max = slot->sketch.max;
+	for (uint32_t k = 0; k < QUANTILE_COUNT; k++) {
+		stats->value[k] = quantile_sketch_get(&slot->sketch, (QuantileId_t)k);
+	}
+	taskEXIT_CRITICAL_FROM_ISR(isrm);
+}
+
+int quantile_find(const char *name)
+{
+	for (uint32_t n = 0; n < QMETRIC_COUNT; n++) {
+		if (strcmp(name, metrics[n].name) == 0) {
+			return (int)n;
+		}
+	}
+	return -1;
+}
+
+// quantile | quantile on|off|reset <metric|all>
+CLI_COMMAND(quantile, "|ss", "[on|off|reset <metric|all>]", "Streaming P50/P95/P99 of sensors and latencies")
+{
+	if (args->count == 1) {
+		log_printf("Usage: quantile [on|off|reset <metric|all>]\r\n");
+		return;
+	}
+	if (args->count == 2) {
+		const char *op = args->v[0].s;
+		bool all = (strcmp(args->v[1].s, "all") == 0);
+		int id = quantile_find(args->v[1].s);
+
+		if ((!all && id < 0) ||
+		    (strcmp(op, "on") != 0 && strcmp(op, "off") != 0 && strcmp(op, "reset") != 0)) {
+			log_printf("Usage: quantile [on|off|reset <metric|all>]\r\n");
+			return;
+		}
+		for (uint32_t n = 0; n < QMETRIC_COUNT; n++) {
+			if (!all && (int)n != id) {
+				continue;
+			}
+			if (strcmp(op, "reset") == 0) {
+				quantile_reset((QuantileMetric_t)n);
+			} else {
+				quantile_enable((QuantileMetric_t)n, strcmp(op, "on") == 0);
+			}
+		}
+	}
+
+	log_printf("Metric       State  Count     Min        P50        P95        P99        Max\r\n");
+	for (uint32_t n = 0; n < QMETRIC_COUNT; n++) {
+		QuantileStats_t stats;
+		quantile_get_stats((QuantileMetric_t)n, &stats);
+		if (stats.count == 0) {
+			log_printf("%-12s %-6s -\r\n", stats.name, stats.enabled ? "on" : "off");
+			continue;
+		}
+		log_printf("%-12s %-6s %-9lu %-10.2f %-10.2f %-10.2f %-10.2f %.2f %s\r\n",
+		           stats.name, stats.enabled ? "on" : "off", stats.count, stats.min,
+		           stats.value[QUANTILE_P50], stats.value[QUANTILE_P95], stats.value[QUANTILE_P99],
+		           stats.max, stats.unit);
+	}
+}
@@ -0,0 +1,86 @@
+/*
+ * quantile.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+
+#ifndef QUANTILE_H_
+#define QUANTILE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Streaming percentiles with the P-square algorithm (Jain & Chlamtac, 1985).
+// Each tracked quantile keeps five markers - min, p/2, p, (1+p)/2, max - and
+// nudges them towards their ideal ranks with a parabolic fit as samples
+// arrive, so memory and time per sample are constant whatever the stream
+// length: a P50/P95/P99 sketch is 132 bytes and an update moves at most
+// nine markers, where exact answers need every sample stored and sorted.
+//
+// The price is accuracy on odd distributions and short streams. Against
+// exact order statistics over 100k samples, error as a share of the
+// observed range:
+//   uniform, normal, exponential, slow sine     all three within 0.2%
+//   ramp                                        P95/P99 within 0.2%, P50 0.3%
+//   bimodal (two equal modes)                   P95/P99 within 0.1%, but
+//                                               P50 lands between the modes
+// Tails need history to settle: on exponential data P95 is within 5% after
+// 400 samples, P99 after 4000. Up to five samples the answers are exact.
+//
+// The sketch core (quantile_sketch.c) has no RTOS dependencies;
+// tests/test_quantile.c checks every figure above on a host.
+
+#define QUANTILE_MARKERS         5
+
+typedef enum {
+	QUANTILE_P50 = 0,
+	QUANTILE_P95,
+	QUANTILE_P99,
+	QUANTILE_COUNT
+} QuantileId_t;
+
+typedef struct {
+	uint32_t count;
+	float min;
+	float max;
+	float height[QUANTILE_COUNT][QUANTILE_MARKERS];
+	int32_t pos[QUANTILE_COUNT][QUANTILE_MARKERS];   // 1-based ranks
+} QuantileSketch_t;
+
+void quantile_sketch_reset(QuantileSketch_t *sketch);
+void quantile_sketch_add(QuantileSketch_t *sketch, float value);
+float quantile_sketch_get(const QuantileSketch_t *sketch, QuantileId_t q);
+float quantile_fraction(QuantileId_t q);
+
+// Metrics with a sketch attached on the target. Sensor channels come first,
+// in SensorId_t order; they are off by default since they run at the sample
+// rate, while the latency metrics are on.
+typedef enum {
+	QMETRIC_TEMPERATURE = 0,
+	QMETRIC_PRESSURE,
+	QMETRIC_OTA_WRITE,           // us per flash chunk write
+	QMETRIC_OTA_HANDOFF,         // us to queue a chunk from CLITask to OTATask
+	QMETRIC_DRDY_LATENCY,        // us from data-ready edge to read
+	QMETRIC_BUS_LATENCY,         // us from bus submit to completion, incl. queueing
+	QMETRIC_COUNT
+} QuantileMetric_t;
+
+typedef struct {
+	const char *name;
+	const char *unit;
+	bool enabled;
+	uint32_t count;
+	float min;
+	float max;
+	float value[QUANTILE_COUNT];
+} QuantileStats_t;
+
+// Safe from tasks and ISRs; a no-op while the metric is disabled
+void quantile_record(QuantileMetric_t metric, float value);
+void quantile_enable(QuantileMetric_t metric, bool enabled);
+void quantile_reset(QuantileMetric_t metric);
+void quantile_get_stats(QuantileMetric_t metric, QuantileStats_t *stats);
+int quantile_find(const char *name);
+
+#endif /* QUANTILE_H_ */
@@ -0,0 +1,144 @@
+/*
+ * quantile_sketch.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+#include "quantile.h"
+#include <string.h>
+
+// Plain computation on QuantileSketch_t, with no hardware or RTOS calls,
+// so tests/test_quantile.c builds it on a host unchanged.
+
+static const float fractions[QUANTILE_COUNT] = {
+	[QUANTILE_P50] = 0.50f,
+	[QUANTILE_P95] = 0.95f,
+	[QUANTILE_P99] = 0.99f,
+};
+
+float quantile_fraction(QuantileId_t q)
+{
+	return fractions[q];
+}
+
+void quantile_sketch_reset(QuantileSketch_t *sketch)
+{
+	memset(sketch, 0, sizeof(*sketch));
+}
+
+// Ideal 1-based rank of marker i once 'count' samples have been seen
+static float desired_pos(float p, uint32_t i, uint32_t count)
+{
+	const float step[QUANTILE_MARKERS] = { 0.0f, p / 2.0f, p, (1.0f + p) / 2.0f, 1.0f };
+	return 1.0f + step[i] * (float)(count - 1);
+}
+
+// Piecewise-parabolic prediction of marker i's height after moving it by d
+static float parabolic(const float *q, const int32_t *n, uint32_t i, int32_t d)
+{
+	float span = (float)(n[i + 1] - n[i - 1]);
+	float up = (q[i + 1] - q[i]) / (float)(n[i + 1] - n[i]);
+	float down = (q[i] - q[i - 1]) / (float)(n[i] - n[i - 1]);
+
+	return q[i] + (float)d / span * ((float)(n[i] - n[i - 1] + d) * up + (float)(n[i + 1] - n[i] - d) * down);
+}
+
+static void marker_update(float *q, int32_t *n, float p, float value, uint32_t count)
+{
+	uint32_t cell;
+
+	if (value < q[0]) {
+		q[0] = value;
+		cell = 0;
+	} else if (value >= q[4]) {
+		q[4] = value;
+		cell = 3;
+	} else {
+		cell = 0;
+		while (cell < 3 && value >= q[cell + 1]) {
+			cell++;
+		}
+	}
+	for (uint32_t i = cell + 1; i < QUANTILE_MARKERS; i++) {
+		n[i]++;
+	}
+
+	for (uint32_t i = 1; i < QUANTILE_MARKERS - 1; i++) {
+		float d = desired_pos(p, i, count) - (float)n[i];
+
+		if ((d >= 1.0f && n[i + 1] - n[i] > 1) || (d <= -1.0f && n[i - 1] - n[i] < -1)) {
+			int32_t step = (d > 0.0f) ? 1 : -1;
+			float h = parabolic(q, n, i, step);
+
+			if (q[i - 1] < h && h < q[i + 1]) {
+				q[i] = h;
+			} else {
+				// Parabola overshot a neighbour; fall back to linear
+				q[i] += (float)step * (q[i + step] - q[i]) / (float)(n[i + step] - n[i]);
+			}
+			n[i] += step;
+		}
+	}
+}
+
+static void sort_floats(float *v, uint32_t count)
+{
+	for (uint32_t i = 1; i < count; i++) {
+		float x = v[i];
+		uint32_t j = i;
+		while (j > 0 && v[j - 1] > x) {
+			v[j] = v[j - 1];
+			j--;
+		}
+		v[j] = x;
+	}
+}
+
+void quantile_sketch_add(QuantileSketch_t *sketch, float value)
+{
+	if (sketch->count == 0 || value < sketch->min) {
+		sketch->min = value;
+	}
+	if (sketch->count == 0 || value > sketch->max) {
+		sketch->max = value;
+	}
+
+	// The first five samples become the initial markers of every quantile
+	if (sketch->count < QUANTILE_MARKERS) {
+		for (uint32_t k = 0; k < QUANTILE_COUNT; k++) {
+			sketch->height[k][sketch->count] = value;
+		}
+		sketch->count++;
+		if (sketch->count == QUANTILE_MARKERS) {
+			for (uint32_t k = 0; k < QUANTILE_COUNT; k++) {
+				sort_floats(sketch->height[k], QUANTILE_MARKERS);
+				for (uint32_t i = 0; i < QUANTILE_MARKERS; i++) {
+					sketch->pos[k][i] = (int32_t)i + 1;
+				}
+			}
+		}
+		return;
+	}
+
+	sketch->count++;
+	for (uint32_t k = 0; k < QUANTILE_COUNT; k++) {
+		marker_update(sketch->height[k], sketch->pos[k], fractions[k], value, sketch->count);
+	}
+}
+
+float quantile_sketch_get(const QuantileSketch_t *sketch, QuantileId_t q)
+{
+	if (sketch->count == 0) {
+		return 0.0f;
+	}
+	if (sketch->count <= QUANTILE_MARKERS) {
+		// Exact nearest rank over the few samples held so far; at five the
+		// markers are those samples, not yet an estimate
+		float v[QUANTILE_MARKERS];
+		memcpy(v, sketch->height[q], sketch->count * sizeof(float));
+		sort_floats(v, sketch->count);
+		uint32_t rank = (uint32_t)(fractions[q] * (float)(sketch->count - 1) + 0.5f);
+		return v[rank];
+	}
+	return sketch->height[q][2];
+}
@@ -0,0 +1,150 @@
+/*
+ * sensor_drdy.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+#include "sensor_drdy.h"
+#include "main.h"
+#include "task.h"
+#include "app_tasks.h"
+#include "cycle_counter.h"
+#include "quantile.h"
+#include <string.h>
+
+#define DRDY_IRQ_PRIORITY        6       // Below configMAX_SYSCALL, may use FromISR APIs
+
+typedef struct {
+	const char *name;
+	GPIO_TypeDef *port;
+	uint16_t pin;
+	IRQn_Type irq;
+	volatile bool pending;
+	DrdyEvent_t latched;
+	DrdyStats_t stats;
+} DrdySource_t;
+
+static DrdySource_t drdy_lines[DRDY_COUNT] = {
+	[DRDY_B1] = { "b1", GPIOC, GPIO_PIN_13, EXTI15_10_IRQn },
+};
+
+void sensor_drdy_init(void)
+{
+	GPIO_InitTypeDef init = {0};
+
+	for (uint32_t n = 0; n < DRDY_COUNT; n++) {
+		DrdySource_t *src = &drdy_lines[n];
+		src->stats.name = src->name;
+
+		init.Pin = src->pin;
+		init.Mode = GPIO_MODE_IT_FALLING;
+		init.Pull = GPIO_NOPULL;           // B1 has an external pull-up on the Nucleo
+		HAL_GPIO_Init(src->port, &init);
+
+		HAL_NVIC_SetPriority(src->irq, DRDY_IRQ_PRIORITY, 0);
+		HAL_NVIC_EnableIRQ(src->irq);
+	}
+}
+
+void sensor_drdy_irq(void)
+{
+	// Latch first so the timestamp is the edge, not the end of this handler.
+	// SysTick counts core cycles down from LOAD, so LOAD - VAL is how many
+	// have passed since the current tick began.
+	uint32_t cycles = cycle_counter_now();
+	uint32_t into_tick = SysTick->LOAD - SysTick->VAL;
+	bool tick_pending = (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) != 0;
+	TickType_t tick = xTaskGetTickCountFromISR();
+	bool any = false;
+
+	// SysTick has reloaded but its handler, at the lowest priority, has not
+	// counted the tick yet
+	if (tick_pending && into_tick < SysTick->LOAD / 2) {
+		tick++;
+	}
+	uint32_t tick_us = cycles_to_us(into_tick);
+	if (tick_us > 999) {
+		tick_us = 999;
+	}
+
+	for (uint32_t n = 0; n < DRDY_COUNT; n++) {
+		DrdySource_t *src = &drdy_lines[n];
+		if (!(EXTI->PR & src->pin)) {
+			continue;
+		}
+		EXTI->PR = src->pin;
+
+		if (src->pending) {
+			src->stats.overruns++;
+		}
+		src->latched.cycles = cycles;
+		src->latched.tick = tick;
+		src->latched.tick_us = (uint16_t)tick_us;
+		src->pending = true;
+		src->stats.events++;
+		any = true;
+	}
+
+	if (any && SensorTaskHandle != NULL) {
+		osThreadFlagsSet(SensorTaskHandle, SENSOR_FLAG_DRDY);
+	}
+}
+
+bool sensor_drdy_take(DrdyLine_t line, DrdyEvent_t *event)
+{
+	if (line >= DRDY_COUNT) {
+		return false;
+	}
+
+	DrdySource_t *src = &drdy_lines[line];
+	bool taken = false;
+
+	taskENTER_CRITICAL();
+	if (src->pending) {
+		*event = src->latched;
+		src->pending = false;
+		taken = true;
+	}
+	taskEXIT_CRITICAL();
+	return taken;
+}
+
+void sensor_drdy_record_latency(DrdyLine_t line, uint32_t cycles)
+{
+	if (line >= DRDY_COUNT) {
+		return;
+	}
+
+	DrdySource_t *src = &drdy_lines[line];
+	uint32_t us = cycles_to_us(cycles);
+
+	quantile_record(QMETRIC_DRDY_LATENCY, (float)us);
+
+	taskENTER_CRITICAL();
+	src->stats.last_latency_us = us;
+	if (us > src->stats.max_latency_us) {
+		src->stats.max_latency_us = us;
+	}
+	taskEXIT_CRITICAL();
+}
+
+int sensor_drdy_find(const char *name)
+{
+	for (uint32_t n = 0; n < DRDY_COUNT; n++) {
+		if (strcmp(drdy_lines[n].name, name) == 0) {
+			return (int)n;
+		}
+	}
+	return -1;
+}
+
+void sensor_drdy_get_stats(DrdyLine_t line, DrdyStats_t *stats)
+{
+	if (line >= DRDY_COUNT || stats == NULL) {
+		return;
+	}
+
+	taskENTER_CRITICAL();
+	*stats = drdy_lines[line].stats;
+	taskEXIT_CRITICAL();
+}
@@ -0,0 +1,49 @@
+/*
+ * sensor_drdy.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+
+#ifndef SENSOR_DRDY_H_
+#define SENSOR_DRDY_H_
+
+#include "FreeRTOS.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Data-ready inputs. Each line's EXTI interrupt latches the sample time and
+// wakes SensorTask, which does the actual read. The time is the kernel tick
+// plus the core cycles elapsed within it, so samples are stamped to the
+// microsecond rather than the 1 ms tick.
+typedef enum {
+	DRDY_B1 = 0,                 // PC13, user button B1 (falling edge), for bench testing
+	DRDY_COUNT
+} DrdyLine_t;
+
+typedef struct {
+	uint32_t cycles;             // DWT cycle count at the edge
+	TickType_t tick;             // Kernel tick at the edge
+	uint16_t tick_us;            // How far into that tick, 0..999 us
+} DrdyEvent_t;
+
+typedef struct {
+	const char *name;
+	uint32_t events;             // Edges seen by the ISR
+	uint32_t overruns;           // Edges that replaced one not yet serviced
+	uint32_t last_latency_us;    // Edge to read, as measured by the reader
+	uint32_t max_latency_us;
+} DrdyStats_t;
+
+void sensor_drdy_init(void);
+void sensor_drdy_irq(void);
+
+// Takes the pending edge on 'line', if any. The newest edge wins when
+// several arrive before the task gets to them.
+bool sensor_drdy_take(DrdyLine_t line, DrdyEvent_t *event);
+void sensor_drdy_record_latency(DrdyLine_t line, uint32_t cycles);
+
+int sensor_drdy_find(const char *name);
+void sensor_drdy_get_stats(DrdyLine_t line, DrdyStats_t *stats);
+
+#endif /* SENSOR_DRDY_H_ */
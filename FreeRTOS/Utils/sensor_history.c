@@ -0,0 +1,332 @@
+/*
+ * sensor_history.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+#include "sensor_history.h"
+#include "task.h"
+#include "cli_registry.h"
+#include "uart_logger.h"
+#include "telemetry.h"
+#include "ts_codec.h"
+#include "msg_pool.h"
+#include <string.h>
+
+#define HISTORY_PRINT_BATCH     8       // Points copied out per critical section
+#define HISTORY_DUMP_FRAME_SIZE MSG_POOL_LARGE_SIZE
+
+typedef struct {
+	uint32_t time_ms;
+	float value;
+} HistorySample_t;
+
+typedef struct {
+	uint32_t start_s;
+	float min;
+	float max;
+	float sum;
+	uint32_t count;
+} HistoryBucket_t;
+
+// Fixed-size ring of closed buckets plus the one still accumulating
+typedef struct {
+	HistoryBucket_t *ring;
+	uint16_t capacity;
+	uint16_t head;               // Next slot to write
+	uint16_t count;
+	uint32_t span_s;
+	HistoryBucket_t open;
+} HistoryTier_t;
+
+typedef struct {
+	HistorySample_t raw[HISTORY_RAW_SAMPLES];
+	uint16_t raw_head;
+	uint16_t raw_count;
+	HistoryBucket_t minute_ring[HISTORY_MINUTE_BUCKETS];
+	HistoryBucket_t hour_ring[HISTORY_HOUR_BUCKETS];
+	HistoryBucket_t day_ring[HISTORY_DAY_BUCKETS];
+	HistoryTier_t tiers[HISTORY_RES_COUNT - 1];
+} HistoryChannel_t;
+
+static HistoryChannel_t history[SENSOR_COUNT];
+static uint8_t history_ready = 0;
+
+static void history_init(void)
+{
+	for (uint32_t n = 0; n < SENSOR_COUNT; n++) {
+		HistoryChannel_t *ch = &history[n];
+		ch->tiers[0] = (HistoryTier_t){ .ring = ch->minute_ring, .capacity = HISTORY_MINUTE_BUCKETS, .span_s = 60 };
+		ch->tiers[1] = (HistoryTier_t){ .ring = ch->hour_ring, .capacity = HISTORY_HOUR_BUCKETS, .span_s = 3600 };
+		ch->tiers[2] = (HistoryTier_t){ .ring = ch->day_ring, .capacity = HISTORY_DAY_BUCKETS, .span_s = 86400 };
+	}
+	history_ready = 1;
+}
+
+static void tier_add(HistoryTier_t *tier, float value, uint32_t time_s)
+{
+	uint32_t start = time_s - (time_s % tier->span_s);
+	HistoryBucket_t *open = &tier->open;
+
+	if (open->count != 0 && open->start_s != start) {
+		tier->ring[tier->head] = *open;
+		tier->head = (tier->head + 1) % tier->capacity;
+		if (tier->count < tier->capacity) {
+			tier->count++;
+		}
+		open->count = 0;
+	}
+
+	if (open->count == 0) {
+		open->start_s = start;
+		open->min = value;
+		open->max = value;
+		open->sum = 0.0f;
+	}
+	if (value < open->min) {
+		open->min = value;
+	}
+	if (value > open->max) {
+		open->max = value;
+	}
+	open->sum += value;
+	open->count++;
+}
+
+void sensor_history_add(SensorId_t id, float value, uint32_t time_ms)
+{
+	if (id >= SENSOR_COUNT) {
+		return;
+	}
+
+	// Queries run on a higher-priority task; keep each update atomic to them
+	taskENTER_CRITICAL();
+	if (!history_ready) {
+		history_init();
+	}
+
+	HistoryChannel_t *ch = &history[id];
+	ch->raw[ch->raw_head].time_ms = time_ms;
+	ch->raw[ch->raw_head].value = value;
+	ch->raw_head = (ch->raw_head + 1) % HISTORY_RAW_SAMPLES;
+	if (ch->raw_count < HISTORY_RAW_SAMPLES) {
+		ch->raw_count++;
+	}
+
+	for (uint32_t t = 0; t < HISTORY_RES_COUNT - 1; t++) {
+		tier_add(&ch->tiers[t], value, time_ms / 1000);
+	}
+	taskEXIT_CRITICAL();
+}
+
+static void bucket_to_point(const HistoryBucket_t *b, HistoryPoint_t *p)
+{
+	p->start = b->start_s;
+	p->min = b->min;
+	p->max = b->max;
+	p->mean = b->sum / (float)b->count;
+	p->count = b->count;
+}
+
+// Copies up to max_points points of the matching range, passing over the
+// first 'skip' that start exactly at 'from'. The caller pages through so
+// interrupts are never held off for a whole query, resuming from the last
+// start it got (history_page_next()); an index would shift as new samples
+// push old ones out between pages.
+static uint32_t history_copy(HistoryChannel_t *ch, HistoryRes_t res, uint32_t from, uint32_t to,
+                             uint32_t skip, HistoryPoint_t *out, uint32_t max_points)
+{
+	uint32_t copied = 0;
+	uint32_t matched = 0;          // Points at 'from' passed over so far
+
+	if (res == HISTORY_RES_RAW) {
+		uint32_t oldest = (ch->raw_head + HISTORY_RAW_SAMPLES - ch->raw_count) % HISTORY_RAW_SAMPLES;
+		for (uint32_t k = 0; k < ch->raw_count && copied < max_points; k++) {
+			const HistorySample_t *s = &ch->raw[(oldest + k) % HISTORY_RAW_SAMPLES];
+			if (s->time_ms < from || s->time_ms > to || (s->time_ms == from && matched++ < skip)) {
+				continue;
+			}
+			out[copied++] = (HistoryPoint_t){ s->time_ms, s->value, s->value, s->value, 1 };
+		}
+		return copied;
+	}
+
+	HistoryTier_t *tier = &ch->tiers[res - 1];
+	uint32_t oldest = (tier->head + tier->capacity - tier->count) % tier->capacity;
+	for (uint32_t k = 0; k <= tier->count && copied < max_points; k++) {
+		// The open bucket comes last so partial periods are visible too
+		const HistoryBucket_t *b = (k < tier->count) ? &tier->ring[(oldest + k) % tier->capacity] : &tier->open;
+		if (b->count == 0 || b->start_s < from || b->start_s > to ||
+		    (b->start_s == from && matched++ < skip)) {
+			continue;
+		}
+		bucket_to_point(b, &out[copied++]);
+	}
+	return copied;
+}
+
+// Moves a paging cursor past a page: the next one starts at the page's last
+// start, skipping the points already seen there (raw samples can share a ms)
+static void history_page_next(const HistoryPoint_t *page, uint32_t got, uint32_t *from, uint32_t *skip)
+{
+	uint32_t last = page[got - 1].start;
+	uint32_t same = 0;
+
+	while (same < got && page[got - 1 - same].start == last) {
+		same++;
+	}
+	*skip = (last == *from) ? *skip + same : same;
+	*from = last;
+}
+
+uint32_t sensor_history_query(SensorId_t id, HistoryRes_t res, uint32_t from, uint32_t to,
+                              HistoryPoint_t *out, uint32_t max_points)
+{
+	if (id >= SENSOR_COUNT || res >= HISTORY_RES_COUNT || out == NULL || !history_ready) {
+		return 0;
+	}
+
+	taskENTER_CRITICAL();
+	uint32_t copied = history_copy(&history[id], res, from, to, 0, out, max_points);
+	taskEXIT_CRITICAL();
+	return copied;
+}
+
+static const char *const res_names[HISTORY_RES_COUNT] = { "raw", "min", "hour", "day" };
+
+static bool history_parse(const CliArgs_t *args, int *id, HistoryRes_t *res)
+{
+	*id = sensor_find(args->v[0].s);
+	*res = HISTORY_RES_COUNT;
+
+	for (uint32_t r = 0; r < HISTORY_RES_COUNT; r++) {
+		if (strcmp(args->v[1].s, res_names[r]) == 0) {
+			*res = (HistoryRes_t)r;
+		}
+	}
+	if (*id < 0 || *res == HISTORY_RES_COUNT || !history_ready) {
+		log_printf("No history for '%s' at '%s'\r\n", args->v[0].s, args->v[1].s);
+		return false;
+	}
+	return true;
+}
+
+// Converts [span_s] [end_ago_s] arguments into a range in the tier's time unit
+static void history_range(const CliArgs_t *args, HistoryRes_t res, uint32_t *from, uint32_t *to)
+{
+	uint32_t now_s = xTaskGetTickCount() / configTICK_RATE_HZ;
+	uint32_t span_s = (args->count > 2) ? args->v[2].u : 3600;
+	uint32_t end_ago_s = (args->count > 3) ? args->v[3].u : 0;
+	uint32_t end = (end_ago_s < now_s) ? now_s - end_ago_s : 0;
+	uint32_t start = (span_s < end) ? end - span_s : 0;
+
+	// Raw samples are stamped in ms
+	uint32_t scale = (res == HISTORY_RES_RAW) ? 1000 : 1;
+	*from = start * scale;
+	*to = (end + 1) * scale - 1;
+}
+
+// history <sensor> <raw|min|hour|day> [span_s] [end_ago_s]
+CLI_COMMAND(history, "ss|uu", "<temp|pressure> <raw|min|hour|day> [span_s] [end_ago_s]",
+            "Query sensor history at a chosen resolution")
+{
+	int id;
+	HistoryRes_t res;
+	uint32_t from, to;
+
+	if (!history_parse(args, &id, &res)) {
+		return;
+	}
+	history_range(args, res, &from, &to);
+
+	log_printf("# %s %s start,min,max,mean,count\r\n", args->v[0].s, res_names[res]);
+
+	HistoryPoint_t batch[HISTORY_PRINT_BATCH];
+	uint32_t total = 0;
+	uint32_t skip = 0;
+	uint32_t got;
+	do {
+		taskENTER_CRITICAL();
+		got = history_copy(&history[id], res, from, to, skip, batch, HISTORY_PRINT_BATCH);
+		taskEXIT_CRITICAL();
+		if (got > 0) {
+			history_page_next(batch, got, &from, &skip);
+		}
+
+		for (uint32_t p = 0; p < got; p++) {
+			log_printf("%lu,%.2f,%.2f,%.2f,%lu\r\n", batch[p].start, batch[p].min,
+			           batch[p].max, batch[p].mean, batch[p].count);
+		}
+		total += got;
+	} while (got == HISTORY_PRINT_BATCH);
+
+	log_printf("# %lu points\r\n", total);
+}
+
+// Same query as 'history', sent as Gorilla-compressed TELEMETRY_FRAME_HISTORY frames
+CLI_COMMAND(histdump, "ss|uu", "<temp|pressure> <raw|min|hour|day> [span_s] [end_ago_s]",
+            "Export sensor history as compressed binary frames")
+{
+	int id;
+	HistoryRes_t res;
+	uint32_t from, to;
+
+	if (!history_parse(args, &id, &res)) {
+		return;
+	}
+	history_range(args, res, &from, &to);
+
+	uint8_t *frame = msg_pool_alloc(HISTORY_DUMP_FRAME_SIZE, 100);
+	if (frame == NULL) {
+		log_printf("No buffer for history export\r\n");
+		return;
+	}
+
+	log_printf("# histdump %s %s\r\n", args->v[0].s, res_names[res]);
+
+	TsCodec_t codec;
+	HistoryPoint_t batch[HISTORY_PRINT_BATCH];
+	uint32_t total = 0;
+	uint32_t skip = 0;
+	uint32_t got;
+	uint16_t frames = 0;
+	uint32_t t0 = 0;
+
+	ts_encoder_init(&codec, &frame[TELEMETRY_HEADER_SIZE],
+	                HISTORY_DUMP_FRAME_SIZE - TELEMETRY_HEADER_SIZE - TELEMETRY_CRC_SIZE, 3);
+	do {
+		taskENTER_CRITICAL();
+		got = history_copy(&history[id], res, from, to, skip, batch, HISTORY_PRINT_BATCH);
+		taskEXIT_CRITICAL();
+		if (got > 0) {
+			history_page_next(batch, got, &from, &skip);
+		}
+
+		for (uint32_t p = 0; p < got; p++) {
+			float values[3] = { batch[p].min, batch[p].max, batch[p].mean };
+
+			// Frame full (or count at its 8-bit limit): send it and start the next
+			if (codec.count == UINT8_MAX || !ts_encoder_add(&codec, batch[p].start, values)) {
+				uint16_t len = telemetry_frame_seal(frame, TELEMETRY_FRAME_HISTORY, (uint8_t)codec.count,
+				                                    frames++, t0, (uint16_t)ts_encoder_bytes(&codec));
+				uart_logger_write(frame, len);
+				ts_encoder_init(&codec, &frame[TELEMETRY_HEADER_SIZE],
+				                HISTORY_DUMP_FRAME_SIZE - TELEMETRY_HEADER_SIZE - TELEMETRY_CRC_SIZE, 3);
+				ts_encoder_add(&codec, batch[p].start, values);
+			}
+			if (codec.count == 1) {
+				t0 = batch[p].start;
+			}
+		}
+		total += got;
+	} while (got == HISTORY_PRINT_BATCH);
+
+	if (codec.count > 0) {
+		uint16_t len = telemetry_frame_seal(frame, TELEMETRY_FRAME_HISTORY, (uint8_t)codec.count,
+		                                    frames++, t0, (uint16_t)ts_encoder_bytes(&codec));
+		uart_logger_write(frame, len);
+	}
+	msg_pool_free(frame);
+
+	log_printf("# %lu points in %u frames\r\n", total, frames);
+}
@@ -0,0 +1,45 @@
+/*
+ * sensor_history.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+
+#ifndef SENSOR_HISTORY_H_
+#define SENSOR_HISTORY_H_
+
+#include "sensor_sched.h"
+#include <stdint.h>
+
+// Retention per channel at each resolution
+#define HISTORY_RAW_SAMPLES     240     // Full-rate samples, newest kept
+#define HISTORY_MINUTE_BUCKETS  120     // 2 hours
+#define HISTORY_HOUR_BUCKETS    72      // 3 days
+#define HISTORY_DAY_BUCKETS     30      // 30 days
+
+typedef enum {
+	HISTORY_RES_RAW = 0,
+	HISTORY_RES_MINUTE,
+	HISTORY_RES_HOUR,
+	HISTORY_RES_DAY,
+	HISTORY_RES_COUNT
+} HistoryRes_t;
+
+// One aggregate per bucket; raw samples report start in ms with min=max=mean
+typedef struct {
+	uint32_t start;              // Bucket start in seconds of uptime (ms for raw)
+	float min;
+	float max;
+	float mean;
+	uint32_t count;
+} HistoryPoint_t;
+
+// Called for every sample; O(1) regardless of retention
+void sensor_history_add(SensorId_t id, float value, uint32_t time_ms);
+
+// Copies the points of one channel whose start lies in [from, to] at the
+// given resolution, oldest first. Returns the number copied.
+uint32_t sensor_history_query(SensorId_t id, HistoryRes_t res, uint32_t from, uint32_t to,
+                              HistoryPoint_t *out, uint32_t max_points);
+
+#endif /* SENSOR_HISTORY_H_ */
@@ -0,0 +1,308 @@
+/*
+ * sensor_pipeline.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+#include "sensor_pipeline.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "app_tasks.h"
+#include "spsc_ring.h"
+#include "dsp_filter.h"
+#include "sensor_history.h"
+#include "sensor_snapshot.h"
+#include "alarm.h"
+#include "quantile.h"
+#include "flash_log.h"
+#include "pubsub.h"
+#include "cycle_counter.h"
+#include "cli_registry.h"
+#include "uart_logger.h"
+#include <string.h>
+
+#define SENSOR_DEFAULT_ALPHA    0.25f   // Low-pass smoothing applied before publishing
+
+SPSC_RING_DEFINE(acq_ring, PipeSample_t, PIPE_ACQ_RING_ITEMS);
+SPSC_RING_DEFINE(filter_ring, PipeSample_t, PIPE_FILTER_RING_ITEMS);
+SPSC_RING_DEFINE(publish_ring, SensorMessage_t, PIPE_PUBLISH_RING_ITEMS);
+
+// Turns 'count' input items into output items, returning how many it wrote
+// (never more than 'count')
+typedef uint32_t (*PipeProcessFunc_t)(const void *in, uint32_t count, void *out);
+
+typedef struct {
+	const char *name;
+	SpscRing_t *in;
+	SpscRing_t *out;
+	PipeProcessFunc_t process;
+	osThreadId_t *thread;
+	void *in_buf;                // PIPE_BATCH items, owned by the stage task
+	void *out_buf;
+	uint32_t items_in;
+	uint32_t items_out;
+	uint32_t batches;
+	uint32_t max_batch;
+	uint32_t stalls;
+	uint32_t busy_us;
+} PipeStage_t;
+
+static uint32_t filter_stage(const void *in, uint32_t count, void *out);
+static uint32_t aggregate_stage(const void *in, uint32_t count, void *out);
+static uint32_t publish_stage(const void *in, uint32_t count, void *out);
+
+static PipeSample_t filter_in[PIPE_BATCH], filter_out[PIPE_BATCH];
+static PipeSample_t aggregate_in[PIPE_BATCH];
+static SensorMessage_t aggregate_out[PIPE_BATCH], publish_in[PIPE_BATCH];
+
+static PipeStage_t stages[PIPE_STAGE_COUNT] = {
+	[PIPE_STAGE_ACQUIRE]   = { "acquire",   NULL,         &acq_ring,     NULL,            NULL },
+	[PIPE_STAGE_FILTER]    = { "filter",    &acq_ring,    &filter_ring,  filter_stage,    &PipeFilterTaskHandle,
+	                           filter_in, filter_out },
+	[PIPE_STAGE_AGGREGATE] = { "aggregate", &filter_ring, &publish_ring, aggregate_stage, &PipeAggregateTaskHandle,
+	                           aggregate_in, aggregate_out },
+	[PIPE_STAGE_PUBLISH]   = { "publish",   &publish_ring, NULL,         publish_stage,   &PipePublishTaskHandle,
+	                           publish_in, NULL },
+};
+
+static TickType_t stats_start;
+
+// Filter stage state, one low-pass per channel
+static DspLowPassF32_t filters[SENSOR_COUNT];
+
+// Aggregate stage's merged view of the latest value of every channel
+static SensorMessage_t latest;
+
+void sensor_pipeline_init(void)
+{
+	for (uint32_t n = 0; n < SENSOR_COUNT; n++) {
+		dsp_lowpass_f32_init(&filters[n], SENSOR_DEFAULT_ALPHA);
+	}
+	stats_start = xTaskGetTickCount();
+}
+
+static uint32_t filter_stage(const void *in, uint32_t count, void *out)
+{
+	const PipeSample_t *src = in;
+	PipeSample_t *dst = out;
+
+	taskENTER_CRITICAL();        // Against a concurrent 'filter' command
+	for (uint32_t i = 0; i < count; i++) {
+		dst[i] = src[i];
+		dst[i].value = dsp_lowpass_f32(&filters[src[i].id], src[i].value);
+	}
+	taskEXIT_CRITICAL();
+	return count;
+}
+
+static uint32_t aggregate_stage(const void *in, uint32_t count, void *out)
+{
+	const PipeSample_t *src = in;
+	SensorMessage_t *dst = out;
+	uint32_t produced = 0;
+
+	for (uint32_t i = 0; i < count; i++) {
+		sensor_history_add((SensorId_t)src[i].id, src[i].value, src[i].time_ms);
+		alarm_evaluate((SensorId_t)src[i].id, src[i].value, src[i].time_ms);
+		quantile_record((QuantileMetric_t)src[i].id, src[i].value);
+		flash_log_add((SensorId_t)src[i].id, src[i].value, src[i].time_ms);
+
+		if (src[i].id == SENSOR_TEMPERATURE) {
+			latest.temperature = src[i].value;
+		} else {
+			latest.pressure = src[i].value;
+		}
+		latest.timestamp_ms = src[i].time_ms;
+		latest.timestamp_us = src[i].time_us;
+
+		// Channels read in the same acquisition pass go out as one merged
+		// message; a pass split across two batches still gives two
+		if (i + 1 == count || src[i + 1].pass != src[i].pass) {
+			dst[produced++] = latest;
+		}
+	}
+	return produced;
+}
+
+static uint32_t publish_stage(const void *in, uint32_t count, void *out)
+{
+	const SensorMessage_t *msgs = in;
+
+	// Written once into the topic's slots; subscribers read them in place
+	for (uint32_t i = 0; i < count; i++) {
+		*(SensorMessage_t *)pubsub_claim(TOPIC_SENSOR) = msgs[i];
+		pubsub_commit(TOPIC_SENSOR);
+	}
+	pubsub_notify(TOPIC_SENSOR);
+
+	// Readers only ever want the newest, so one snapshot per batch
+	sensor_snapshot_publish(&msgs[count - 1]);
+	return 0;
+}
+
+static void stage_notify(PipeStage_t *stage, uint32_t flag)
+{
+	if (stage != NULL && stage->thread != NULL && *stage->thread != NULL) {
+		osThreadFlagsSet(*stage->thread, flag);
+	}
+}
+
+uint32_t sensor_pipeline_acquire(const PipeSample_t *samples, uint32_t count)
+{
+	PipeStage_t *stage = &stages[PIPE_STAGE_ACQUIRE];
+	uint32_t pushed = spsc_push(stage->out, samples, count);
+
+	stage->items_in += count;
+	stage->items_out += pushed;
+	stage->batches++;
+	if (count > stage->max_batch) {
+		stage->max_batch = count;
+	}
+	if (pushed > 0) {
+		stage_notify(&stages[PIPE_STAGE_FILTER], PIPE_FLAG_DATA);
+	}
+	return pushed;
+}
+
+void PipeStageTaskFunc(void *argument)
+{
+	PipeStageId_t id = (PipeStageId_t)(uintptr_t)argument;
+	PipeStage_t *stage = &stages[id];
+	PipeStage_t *upstream = (id > PIPE_STAGE_FILTER) ? &stages[id - 1] : NULL;
+	PipeStage_t *downstream = (id + 1 < PIPE_STAGE_COUNT) ? &stages[id + 1] : NULL;
+
+	for (;;) {
+		uint32_t n = spsc_count(stage->in);
+		if (n > PIPE_BATCH) {
+			n = PIPE_BATCH;
+		}
+		if (stage->out != NULL && n > spsc_space(stage->out)) {
+			n = spsc_space(stage->out);
+			if (n == 0) {
+				stage->stalls++;
+			}
+		}
+
+		// Flags latch, so anything pushed since the checks above still wakes us
+		if (n == 0) {
+			osThreadFlagsWait(PIPE_FLAG_DATA | PIPE_FLAG_SPACE, osFlagsWaitAny, osWaitForever);
+			continue;
+		}
+
+		uint32_t start = cycle_counter_now();
+		spsc_pop(stage->in, stage->in_buf, n);
+		uint32_t produced = stage->process(stage->in_buf, n, stage->out_buf);
+		if (produced > 0) {
+			spsc_push(stage->out, stage->out_buf, produced);
+		}
+		uint32_t busy_us = cycles_to_us(cycle_counter_now() - start);
+
+		taskENTER_CRITICAL();
+		stage->items_in += n;
+		stage->items_out += produced;
+		stage->batches++;
+		stage->busy_us += busy_us;
+		if (n > stage->max_batch) {
+			stage->max_batch = n;
+		}
+		taskEXIT_CRITICAL();
+
+		stage_notify(upstream, PIPE_FLAG_SPACE);
+		if (produced > 0) {
+			stage_notify(downstream, PIPE_FLAG_DATA);
+		}
+	}
+}
+
+void sensor_pipeline_set_filter(SensorId_t id, float alpha)
+{
+	if (id >= SENSOR_COUNT) {
+		return;
+	}
+
+	taskENTER_CRITICAL();
+	dsp_lowpass_f32_init(&filters[id], alpha);
+	taskEXIT_CRITICAL();
+}
+
+void sensor_pipeline_get_stats(PipeStageId_t id, PipeStageStats_t *stats)
+{
+	if (id >= PIPE_STAGE_COUNT || stats == NULL) {
+		return;
+	}
+
+	PipeStage_t *stage = &stages[id];
+	memset(stats, 0, sizeof(*stats));
+
+	taskENTER_CRITICAL();
+	uint32_t window_ms = (xTaskGetTickCount() - stats_start) * portTICK_PERIOD_MS;
+	stats->name = stage->name;
+	stats->items_in = stage->items_in;
+	stats->items_out = stage->items_out;
+	stats->batches = stage->batches;
+	stats->max_batch = stage->max_batch;
+	stats->stalls = stage->stalls;
+	if (stage->out != NULL) {
+		stats->out_depth = spsc_count(stage->out);
+		stats->out_high_water = stage->out->high_water;
+		stats->out_capacity = spsc_capacity(stage->out);
+		if (id == PIPE_STAGE_ACQUIRE) {
+			stats->dropped = stage->out->push_failed;
+		}
+	}
+	uint32_t busy_us = stage->busy_us;
+	taskEXIT_CRITICAL();
+
+	if (window_ms > 0) {
+		// Publish emits nothing downstream; its throughput is what it consumed
+		uint32_t items = (stage->out != NULL) ? stats->items_out : stats->items_in;
+		stats->items_per_s = (uint32_t)((uint64_t)items * 1000U / window_ms);
+		stats->busy_permille = busy_us / window_ms;
+		if (stats->busy_permille > 1000) {
+			stats->busy_permille = 1000;
+		}
+	}
+}
+
+void sensor_pipeline_reset_stats(void)
+{
+	taskENTER_CRITICAL();
+	for (uint32_t s = 0; s < PIPE_STAGE_COUNT; s++) {
+		PipeStage_t *stage = &stages[s];
+		stage->items_in = 0;
+		stage->items_out = 0;
+		stage->batches = 0;
+		stage->max_batch = 0;
+		stage->stalls = 0;
+		stage->busy_us = 0;
+		if (stage->out != NULL) {
+			stage->out->high_water = spsc_count(stage->out);
+			stage->out->push_failed = 0;
+		}
+	}
+	stats_start = xTaskGetTickCount();
+	taskEXIT_CRITICAL();
+}
+
+// pipeline | pipeline reset
+CLI_COMMAND(pipeline, "|s", "[reset]", "Per-stage sensor pipeline throughput and queue depth")
+{
+	if (args->count > 0) {
+		if (strcmp(args->v[0].s, "reset") != 0) {
+			log_printf("Usage: pipeline [reset]\r\n");
+			return;
+		}
+		sensor_pipeline_reset_stats();
+	}
+
+	log_printf("Stage      In       Out      Items/s  Batch(max)  Busy    Stalls  Out ring (peak/size)  Dropped\r\n");
+	for (uint32_t s = 0; s < PIPE_STAGE_COUNT; s++) {
+		PipeStageStats_t stats;
+		sensor_pipeline_get_stats((PipeStageId_t)s, &stats);
+		uint32_t avg_batch = (stats.batches > 0) ? stats.items_in / stats.batches : 0;
+		log_printf("%-10s %-8lu %-8lu %-8lu %3lu (%3lu)   %3lu.%lu%%  %-7lu %3lu (%3lu/%3lu)         %lu\r\n",
+		           stats.name, stats.items_in, stats.items_out, stats.items_per_s, avg_batch, stats.max_batch,
+		           stats.busy_permille / 10, stats.busy_permille % 10, stats.stalls,
+		           stats.out_depth, stats.out_high_water, stats.out_capacity, stats.dropped);
+	}
+}
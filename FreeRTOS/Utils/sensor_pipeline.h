@@ -0,0 +1,87 @@
+/*
+ * sensor_pipeline.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+
+#ifndef SENSOR_PIPELINE_H_
+#define SENSOR_PIPELINE_H_
+
+#include "cmsis_os2.h"
+#include "sensor_sched.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Staged sensor data path. SensorTask acquires samples; each later stage is
+// its own task, fed by a lock-free SPSC ring from the stage before:
+//
+//   acquire --ring--> filter --ring--> aggregate --ring--> publish
+//   (SensorTask)      low-pass         history buckets,    snapshot,
+//                                      alarm rules,        sensor topic
+//                                      flash log,
+//                                      merged message
+//                                      per pass
+//
+// Stages move up to PIPE_BATCH items per pass and only take what the next
+// ring has room for, so a slow stage backs up its input ring instead of
+// losing data. Only acquire, which must never block, drops samples.
+
+#define PIPE_BATCH               32
+#define PIPE_ACQ_RING_ITEMS      256
+#define PIPE_FILTER_RING_ITEMS   256
+#define PIPE_PUBLISH_RING_ITEMS  64
+
+#define PIPE_FLAG_DATA           0x01U   // Input ring has items
+#define PIPE_FLAG_SPACE          0x02U   // Output ring has room again
+
+typedef enum {
+	PIPE_STAGE_ACQUIRE = 0,
+	PIPE_STAGE_FILTER,
+	PIPE_STAGE_AGGREGATE,
+	PIPE_STAGE_PUBLISH,
+	PIPE_STAGE_COUNT
+} PipeStageId_t;
+
+typedef struct {
+	uint32_t time_ms;
+	uint16_t pass;               // Acquisition pass; the aggregate stage merges on it
+	uint16_t time_us;            // 0..999 us past time_ms, where the source has it
+	uint32_t id;                 // SensorId_t
+	float value;
+} PipeSample_t;
+
+typedef struct {
+	const char *name;
+	uint32_t items_in;
+	uint32_t items_out;
+	uint32_t batches;
+	uint32_t max_batch;
+	uint32_t items_per_s;        // Output rate since the last reset
+	uint32_t busy_permille;      // Time spent processing, 0 for acquire
+	uint32_t stalls;             // Passes that found input but no room downstream
+	uint32_t dropped;            // Acquire only: samples refused by a full ring
+	uint32_t out_depth;          // Output ring now, peak and size; 0 for publish
+	uint32_t out_high_water;
+	uint32_t out_capacity;
+} PipeStageStats_t;
+
+extern osThreadId_t PipeFilterTaskHandle;
+extern osThreadId_t PipeAggregateTaskHandle;
+extern osThreadId_t PipePublishTaskHandle;
+
+void sensor_pipeline_init(void);
+
+// Task body for every stage after acquire; 'argument' is the PipeStageId_t
+void PipeStageTaskFunc(void *argument);
+
+// Acquire stage, called from SensorTask only. Returns how many samples
+// were accepted; the rest are counted as dropped.
+uint32_t sensor_pipeline_acquire(const PipeSample_t *samples, uint32_t count);
+
+void sensor_pipeline_set_filter(SensorId_t id, float alpha);
+
+void sensor_pipeline_get_stats(PipeStageId_t stage, PipeStageStats_t *stats);
+void sensor_pipeline_reset_stats(void);
+
+#endif /* SENSOR_PIPELINE_H_ */
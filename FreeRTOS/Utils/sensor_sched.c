@@ -0,0 +1,501 @@
+/*
+ * sensor_sched.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+#include "sensor_sched.h"
+#include "task.h"
+#include "app_tasks.h"
+#include "cli_registry.h"
+#include "sensor_pipeline.h"
+#include "sensor_snapshot.h"
+#include "adc_acq.h"
+#include "sensor_drdy.h"
+#include "siggen.h"
+#include "bus.h"
+#include "cycle_counter.h"
+#include "kv_store.h"
+#include "uart_logger.h"
+#include "main.h"
+#include <stdio.h>
+#include <string.h>
+
+#define SENSOR_POLLED           (-1)    // No data-ready line; sampled on its period
+#define SENSOR_ON_ADC           (-1)    // Read through 'read', not over a bus
+#define SENSOR_BUS_SCALE        0.01f   // Bus registers hold signed hundredths
+
+typedef float (*SensorReadFunc_t)(void);
+
+typedef struct {
+	const char *name;
+	SensorReadFunc_t read;
+	uint32_t period_ms;
+	int8_t drdy;                 // DrdyLine_t, or SENSOR_POLLED
+	int8_t bus;                  // BusId_t, or SENSOR_ON_ADC
+	uint8_t bus_device;
+	uint8_t bus_reg;
+	TickType_t next_due;
+	uint32_t samples;
+	uint32_t missed;
+	uint32_t last_jitter_ms;
+	uint32_t max_jitter_ms;
+} SensorChannel_t;
+
+// Die temperature and the PA0 input from the ADC; fixed readings until the
+// first ADC half has been processed
+static float read_temperature(void)
+{
+	float celsius;
+	return adc_acq_temperature_c(&celsius) ? celsius : 25.0f;
+}
+
+static float read_pressure(void)
+{
+	float percent;
+	return adc_acq_input_percent(ADC_CH_PA0, &percent) ? percent : 10.0f;
+}
+
+static SensorChannel_t sensors[SENSOR_COUNT] = {
+	[SENSOR_TEMPERATURE] = { "temp",     read_temperature, 1000, SENSOR_POLLED, SENSOR_ON_ADC },
+	[SENSOR_PRESSURE]    = { "pressure", read_pressure,    1000, SENSOR_POLLED, SENSOR_ON_ADC },
+};
+
+// Bus-read sensors: a due sample submits a two-byte big-endian register read,
+// the completion callback wakes SensorTask, and sensor_sched_service_bus()
+// acquires the value stamped with the time the read was issued for. Only
+// SensorTask touches these, apart from the bus writing 'rx' and 'status'.
+typedef struct {
+	BusXfer_t xfer;
+	uint8_t reg;
+	uint8_t rx[2];
+	bool pending;                // Submitted and not yet acquired
+	uint32_t time_ms;
+	uint16_t time_us;
+	uint32_t errors;             // Reads that failed or found the last one still in flight
+} SensorBusRead_t;
+
+static SensorBusRead_t bus_reads[SENSOR_COUNT];
+
+// Acquire stage output is batched per SensorTask pass
+static PipeSample_t acquired[PIPE_BATCH];
+static uint32_t acquired_count = 0;
+
+// Samples taken together (one poll deadline, one data-ready edge, one
+// generator row) carry the same pass number and are merged downstream
+static uint16_t acquire_pass = 0;
+static uint32_t siggen_row = UINT32_MAX;
+
+static void sensor_pass_begin(void)
+{
+	acquire_pass++;
+}
+
+static void sensor_acquire(uint32_t id, float value, uint32_t time_ms, uint16_t time_us)
+{
+	acquired[acquired_count++] = (PipeSample_t){ .time_ms = time_ms, .pass = acquire_pass, .time_us = time_us,
+	                                             .id = id, .value = value };
+	if (acquired_count == PIPE_BATCH) {
+		sensor_pipeline_acquire(acquired, acquired_count);
+		acquired_count = 0;
+	}
+}
+
+static void sensor_acquire_flush(void)
+{
+	if (acquired_count > 0) {
+		sensor_pipeline_acquire(acquired, acquired_count);
+		acquired_count = 0;
+	}
+}
+
+static void sensor_bus_done(BusXfer_t *xfer)
+{
+	if (SensorTaskHandle != NULL) {
+		osThreadFlagsSet(SensorTaskHandle, SENSOR_FLAG_BUS);
+	}
+}
+
+static void sensor_bus_read(uint32_t id, BusId_t bus, uint8_t device, uint8_t reg, uint32_t time_ms, uint16_t time_us)
+{
+	SensorBusRead_t *r = &bus_reads[id];
+
+	if (r->pending) {
+		r->errors++;             // Previous read not back yet; skip this one
+		return;
+	}
+
+	r->reg = reg;
+	r->time_ms = time_ms;
+	r->time_us = time_us;
+	bus_xfer_reg_read(&r->xfer, device, &r->reg, r->rx, sizeof(r->rx), sensor_bus_done, NULL);
+	r->pending = bus_submit(bus, &r->xfer);
+	if (!r->pending) {
+		r->errors++;
+	}
+}
+
+TickType_t sensor_sched_poll(TickType_t now)
+{
+	TickType_t earliest = now + pdMS_TO_TICKS(SENSOR_MAX_PERIOD_MS);
+	bool pass_open = false;
+
+	for (uint32_t n = 0; n < SENSOR_COUNT; n++) {
+		SensorChannel_t *s = &sensors[n];
+		TickType_t period = pdMS_TO_TICKS(s->period_ms);
+
+		taskENTER_CRITICAL();
+		TickType_t due = s->next_due;
+		bool polled = (s->drdy == SENSOR_POLLED) && !siggen_is_generated((SensorId_t)n);
+		int8_t bus = s->bus;
+		uint8_t device = s->bus_device, reg = s->bus_reg;
+		taskEXIT_CRITICAL();
+
+		if (!polled) {
+			continue;
+		}
+
+		// Signed difference copes with tick counter wrap
+		if ((int32_t)(now - due) >= 0) {
+			uint32_t late = now - due;
+			uint32_t skipped = late / period;
+
+			if (bus != SENSOR_ON_ADC) {
+				sensor_bus_read(n, (BusId_t)bus, device, reg, now * portTICK_PERIOD_MS, 0);
+			} else {
+				if (!pass_open) {
+					sensor_pass_begin();
+					pass_open = true;
+				}
+				sensor_acquire(n, s->read(), now * portTICK_PERIOD_MS, 0);
+			}
+
+			taskENTER_CRITICAL();
+			if (s->next_due == due) {   // Not rescheduled by the CLI meanwhile
+				s->next_due = due + (skipped + 1) * period;
+			}
+			if (bus == SENSOR_ON_ADC) {
+				s->samples++;    // Bus reads count when they come back
+			}
+			s->missed += skipped;
+			s->last_jitter_ms = (late % period) * portTICK_PERIOD_MS;
+			if (s->last_jitter_ms > s->max_jitter_ms) {
+				s->max_jitter_ms = s->last_jitter_ms;
+			}
+			due = s->next_due;
+			taskEXIT_CRITICAL();
+		}
+
+		if ((int32_t)(due - earliest) < 0) {
+			earliest = due;
+		}
+	}
+	sensor_acquire_flush();
+	return earliest;
+}
+
+void sensor_sched_service_drdy(void)
+{
+	// Each line's edge is taken once per pass and handed to every sensor on
+	// it, so sensors sharing a line all sample on the same edge
+	DrdyEvent_t edges[DRDY_COUNT];
+	bool pending[DRDY_COUNT];
+
+	uint16_t passes[DRDY_COUNT];
+
+	for (uint32_t l = 0; l < DRDY_COUNT; l++) {
+		pending[l] = sensor_drdy_take((DrdyLine_t)l, &edges[l]);
+		if (pending[l]) {
+			sensor_pass_begin();
+			passes[l] = acquire_pass;
+		}
+	}
+
+	for (uint32_t n = 0; n < SENSOR_COUNT; n++) {
+		SensorChannel_t *s = &sensors[n];
+
+		if (s->drdy == SENSOR_POLLED || !pending[s->drdy] || siggen_is_generated((SensorId_t)n)) {
+			continue;
+		}
+		acquire_pass = passes[s->drdy];
+
+		DrdyEvent_t *edge = &edges[s->drdy];
+		if (s->bus != SENSOR_ON_ADC) {
+			// Latency is edge to submit; the value arrives via the bus
+			sensor_bus_read(n, (BusId_t)s->bus, s->bus_device, s->bus_reg,
+			                edge->tick * portTICK_PERIOD_MS, edge->tick_us);
+			sensor_drdy_record_latency((DrdyLine_t)s->drdy, cycle_counter_now() - edge->cycles);
+			continue;
+		}
+		float value = s->read();
+		sensor_drdy_record_latency((DrdyLine_t)s->drdy, cycle_counter_now() - edge->cycles);
+		sensor_acquire(n, value, edge->tick * portTICK_PERIOD_MS, edge->tick_us);
+
+		taskENTER_CRITICAL();
+		s->samples++;
+		taskEXIT_CRITICAL();
+	}
+	sensor_acquire_flush();
+}
+
+void sensor_sched_service_bus(void)
+{
+	// Reads that finish together form one pass, whatever they were issued for
+	bool pass_open = false;
+
+	for (uint32_t n = 0; n < SENSOR_COUNT; n++) {
+		SensorBusRead_t *r = &bus_reads[n];
+		BusXferStatus_t status = r->xfer.status;
+
+		if (!r->pending || status == BUS_XFER_QUEUED || status == BUS_XFER_ACTIVE) {
+			continue;
+		}
+		r->pending = false;
+		if (status != BUS_XFER_OK) {
+			r->errors++;
+			continue;
+		}
+
+		if (!pass_open) {
+			sensor_pass_begin();
+			pass_open = true;
+		}
+		int16_t raw = (int16_t)((r->rx[0] << 8) | r->rx[1]);
+		sensor_acquire(n, (float)raw * SENSOR_BUS_SCALE, r->time_ms, r->time_us);
+
+		taskENTER_CRITICAL();
+		sensors[n].samples++;
+		taskEXIT_CRITICAL();
+	}
+	sensor_acquire_flush();
+}
+
+static void sensor_siggen_sink(SensorId_t id, float value, uint32_t time_ms, uint16_t time_us, uint32_t row)
+{
+	if (row != siggen_row) {
+		siggen_row = row;
+		sensor_pass_begin();
+	}
+	sensor_acquire(id, value, time_ms, time_us);
+	sensors[id].samples++;
+}
+
+void sensor_sched_service_siggen(void)
+{
+	siggen_drain(sensor_siggen_sink);
+	sensor_acquire_flush();
+}
+
+static void sensor_sched_wake(void)
+{
+	// The task may be sleeping toward an old deadline; wake it to pick up the new one
+	if (SensorTaskHandle != NULL) {
+		osThreadFlagsSet(SensorTaskHandle, SENSOR_FLAG_RESCHEDULE);
+	}
+}
+
+bool sensor_set_rate(SensorId_t id, uint32_t period_ms)
+{
+	if (id >= SENSOR_COUNT || period_ms < SENSOR_MIN_PERIOD_MS || period_ms > SENSOR_MAX_PERIOD_MS) {
+		return false;
+	}
+
+	taskENTER_CRITICAL();
+	sensors[id].period_ms = period_ms;
+	sensors[id].next_due = xTaskGetTickCount() + pdMS_TO_TICKS(period_ms);
+	sensors[id].max_jitter_ms = 0;
+	taskEXIT_CRITICAL();
+
+	sensor_sched_wake();
+	return true;
+}
+
+bool sensor_set_drdy(SensorId_t id, int line)
+{
+	if (id >= SENSOR_COUNT || line < SENSOR_POLLED || line >= DRDY_COUNT) {
+		return false;
+	}
+
+	taskENTER_CRITICAL();
+	sensors[id].drdy = (int8_t)line;
+	sensors[id].next_due = xTaskGetTickCount() + pdMS_TO_TICKS(sensors[id].period_ms);
+	taskEXIT_CRITICAL();
+
+	sensor_sched_wake();
+	return true;
+}
+
+bool sensor_set_bus(SensorId_t id, int bus, uint8_t device, uint8_t reg)
+{
+	if (id >= SENSOR_COUNT || bus < SENSOR_ON_ADC || bus >= BUS_COUNT || device > 0x7F) {
+		return false;
+	}
+
+	taskENTER_CRITICAL();
+	sensors[id].bus = (int8_t)bus;
+	sensors[id].bus_device = device;
+	sensors[id].bus_reg = reg;
+	taskEXIT_CRITICAL();
+	return true;
+}
+
+// Saved periods are keyed "rate.<sensor>"
+static void rate_key(SensorId_t id, char *key, uint32_t size)
+{
+	snprintf(key, size, "rate.%s", sensors[id].name);
+}
+
+void sensor_sched_load_settings(void)
+{
+	char key[KV_MAX_KEY_LEN + 1];
+
+	for (uint32_t n = 0; n < SENSOR_COUNT; n++) {
+		rate_key((SensorId_t)n, key, sizeof(key));
+		uint32_t period_ms = kv_get_u32(key, 0);
+		if (period_ms != 0) {
+			sensor_set_rate((SensorId_t)n, period_ms);
+		}
+	}
+}
+
+int sensor_find(const char *name)
+{
+	for (uint32_t n = 0; n < SENSOR_COUNT; n++) {
+		if (strcmp(sensors[n].name, name) == 0) {
+			return (int)n;
+		}
+	}
+	return -1;
+}
+
+void sensor_get_stats(SensorId_t id, SensorStats_t *stats)
+{
+	if (id >= SENSOR_COUNT || stats == NULL) {
+		return;
+	}
+
+	taskENTER_CRITICAL();
+	stats->name = sensors[id].name;
+	stats->period_ms = sensors[id].period_ms;
+	stats->samples = sensors[id].samples;
+	stats->missed = sensors[id].missed;
+	stats->last_jitter_ms = sensors[id].last_jitter_ms;
+	stats->max_jitter_ms = sensors[id].max_jitter_ms;
+	stats->drdy_line = sensors[id].drdy;
+	stats->bus = sensors[id].bus;
+	stats->bus_device = sensors[id].bus_device;
+	stats->bus_reg = sensors[id].bus_reg;
+	stats->bus_errors = bus_reads[id].errors;
+	taskEXIT_CRITICAL();
+}
+
+CLI_COMMAND(sensors, "", "", "Show sensor rates, jitter and missed deadlines")
+{
+	for (uint32_t n = 0; n < SENSOR_COUNT; n++) {
+		SensorStats_t stats;
+		sensor_get_stats((SensorId_t)n, &stats);
+		if (siggen_is_generated((SensorId_t)n)) {
+			log_printf("%s: from the signal generator, samples %lu\r\n", stats.name, stats.samples);
+			continue;
+		}
+		if (stats.bus != SENSOR_ON_ADC) {
+			BusStats_t bus;
+			bus_get_stats((BusId_t)stats.bus, &bus);
+			log_printf("%s: read from %s 0x%02X reg 0x%02X, bus errors %lu\r\n", stats.name, bus.name,
+			           stats.bus_device, stats.bus_reg, stats.bus_errors);
+		}
+		if (stats.drdy_line != SENSOR_POLLED) {
+			DrdyStats_t drdy;
+			sensor_drdy_get_stats((DrdyLine_t)stats.drdy_line, &drdy);
+			log_printf("%s: on %s data-ready, samples %lu\r\n", stats.name, drdy.name, stats.samples);
+			continue;
+		}
+		log_printf("%s: every %lu ms, samples %lu, missed %lu, jitter %lu ms (max %lu ms)\r\n",
+		           stats.name, stats.period_ms, stats.samples, stats.missed,
+		           stats.last_jitter_ms, stats.max_jitter_ms);
+	}
+	log_printf("Snapshot read retries: %lu\r\n", sensor_snapshot_retries());
+}
+
+CLI_COMMAND(rate, "su", "<temp|pressure> <period_ms>", "Set a sensor sampling period")
+{
+	int id = sensor_find(args->v[0].s);
+	if (id < 0) {
+		log_printf("Unknown sensor '%s'\r\n", args->v[0].s);
+		return;
+	}
+	if (sensor_set_rate((SensorId_t)id, args->v[1].u)) {
+		char key[KV_MAX_KEY_LEN + 1];
+		rate_key((SensorId_t)id, key, sizeof(key));
+		bool saved = kv_set_u32(key, args->v[1].u);
+		log_printf("%s now sampled every %lu ms%s\r\n", args->v[0].s, args->v[1].u, saved ? "" : " (not saved)");
+	} else {
+		log_printf("Period must be %u..%u ms\r\n", SENSOR_MIN_PERIOD_MS, SENSOR_MAX_PERIOD_MS);
+	}
+}
+
+// source <sensor> adc | source <sensor> <bus> <device> <reg>
+CLI_COMMAND(source, "ss|uu", "<temp|pressure> <adc | i2c1|spi1|mock <device> <reg>>", "Read a sensor from the ADC or a bus register")
+{
+	int id = sensor_find(args->v[0].s);
+	bool adc = (strcmp(args->v[1].s, "adc") == 0);
+	int bus = adc ? SENSOR_ON_ADC : bus_find(args->v[1].s);
+
+	if (id < 0 || (!adc && (bus < 0 || args->count < 4))) {
+		log_printf("Usage: source <temp|pressure> <adc | i2c1|spi1|mock <device> <reg>>\r\n");
+		return;
+	}
+	if (!adc && (args->v[2].u > 0x7F || args->v[3].u > 0xFF)) {
+		log_printf("Device must be <= 0x7F and reg <= 0xFF\r\n");
+		return;
+	}
+
+	sensor_set_bus((SensorId_t)id, bus, adc ? 0 : (uint8_t)args->v[2].u, adc ? 0 : (uint8_t)args->v[3].u);
+	log_printf("%s now read from %s\r\n", args->v[0].s, args->v[1].s);
+}
+
+CLI_COMMAND(filter, "sf", "<temp|pressure> <alpha 0..1>", "Set a sensor's low-pass smoothing (1 = off)")
+{
+	int id = sensor_find(args->v[0].s);
+	float alpha = args->v[1].f;
+
+	if (id < 0 || alpha <= 0.0f || alpha > 1.0f) {
+		log_printf("Usage: filter <temp|pressure> <alpha 0..1>\r\n");
+		return;
+	}
+
+	sensor_pipeline_set_filter((SensorId_t)id, alpha);
+	log_printf("%s low-pass alpha set\r\n", args->v[0].s);
+}
+
+// drdy | drdy <sensor> <line|off>
+CLI_COMMAND(drdy, "|ss", "[<temp|pressure> <b1|off>]", "Data-ready lines, or drive a sensor from one")
+{
+	if (args->count == 1) {
+		log_printf("Usage: drdy [<temp|pressure> <b1|off>]\r\n");
+		return;
+	}
+	if (args->count == 2) {
+		int id = sensor_find(args->v[0].s);
+		int line = (strcmp(args->v[1].s, "off") == 0) ? SENSOR_POLLED : sensor_drdy_find(args->v[1].s);
+		if (id < 0 || (line == SENSOR_POLLED && strcmp(args->v[1].s, "off") != 0)) {
+			log_printf("Unknown sensor or line\r\n");
+			return;
+		}
+		sensor_set_drdy((SensorId_t)id, line);
+	}
+
+	for (uint32_t n = 0; n < DRDY_COUNT; n++) {
+		DrdyStats_t stats;
+		sensor_drdy_get_stats((DrdyLine_t)n, &stats);
+		log_printf("%s: edges %lu, overruns %lu, edge-to-read %lu us (max %lu us)\r\n", stats.name,
+		           stats.events, stats.overruns, stats.last_latency_us, stats.max_latency_us);
+	}
+	for (uint32_t n = 0; n < SENSOR_COUNT; n++) {
+		if (sensors[n].drdy != SENSOR_POLLED) {
+			DrdyStats_t stats;
+			sensor_drdy_get_stats((DrdyLine_t)sensors[n].drdy, &stats);
+			log_printf("  %s driven by %s\r\n", sensors[n].name, stats.name);
+		}
+	}
+}
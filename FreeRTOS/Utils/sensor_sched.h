@@ -0,0 +1,67 @@
+/*
+ * sensor_sched.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+
+#ifndef SENSOR_SCHED_H_
+#define SENSOR_SCHED_H_
+
+#include "FreeRTOS.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SENSOR_MIN_PERIOD_MS    1
+#define SENSOR_MAX_PERIOD_MS    60000
+
+typedef enum {
+	SENSOR_TEMPERATURE = 0,
+	SENSOR_PRESSURE,
+	SENSOR_COUNT
+} SensorId_t;
+
+typedef struct {
+	const char *name;
+	uint32_t period_ms;
+	uint32_t samples;
+	uint32_t missed;             // Whole periods skipped because the task ran late
+	uint32_t last_jitter_ms;     // Lateness of the most recent sample
+	uint32_t max_jitter_ms;
+	int drdy_line;               // DrdyLine_t when data-ready driven, -1 when polled
+	int bus;                     // BusId_t when read over a bus, -1 for the ADC
+	uint8_t bus_device;
+	uint8_t bus_reg;
+	uint32_t bus_errors;         // Failed or skipped bus reads
+} SensorStats_t;
+
+// Samples every polled sensor that is due at 'now' and returns the tick at
+// which the next one falls due. Deadlines sit on a fixed grid per sensor, so
+// late wake-ups do not accumulate drift.
+TickType_t sensor_sched_poll(TickType_t now);
+
+// Reads every data-ready driven sensor whose line has a latched edge,
+// stamping the sample with the edge time rather than the read time.
+// Several sensors may share a line; one edge is read by all of them.
+void sensor_sched_service_drdy(void);
+
+// Acquires every bus read that has completed since the last call. Due or
+// data-ready samples of a bus-read sensor only submit the read; the bus
+// callback raises SENSOR_FLAG_BUS so SensorTask can collect the result.
+void sensor_sched_service_bus(void);
+
+// Feeds every row the signal generator has produced through the pipeline
+void sensor_sched_service_siggen(void);
+
+bool sensor_set_rate(SensorId_t id, uint32_t period_ms);
+// Applies periods saved by 'rate'; call after kv_init()
+void sensor_sched_load_settings(void);
+// Drives a sensor from a data-ready line (DrdyLine_t), or back to polling with -1
+bool sensor_set_drdy(SensorId_t id, int line);
+// Reads a sensor's value from a big-endian int16 register (hundredths) on
+// 'bus' (BusId_t), or from its ADC channel again with -1
+bool sensor_set_bus(SensorId_t id, int bus, uint8_t device, uint8_t reg);
+int sensor_find(const char *name);
+void sensor_get_stats(SensorId_t id, SensorStats_t *stats);
+
+#endif /* SENSOR_SCHED_H_ */
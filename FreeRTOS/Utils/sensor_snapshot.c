@@ -0,0 +1,52 @@
+/*
+ * sensor_snapshot.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+#include "sensor_snapshot.h"
+#include "main.h"
+
+// Sequence lock over two slots. The sequence is odd while a publish is
+// copying and even once it is done, so seq / 2 counts finished publishes
+// and publish k writes slot k & 1. A reader copies the slot of the newest
+// finished publish, which the writer next touches two publishes later; a
+// reader that sees the sequence reach that write's odd start retries.
+// Readers never spin on an odd value alone: an ISR that preempts the
+// writer mid-copy would never see it finish.
+static SensorMessage_t snapshot_slots[2];
+static volatile uint32_t snapshot_seq = 0;
+static volatile uint32_t snapshot_retry_count = 0;
+
+void sensor_snapshot_publish(const SensorMessage_t *msg)
+{
+	uint32_t seq = snapshot_seq;
+
+	snapshot_seq = seq + 1;      // Odd: publish (seq / 2) + 1 in progress
+	__DMB();
+	snapshot_slots[((seq >> 1) + 1) & 1] = *msg;
+	__DMB();                     // Slot contents visible before it counts as finished
+	snapshot_seq = seq + 2;
+}
+
+void sensor_snapshot_read(SensorMessage_t *out)
+{
+	for (;;) {
+		uint32_t start = snapshot_seq;
+		uint32_t done = start >> 1;
+		__DMB();
+		*out = snapshot_slots[done & 1];
+		__DMB();
+
+		// Publish done + 2 rewrites our slot and starts at seq 2 * done + 3
+		if (snapshot_seq - (done << 1) < 3) {
+			return;
+		}
+		snapshot_retry_count++;
+	}
+}
+
+uint32_t sensor_snapshot_retries(void)
+{
+	return snapshot_retry_count;
+}
@@ -0,0 +1,22 @@
+/*
+ * sensor_snapshot.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+
+#ifndef SENSOR_SNAPSHOT_H_
+#define SENSOR_SNAPSHOT_H_
+
+#include "app_tasks.h"
+#include <stdint.h>
+
+// Latest SensorMessage_t shared without a lock. Single writer (the
+// pipeline's publish stage); any number of readers from tasks or ISRs. The
+// writer never waits and a reader retries only if a publish started on the
+// slot it was copying.
+void sensor_snapshot_publish(const SensorMessage_t *msg);
+void sensor_snapshot_read(SensorMessage_t *out);
+uint32_t sensor_snapshot_retries(void);
+
+#endif /* SENSOR_SNAPSHOT_H_ */
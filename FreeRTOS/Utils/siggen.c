@@ -0,0 +1,471 @@
+/*
+ * siggen.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+#include "siggen.h"
+#include "main.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "app_tasks.h"
+#include "cycle_counter.h"
+#include "sensor_history.h"
+#include "spsc_ring.h"
+#include "cli_registry.h"
+#include "uart_logger.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Waveform core: plain computation on SigGen_t, with no hardware or RTOS
+// calls, so it can be lifted into a host build unchanged.
+
+#define SINE_LUT_BITS            8
+#define SINE_LUT_SIZE            (1U << SINE_LUT_BITS)
+
+static float sine_lut[SINE_LUT_SIZE + 1];   // One extra entry for interpolation
+static bool sine_lut_ready = false;
+
+static void sine_lut_build(void)
+{
+	for (uint32_t i = 0; i <= SINE_LUT_SIZE; i++) {
+		sine_lut[i] = sinf(2.0f * (float)M_PI * (float)i / (float)SINE_LUT_SIZE);
+	}
+	sine_lut_ready = true;
+}
+
+// Linear interpolation between table entries; about 1e-4 worst-case error
+static float sine_q32(uint32_t phase)
+{
+	uint32_t index = phase >> (32 - SINE_LUT_BITS);
+	float frac = (float)(phase << SINE_LUT_BITS) * (1.0f / 4294967296.0f);
+	return sine_lut[index] + (sine_lut[index + 1] - sine_lut[index]) * frac;
+}
+
+// xorshift32: cheap, and the same seed gives the same run every time
+static float noise_unit(uint32_t *seed)
+{
+	uint32_t x = *seed;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*seed = x;
+	return (float)(int32_t)x * (1.0f / 2147483648.0f);   // -1 .. 1
+}
+
+void siggen_channel_reset(SigGen_t *gen, const SigChannelConfig_t *cfg, uint32_t rate_hz, uint32_t seed)
+{
+	if (!sine_lut_ready) {
+		sine_lut_build();
+	}
+
+	gen->cfg = *cfg;
+	gen->phase = 0;
+	gen->trace_pos = 0;
+	gen->seed = (seed != 0) ? seed : 1;
+
+	// Fraction of a period per sample, in Q32; periods under one sample alias
+	double per_period = (double)cfg->period_s * (double)rate_hz;
+	gen->phase_step = (per_period > 1.0) ? (uint32_t)(4294967296.0 / per_period) : 0x80000000U;
+}
+
+float siggen_channel_next(SigGen_t *gen, const float *trace, uint32_t trace_len)
+{
+	const SigChannelConfig_t *cfg = &gen->cfg;
+	float value = cfg->offset;
+
+	switch (cfg->shape) {
+	case SIGGEN_SINE:
+		value += cfg->amplitude * sine_q32(gen->phase);
+		break;
+	case SIGGEN_RAMP:
+		value += cfg->amplitude * (float)gen->phase * (1.0f / 4294967296.0f);
+		break;
+	case SIGGEN_NOISE:
+		value += cfg->amplitude * noise_unit(&gen->seed);
+		break;
+	case SIGGEN_STEP:
+		value += (gen->phase & 0x80000000U) ? cfg->amplitude : 0.0f;
+		break;
+	case SIGGEN_TRACE:
+		if (trace_len > 0) {
+			value = trace[gen->trace_pos];
+			gen->trace_pos = (gen->trace_pos + 1 == trace_len) ? 0 : gen->trace_pos + 1;
+		}
+		break;
+	default:
+		break;
+	}
+
+	if (cfg->noise > 0.0f) {
+		value += cfg->noise * noise_unit(&gen->seed);
+	}
+	gen->phase += gen->phase_step;
+	return value;
+}
+
+// TIM7 sample clock and the ring SensorTask drains
+#define SIGGEN_IRQ_PRIORITY      6       // Below configMAX_SYSCALL, may use FromISR APIs
+#define SIGGEN_SEED              0x5EED1234U
+
+typedef struct {
+	uint32_t time_ms;
+	uint16_t time_us;            // 0..999 us past time_ms
+	uint32_t row;                // Free-running, never reset
+	float value[SENSOR_COUNT];
+} SigRow_t;
+
+static SigGen_t generators[SENSOR_COUNT];
+static float traces[SENSOR_COUNT][SIGGEN_TRACE_MAX];
+static uint32_t trace_len[SENSOR_COUNT];
+
+// Single producer (TIM7 ISR), single consumer (SensorTask)
+SPSC_RING_DEFINE(sig_ring, SigRow_t, SIGGEN_RING_SAMPLES);
+static SigRow_t drain_rows[SIGGEN_BLOCK_SAMPLES];
+
+static SigGenStats_t sg_stats;
+static uint32_t wake_every;
+static uint32_t since_wake;
+static uint64_t isr_cycles_total;
+static TickType_t start_tick;
+static uint32_t row_count;
+
+// Sample clock as ms, us within the ms, and a remainder in units of
+// 1/rate us, so rows above 1 kHz still get distinct, evenly spaced times
+static uint32_t row_ms;
+static uint32_t row_us;
+static uint32_t row_us_step;
+static uint32_t row_us_rem;
+static uint32_t row_us_frac;
+
+void siggen_init(void)
+{
+	SigChannelConfig_t off = { .shape = SIGGEN_OFF, .period_s = 1.0f };
+
+	for (uint32_t n = 0; n < SENSOR_COUNT; n++) {
+		siggen_channel_reset(&generators[n], &off, 1, SIGGEN_SEED + n);
+	}
+
+	RCC->APB1ENR |= RCC_APB1ENR_TIM7EN;
+	__DSB();
+	TIM7->CR1 = 0;
+	TIM7->DIER = TIM_DIER_UIE;
+
+	HAL_NVIC_SetPriority(TIM7_IRQn, SIGGEN_IRQ_PRIORITY, 0);
+	HAL_NVIC_EnableIRQ(TIM7_IRQn);
+}
+
+void siggen_tim_irq(void)
+{
+	uint32_t start = cycle_counter_now();
+
+	TIM7->SR = ~TIM_SR_UIF;
+	sg_stats.produced++;
+
+	SigRow_t row = { .time_ms = row_ms, .time_us = (uint16_t)row_us, .row = row_count++ };
+	for (uint32_t n = 0; n < SENSOR_COUNT; n++) {
+		if (generators[n].cfg.shape != SIGGEN_OFF) {
+			row.value[n] = siggen_channel_next(&generators[n], traces[n], trace_len[n]);
+		}
+	}
+
+	// Generators advanced even if the row is dropped, so the signal keeps its timebase
+	if (spsc_push(&sig_ring, &row, 1) == 0) {
+		sg_stats.dropped++;
+	}
+
+	row_us += row_us_step;
+	row_us_frac += row_us_rem;
+	if (row_us_frac >= sg_stats.rate_hz) {
+		row_us_frac -= sg_stats.rate_hz;
+		row_us++;
+	}
+	if (row_us >= 1000) {
+		row_ms += row_us / 1000;
+		row_us %= 1000;
+	}
+
+	if (++since_wake >= wake_every) {
+		since_wake = 0;
+		if (SensorTaskHandle != NULL) {
+			osThreadFlagsSet(SensorTaskHandle, SENSOR_FLAG_SIGGEN);
+		}
+	}
+
+	uint32_t cycles = cycle_counter_now() - start;
+	isr_cycles_total += cycles;
+	if (cycles > sg_stats.isr_max_cycles) {
+		sg_stats.isr_max_cycles = cycles;
+	}
+}
+
+static uint32_t tim7_clock_hz(void)
+{
+	// APB1 timers run at twice PCLK1 whenever the APB1 prescaler is not 1
+	uint32_t pclk1 = HAL_RCC_GetPCLK1Freq();
+	return ((RCC->CFGR & RCC_CFGR_PPRE1) == RCC_CFGR_PPRE1_DIV1) ? pclk1 : 2 * pclk1;
+}
+
+bool siggen_start(uint32_t rate_hz)
+{
+	if (rate_hz < SIGGEN_MIN_RATE_HZ || rate_hz > SIGGEN_MAX_RATE_HZ) {
+		return false;
+	}
+
+	siggen_stop();
+
+	// Split the divider so ARR fits in 16 bits
+	uint32_t clk = tim7_clock_hz();
+	uint32_t ticks = clk / rate_hz;
+	uint32_t psc = (ticks - 1) / 65536U;
+	uint32_t arr = ticks / (psc + 1) - 1;
+
+	taskENTER_CRITICAL();
+	for (uint32_t n = 0; n < SENSOR_COUNT; n++) {
+		siggen_channel_reset(&generators[n], &generators[n].cfg, rate_hz, SIGGEN_SEED + n);
+	}
+	memset(&sg_stats, 0, sizeof(sg_stats));
+	sg_stats.rate_hz = rate_hz;
+	sg_stats.actual_rate_mhz = (uint32_t)((uint64_t)clk * 1000U / ((psc + 1) * (arr + 1)));
+	isr_cycles_total = 0;
+	sig_ring.tail = sig_ring.head;
+	sig_ring.high_water = 0;
+	sig_ring.push_failed = 0;
+	since_wake = 0;
+	// Wake SensorTask about once per millisecond, never less often than once per block
+	wake_every = rate_hz / 1000U;
+	if (wake_every == 0) {
+		wake_every = 1;
+	} else if (wake_every > SIGGEN_BLOCK_SAMPLES) {
+		wake_every = SIGGEN_BLOCK_SAMPLES;
+	}
+	start_tick = xTaskGetTickCount();
+	row_ms = start_tick * portTICK_PERIOD_MS;
+	row_us = 0;
+	row_us_step = 1000000U / rate_hz;
+	row_us_rem = 1000000U % rate_hz;
+	row_us_frac = 0;
+	sg_stats.running = true;
+	taskEXIT_CRITICAL();
+
+	TIM7->PSC = psc;
+	TIM7->ARR = arr;
+	TIM7->EGR = TIM_EGR_UG;
+	TIM7->SR = 0;
+	TIM7->CR1 = TIM_CR1_CEN;
+
+	// Generated channels leave the poller's schedule
+	if (SensorTaskHandle != NULL) {
+		osThreadFlagsSet(SensorTaskHandle, SENSOR_FLAG_RESCHEDULE);
+	}
+	return true;
+}
+
+void siggen_stop(void)
+{
+	TIM7->CR1 = 0;
+	TIM7->SR = 0;
+
+	taskENTER_CRITICAL();
+	if (sg_stats.running) {
+		sg_stats.elapsed_ms = (xTaskGetTickCount() - start_tick) * portTICK_PERIOD_MS;
+	}
+	sg_stats.running = false;
+	taskEXIT_CRITICAL();
+
+	if (SensorTaskHandle != NULL) {
+		osThreadFlagsSet(SensorTaskHandle, SENSOR_FLAG_RESCHEDULE);
+	}
+}
+
+bool siggen_is_generated(SensorId_t id)
+{
+	return sg_stats.running && id < SENSOR_COUNT && generators[id].cfg.shape != SIGGEN_OFF;
+}
+
+bool siggen_configure(SensorId_t id, const SigChannelConfig_t *cfg)
+{
+	if (id >= SENSOR_COUNT || cfg->shape >= SIGGEN_SHAPE_COUNT || cfg->period_s <= 0.0f) {
+		return false;
+	}
+
+	taskENTER_CRITICAL();
+	siggen_channel_reset(&generators[id], cfg, sg_stats.running ? sg_stats.rate_hz : 1, SIGGEN_SEED + id);
+	taskEXIT_CRITICAL();
+	return true;
+}
+
+void siggen_get_config(SensorId_t id, SigChannelConfig_t *cfg)
+{
+	if (id < SENSOR_COUNT) {
+		*cfg = generators[id].cfg;
+	}
+}
+
+void siggen_load_trace(SensorId_t id, const float *points, uint32_t count)
+{
+	if (id >= SENSOR_COUNT) {
+		return;
+	}
+	if (count > SIGGEN_TRACE_MAX) {
+		count = SIGGEN_TRACE_MAX;
+	}
+
+	taskENTER_CRITICAL();
+	memcpy(traces[id], points, count * sizeof(float));
+	trace_len[id] = count;
+	generators[id].trace_pos = 0;
+	taskEXIT_CRITICAL();
+}
+
+uint32_t siggen_drain(SigGenSinkFunc_t sink)
+{
+	uint32_t total = 0;
+	uint32_t rows;
+
+	while ((rows = spsc_pop(&sig_ring, drain_rows, SIGGEN_BLOCK_SAMPLES)) > 0) {
+		for (uint32_t r = 0; r < rows; r++) {
+			for (uint32_t n = 0; n < SENSOR_COUNT; n++) {
+				if (siggen_is_generated((SensorId_t)n)) {
+					sink((SensorId_t)n, drain_rows[r].value[n], drain_rows[r].time_ms,
+					     drain_rows[r].time_us, drain_rows[r].row);
+				}
+			}
+		}
+		total += rows;
+	}
+
+	taskENTER_CRITICAL();
+	sg_stats.consumed += total;
+	taskEXIT_CRITICAL();
+	return total;
+}
+
+void siggen_get_stats(SigGenStats_t *stats)
+{
+	taskENTER_CRITICAL();
+	*stats = sg_stats;
+	stats->ring_high_water = sig_ring.high_water;
+	stats->isr_avg_cycles = (sg_stats.produced > 0) ? (uint32_t)(isr_cycles_total / sg_stats.produced) : 0;
+	if (sg_stats.running) {
+		stats->elapsed_ms = (xTaskGetTickCount() - start_tick) * portTICK_PERIOD_MS;
+	}
+	taskEXIT_CRITICAL();
+}
+
+// Pulls the channel's raw history into its replay trace, oldest first. The
+// trace reads as empty while it is refilled, so a running generator just
+// outputs the offset meanwhile.
+static uint32_t siggen_record_trace(SensorId_t id)
+{
+	HistoryPoint_t chunk[8];
+	uint32_t count = 0;
+	uint32_t from = 0;
+
+	taskENTER_CRITICAL();
+	trace_len[id] = 0;
+	taskEXIT_CRITICAL();
+
+	while (count < SIGGEN_TRACE_MAX) {
+		uint32_t n = sensor_history_query(id, HISTORY_RES_RAW, from, UINT32_MAX, chunk, 8);
+		for (uint32_t i = 0; i < n && count < SIGGEN_TRACE_MAX; i++) {
+			traces[id][count++] = chunk[i].mean;
+		}
+		if (n < 8) {
+			break;
+		}
+		from = chunk[n - 1].start + 1;
+	}
+
+	taskENTER_CRITICAL();
+	trace_len[id] = count;
+	generators[id].trace_pos = 0;
+	taskEXIT_CRITICAL();
+	return count;
+}
+
+static const char *const shape_names[SIGGEN_SHAPE_COUNT] = { "off", "sine", "ramp", "noise", "step", "trace" };
+
+static void siggen_print_status(void)
+{
+	SigGenStats_t stats;
+	siggen_get_stats(&stats);
+
+	for (uint32_t n = 0; n < SENSOR_COUNT; n++) {
+		SigChannelConfig_t cfg;
+		SensorStats_t sensor;
+		siggen_get_config((SensorId_t)n, &cfg);
+		sensor_get_stats((SensorId_t)n, &sensor);
+		log_printf("%s: %s, offset %.2f, amplitude %.2f, period %.3f s, noise %.2f\r\n", sensor.name,
+		           shape_names[cfg.shape], cfg.offset, cfg.amplitude, cfg.period_s, cfg.noise);
+	}
+
+	uint32_t secs = stats.elapsed_ms / 1000U;
+	log_printf("Generator %s at %lu Hz (actual %lu.%03lu Hz)\r\n", stats.running ? "running" : "stopped",
+	           stats.rate_hz, stats.actual_rate_mhz / 1000U, stats.actual_rate_mhz % 1000U);
+	log_printf("Produced %lu, consumed %lu (%lu/s), dropped %lu, ring peak %lu/%u\r\n",
+	           stats.produced, stats.consumed, (secs > 0) ? stats.consumed / secs : stats.consumed,
+	           stats.dropped, stats.ring_high_water, SIGGEN_RING_SAMPLES);
+	log_printf("ISR %lu cycles avg, %lu max\r\n", stats.isr_avg_cycles, stats.isr_max_cycles);
+}
+
+// siggen | siggen start <rate_hz> | siggen stop | siggen <sensor> <shape> [amplitude] [period_s] [offset] [noise]
+CLI_COMMAND(siggen, "|ssffff", "[start <hz> | stop | <sensor> <shape> [amp] [period_s] [offset] [noise]]",
+            "Synthetic sensor signals for load testing")
+{
+	if (args->count == 0) {
+		siggen_print_status();
+		return;
+	}
+
+	if (strcmp(args->v[0].s, "stop") == 0) {
+		siggen_stop();
+		siggen_print_status();
+		return;
+	}
+
+	if (strcmp(args->v[0].s, "start") == 0 && args->count == 2) {
+		if (!siggen_start(strtoul(args->v[1].s, NULL, 0))) {
+			log_printf("Rate must be %u..%u Hz\r\n", SIGGEN_MIN_RATE_HZ, SIGGEN_MAX_RATE_HZ);
+		}
+		return;
+	}
+
+	int id = sensor_find(args->v[0].s);
+	int shape = -1;
+	for (uint32_t s = 0; args->count > 1 && s < SIGGEN_SHAPE_COUNT; s++) {
+		if (strcmp(args->v[1].s, shape_names[s]) == 0) {
+			shape = (int)s;
+		}
+	}
+	if (id < 0 || shape < 0) {
+		log_printf("Usage: siggen [start <hz> | stop | <sensor> <off|sine|ramp|noise|step|trace> [amp] [period_s] [offset] [noise]]\r\n");
+		return;
+	}
+
+	SigChannelConfig_t cfg;
+	siggen_get_config((SensorId_t)id, &cfg);
+	cfg.shape = (SigShape_t)shape;
+	if (args->count > 2) {
+		cfg.amplitude = args->v[2].f;
+	}
+	if (args->count > 3) {
+		cfg.period_s = args->v[3].f;
+	}
+	if (args->count > 4) {
+		cfg.offset = args->v[4].f;
+	}
+	if (args->count > 5) {
+		cfg.noise = args->v[5].f;
+	}
+
+	if (cfg.shape == SIGGEN_TRACE) {
+		log_printf("Recorded %lu raw samples as the %s trace\r\n", siggen_record_trace((SensorId_t)id), args->v[0].s);
+	}
+	if (!siggen_configure((SensorId_t)id, &cfg)) {
+		log_printf("Period must be positive\r\n");
+		return;
+	}
+	siggen_print_status();
+}
@@ -0,0 +1,90 @@
+/*
+ * siggen.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+
+#ifndef SIGGEN_H_
+#define SIGGEN_H_
+
+#include "sensor_sched.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Synthetic sensor source for load testing. TIM7 produces one sample per
+// tick for every generated channel into a ring that SensorTask drains, so
+// the rest of the pipeline (filter, snapshot, history, telemetry) runs
+// exactly as it does for real sensors, at a controlled and repeatable rate.
+
+#define SIGGEN_MIN_RATE_HZ       1
+#define SIGGEN_MAX_RATE_HZ       50000
+#define SIGGEN_RING_SAMPLES      256     // Must be a power of two
+#define SIGGEN_BLOCK_SAMPLES     32      // Samples per SensorTask wake-up at high rates
+#define SIGGEN_TRACE_MAX         240     // One raw history window
+
+typedef enum {
+	SIGGEN_OFF = 0,              // Channel keeps its real source
+	SIGGEN_SINE,
+	SIGGEN_RAMP,                 // Sawtooth from offset to offset + amplitude
+	SIGGEN_NOISE,                // Uniform noise, offset +/- amplitude
+	SIGGEN_STEP,                 // Square wave between offset and offset + amplitude
+	SIGGEN_TRACE,                // Loops the loaded trace, one point per sample
+	SIGGEN_SHAPE_COUNT
+} SigShape_t;
+
+typedef struct {
+	SigShape_t shape;
+	float offset;
+	float amplitude;
+	float period_s;              // Sine/ramp/step period
+	float noise;                 // Uniform noise added on top of any shape
+} SigChannelConfig_t;
+
+// Generator state for one channel. Pure computation with no hardware or
+// RTOS dependency, so the same code runs on a host build.
+typedef struct {
+	SigChannelConfig_t cfg;
+	uint32_t phase;              // Q32 fraction of the period
+	uint32_t phase_step;
+	uint32_t trace_pos;
+	uint32_t seed;
+} SigGen_t;
+
+void siggen_channel_reset(SigGen_t *gen, const SigChannelConfig_t *cfg, uint32_t rate_hz, uint32_t seed);
+float siggen_channel_next(SigGen_t *gen, const float *trace, uint32_t trace_len);
+
+typedef struct {
+	bool running;
+	uint32_t rate_hz;            // Requested rate
+	uint32_t actual_rate_mhz;    // What TIM7 divides down to, in millihertz
+	uint32_t produced;           // Sample rows generated
+	uint32_t consumed;           // Rows drained into the pipeline
+	uint32_t dropped;            // Rows lost because the ring was full
+	uint32_t ring_high_water;
+	uint32_t isr_avg_cycles;
+	uint32_t isr_max_cycles;
+	uint32_t elapsed_ms;         // Since start
+} SigGenStats_t;
+
+void siggen_init(void);
+void siggen_tim_irq(void);
+
+bool siggen_configure(SensorId_t id, const SigChannelConfig_t *cfg);
+void siggen_get_config(SensorId_t id, SigChannelConfig_t *cfg);
+bool siggen_start(uint32_t rate_hz);
+void siggen_stop(void);
+bool siggen_is_generated(SensorId_t id);
+
+// Replaces the replay trace for a channel; copies up to SIGGEN_TRACE_MAX points
+void siggen_load_trace(SensorId_t id, const float *points, uint32_t count);
+
+// Called by SensorTask: hands each generated value to 'sink' in order,
+// with the row's time (ms plus 0..999 us) and number. Returns the number of
+// rows drained.
+typedef void (*SigGenSinkFunc_t)(SensorId_t id, float value, uint32_t time_ms, uint16_t time_us, uint32_t row);
+uint32_t siggen_drain(SigGenSinkFunc_t sink);
+
+void siggen_get_stats(SigGenStats_t *stats);
+
+#endif /* SIGGEN_H_ */
@@ -0,0 +1,71 @@
+/*
+ * spsc_ring.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+#include "spsc_ring.h"
+#include "main.h"
+#include <string.h>
+
+// Copies 'count' items between linear memory and the ring starting at
+// 'index', splitting at the wrap point into at most two memcpy() calls
+static void ring_copy(const SpscRing_t *ring, uint32_t index, void *linear, uint32_t count, int to_ring)
+{
+	uint32_t capacity = ring->mask + 1;
+	uint32_t start = index & ring->mask;
+	uint32_t first = (count < capacity - start) ? count : capacity - start;
+	uint8_t *slot = ring->items + start * ring->item_size;
+	uint8_t *bytes = linear;
+
+	if (to_ring) {
+		memcpy(slot, bytes, first * ring->item_size);
+		memcpy(ring->items, bytes + first * ring->item_size, (count - first) * ring->item_size);
+	} else {
+		memcpy(bytes, slot, first * ring->item_size);
+		memcpy(bytes + first * ring->item_size, ring->items, (count - first) * ring->item_size);
+	}
+}
+
+uint32_t spsc_push(SpscRing_t *ring, const void *items, uint32_t count)
+{
+	uint32_t head = ring->head;
+	uint32_t space = (ring->mask + 1) - (head - ring->tail);
+
+	if (count > space) {
+		ring->push_failed += count - space;
+		count = space;
+	}
+	if (count == 0) {
+		return 0;
+	}
+
+	ring_copy(ring, head, (void *)items, count, 1);
+	__DMB();                     // Items land before the index that publishes them
+	ring->head = head + count;
+
+	uint32_t depth = head + count - ring->tail;
+	if (depth > ring->high_water) {
+		ring->high_water = depth;
+	}
+	return count;
+}
+
+uint32_t spsc_pop(SpscRing_t *ring, void *items, uint32_t max)
+{
+	uint32_t tail = ring->tail;
+	uint32_t count = ring->head - tail;
+
+	if (count > max) {
+		count = max;
+	}
+	if (count == 0) {
+		return 0;
+	}
+
+	__DMB();                     // Index read before the items it covers
+	ring_copy(ring, tail, items, count, 0);
+	__DMB();                     // Items copied out before the slots are handed back
+	ring->tail = tail + count;
+	return count;
+}
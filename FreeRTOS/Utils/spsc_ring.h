@@ -0,0 +1,61 @@
+/*
+ * spsc_ring.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+
+#ifndef SPSC_RING_H_
+#define SPSC_RING_H_
+
+#include <stdint.h>
+
+// Lock-free single-producer/single-consumer ring of fixed-size items. One
+// side may be an ISR. Indices run freely and are masked on access, so the
+// capacity must be a power of two and all of it is usable.
+//
+// The producer only writes 'head' and the consumer only writes 'tail'; each
+// sits on its own cache line so the two sides never share one. The F446 has
+// no data cache, so this costs a few bytes of padding and keeps the rings
+// correct on cached parts.
+#define SPSC_CACHE_LINE          32
+
+typedef struct {
+	volatile uint32_t head __attribute__((aligned(SPSC_CACHE_LINE)));
+	uint32_t high_water;         // Producer side: deepest the ring has been
+	uint32_t push_failed;        // Producer side: items refused because it was full
+	volatile uint32_t tail __attribute__((aligned(SPSC_CACHE_LINE)));
+	uint32_t mask __attribute__((aligned(SPSC_CACHE_LINE)));
+	uint32_t item_size;
+	uint8_t *items;
+} SpscRing_t;
+
+// Defines a ring named 'name' holding 'capacity' items of 'type', with
+// storage sized and checked at compile time
+#define SPSC_RING_DEFINE(name, type, capacity)                                          \
+	_Static_assert(((capacity) & ((capacity) - 1)) == 0, #name " capacity must be a power of two"); \
+	static type name##_items[capacity] __attribute__((aligned(SPSC_CACHE_LINE)));     \
+	static SpscRing_t name = { .mask = (capacity) - 1, .item_size = sizeof(type),      \
+	                           .items = (uint8_t *)name##_items }
+
+// Producer: copies up to 'count' items in, returns how many fit
+uint32_t spsc_push(SpscRing_t *ring, const void *items, uint32_t count);
+// Consumer: copies up to 'max' items out, returns how many were taken
+uint32_t spsc_pop(SpscRing_t *ring, void *items, uint32_t max);
+
+static inline uint32_t spsc_count(const SpscRing_t *ring)
+{
+	return ring->head - ring->tail;
+}
+
+static inline uint32_t spsc_capacity(const SpscRing_t *ring)
+{
+	return ring->mask + 1;
+}
+
+static inline uint32_t spsc_space(const SpscRing_t *ring)
+{
+	return spsc_capacity(ring) - spsc_count(ring);
+}
+
+#endif /* SPSC_RING_H_ */
@@ -0,0 +1,329 @@
+/*
+ * telemetry.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+#include "telemetry.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "msg_pool.h"
+#include "pubsub.h"
+#include "alarm.h"
+#include "cli_registry.h"
+#include "uart_logger.h"
+#include "ts_codec.h"
+#include <string.h>
+
+#define TELEMETRY_FLAG_SAMPLES      0x01U   // New items on the sensor topic
+#define TELEMETRY_FLAG_ALARMS       0x02U   // New items on the alarm topic
+#define TELEMETRY_ALARM_PAYLOAD     8
+#define TELEMETRY_SAMPLE_MAX_BYTES  6       // dt < 16384 fits a 2-byte varint, plus two int16
+
+// Worst case frame must fit one large pool block
+_Static_assert(TELEMETRY_HEADER_SIZE + TELEMETRY_MAX_BATCH * TELEMETRY_SAMPLE_MAX_BYTES + TELEMETRY_CRC_SIZE
+               <= MSG_POOL_LARGE_SIZE, "telemetry frame exceeds pool block");
+
+static PubSubSubscriber_t telemetry_sub = PUBSUB_SUBSCRIBER("telemetry", TelemetryTaskHandle, TELEMETRY_FLAG_SAMPLES);
+static PubSubSubscriber_t alarm_sub = PUBSUB_SUBSCRIBER("telemetry", TelemetryTaskHandle, TELEMETRY_FLAG_ALARMS);
+static uint16_t alarm_seq = 0;
+
+// Held by TelemetryTask while it builds and sends frames, and by
+// telemetry_configure() while the settings change
+static osMutexId_t telemetry_lock;
+
+// Frame under construction
+static uint8_t *frame_buf = NULL;
+static uint16_t frame_len;
+static uint8_t frame_count;
+static uint32_t frame_t0;
+static uint32_t frame_prev_ts;          // us after frame_t0
+static uint16_t frame_seq = 0;
+static TsCodec_t frame_codec;
+static uint32_t decimate_count = 0;
+
+static TelemetryStats_t stats = { .batch = 16, .every_n = 1 };
+
+void telemetry_init(void)
+{
+	telemetry_lock = osMutexNew(NULL);
+	if (telemetry_lock == NULL) {
+		log_printf("Telemetry mutex creation failed\r\n");
+	}
+	pubsub_subscribe(TOPIC_SENSOR, &telemetry_sub);
+	pubsub_subscribe(TOPIC_ALARM, &alarm_sub);
+}
+
+// CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF), matched by the host decoder
+static uint16_t crc16_ccitt(const uint8_t *data, uint32_t len)
+{
+	uint16_t crc = 0xFFFF;
+
+	for (uint32_t n = 0; n < len; n++) {
+		crc ^= (uint16_t)data[n] << 8;
+		for (uint8_t bit = 0; bit < 8; bit++) {
+			crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+		}
+	}
+	return crc;
+}
+
+static void put_u16(uint8_t *p, uint16_t v)
+{
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+	put_u16(p, (uint16_t)v);
+	put_u16(p + 2, (uint16_t)(v >> 16));
+}
+
+static uint16_t put_varint(uint8_t *p, uint32_t v)
+{
+	uint16_t n = 0;
+	while (v >= 0x80) {
+		p[n++] = (uint8_t)(v | 0x80);
+		v >>= 7;
+	}
+	p[n++] = (uint8_t)v;
+	return n;
+}
+
+// Scales to hundredths and clamps to int16
+static int16_t to_centi(float value)
+{
+	float scaled = value * 100.0f;
+	scaled += (scaled >= 0.0f) ? 0.5f : -0.5f;
+	if (scaled > 32767.0f) {
+		return 32767;
+	}
+	if (scaled < -32768.0f) {
+		return -32768;
+	}
+	return (int16_t)scaled;
+}
+
+uint16_t telemetry_frame_seal(uint8_t *frame, uint8_t type, uint8_t count, uint16_t seq,
+                              uint32_t t0, uint16_t payload_len)
+{
+	uint16_t end = TELEMETRY_HEADER_SIZE + payload_len;
+
+	frame[0] = TELEMETRY_SYNC0;
+	frame[1] = TELEMETRY_SYNC1;
+	frame[2] = type;
+	frame[3] = count;
+	put_u16(&frame[4], seq);
+	put_u16(&frame[6], payload_len);
+	put_u32(&frame[8], t0);
+	put_u16(&frame[end], crc16_ccitt(&frame[2], end - 2));
+	return end + TELEMETRY_CRC_SIZE;
+}
+
+static void telemetry_flush(void)
+{
+	if (frame_buf == NULL) {
+		return;
+	}
+
+	uint16_t len;
+	if (stats.compressed) {
+		len = telemetry_frame_seal(frame_buf, TELEMETRY_FRAME_GORILLA, frame_count, frame_seq++,
+		                           frame_t0, (uint16_t)ts_encoder_bytes(&frame_codec));
+	} else {
+		len = telemetry_frame_seal(frame_buf, TELEMETRY_FRAME_RAW, frame_count, frame_seq++,
+		                           frame_t0, frame_len - TELEMETRY_HEADER_SIZE);
+	}
+
+	uart_logger_write(frame_buf, len);
+	msg_pool_free(frame_buf);
+	frame_buf = NULL;
+	stats.frames_sent++;
+	stats.bytes_sent += len;
+	stats.samples_sent += frame_count;
+}
+
+static bool telemetry_open_frame(uint32_t timestamp_ms)
+{
+	frame_buf = msg_pool_alloc(MSG_POOL_LARGE_SIZE, 0);
+	if (frame_buf == NULL) {
+		// The sequence still advances so the host sees the gap
+		frame_seq++;
+		stats.frames_dropped++;
+		return false;
+	}
+
+	frame_len = TELEMETRY_HEADER_SIZE;
+	frame_count = 0;
+	frame_t0 = timestamp_ms;
+	frame_prev_ts = 0;
+	if (stats.compressed) {
+		ts_encoder_init(&frame_codec, &frame_buf[TELEMETRY_HEADER_SIZE],
+		                MSG_POOL_LARGE_SIZE - TELEMETRY_HEADER_SIZE - TELEMETRY_CRC_SIZE, 2);
+	}
+	return true;
+}
+
+// Sample times inside a frame are microseconds after the frame's t0_ms
+static uint32_t frame_offset_us(const SensorMessage_t *msg)
+{
+	return (msg->timestamp_ms - frame_t0) * 1000U + msg->timestamp_us;
+}
+
+static void telemetry_push(const SensorMessage_t *msg)
+{
+	if (!stats.enabled) {
+		return;
+	}
+	if (++decimate_count < stats.every_n) {
+		return;
+	}
+	decimate_count = 0;
+
+	// Close a partial batch rather than let it span too long
+	if (frame_buf != NULL && msg->timestamp_ms - frame_t0 >= TELEMETRY_MAX_LATENCY_MS) {
+		telemetry_flush();
+	}
+
+	if (frame_buf == NULL && !telemetry_open_frame(msg->timestamp_ms)) {
+		return;
+	}
+
+	if (stats.compressed) {
+		float values[2] = { msg->temperature, msg->pressure };
+		if (!ts_encoder_add(&frame_codec, frame_offset_us(msg), values)) {
+			// Out of room before the batch filled; start a fresh frame
+			telemetry_flush();
+			if (!telemetry_open_frame(msg->timestamp_ms)) {
+				return;
+			}
+			ts_encoder_add(&frame_codec, frame_offset_us(msg), values);
+		}
+		frame_count++;
+		if (frame_count >= stats.batch) {
+			telemetry_flush();
+		}
+		return;
+	}
+
+	uint32_t offset_us = frame_offset_us(msg);
+	frame_len += put_varint(&frame_buf[frame_len], offset_us - frame_prev_ts);
+	put_u16(&frame_buf[frame_len], (uint16_t)to_centi(msg->temperature));
+	put_u16(&frame_buf[frame_len + 2], (uint16_t)to_centi(msg->pressure));
+	frame_len += 4;
+	frame_prev_ts = offset_us;
+	frame_count++;
+
+	if (frame_count >= stats.batch) {
+		telemetry_flush();
+	}
+}
+
+static void telemetry_report_alarm(const AlarmEvent_t *ev)
+{
+	if (!stats.enabled) {
+		SensorStats_t sensor;
+		sensor_get_stats((SensorId_t)ev->channel, &sensor);
+		log_printf("[ALARM] %lu ms: rule %u %s %s %s (%.2f)\r\n", ev->time_ms, ev->rule, sensor.name,
+		           alarm_type_name((AlarmType_t)ev->type), ev->active ? "RAISED" : "cleared", ev->value);
+		return;
+	}
+
+	uint8_t frame[TELEMETRY_HEADER_SIZE + TELEMETRY_ALARM_PAYLOAD + TELEMETRY_CRC_SIZE];
+	uint8_t *payload = &frame[TELEMETRY_HEADER_SIZE];
+	uint32_t bits;
+
+	payload[0] = ev->rule;
+	payload[1] = ev->type;
+	payload[2] = ev->channel;
+	payload[3] = ev->active;
+	memcpy(&bits, &ev->value, sizeof(bits));
+	put_u32(&payload[4], bits);
+	uint16_t len = telemetry_frame_seal(frame, TELEMETRY_FRAME_ALARM, 1, alarm_seq++, ev->time_ms,
+	                                    TELEMETRY_ALARM_PAYLOAD);
+	uart_logger_write(frame, len);
+	stats.bytes_sent += len;
+}
+
+void TelemetryTaskFunc(void *argument)
+{
+	for (;;) {
+		// Flags latch, so anything published while we were sending still wakes us
+		osThreadFlagsWait(TELEMETRY_FLAG_SAMPLES | TELEMETRY_FLAG_ALARMS, osFlagsWaitAny, osWaitForever);
+
+		osMutexAcquire(telemetry_lock, osWaitForever);
+		// Alarms first: they are rare and their latency matters more
+		const AlarmEvent_t *ev;
+		while ((ev = pubsub_next(&alarm_sub)) != NULL) {
+			// Copied out, so a slot reused mid-read is dropped before anything is sent
+			AlarmEvent_t copy = *ev;
+			if (pubsub_release(&alarm_sub)) {
+				telemetry_report_alarm(&copy);
+			}
+		}
+
+		const SensorMessage_t *msg;
+		while ((msg = pubsub_next(&telemetry_sub)) != NULL) {
+			// Same as alarms: a sample overwritten while copied is not framed
+			SensorMessage_t copy = *msg;
+			if (pubsub_release(&telemetry_sub)) {
+				telemetry_push(&copy);
+			}
+		}
+		osMutexRelease(telemetry_lock);
+	}
+}
+
+bool telemetry_configure(bool enabled, bool compressed, uint32_t batch, uint32_t every_n)
+{
+	if (batch == 0 || batch > TELEMETRY_MAX_BATCH || every_n == 0) {
+		return false;
+	}
+
+	osMutexAcquire(telemetry_lock, osWaitForever);
+	// Close the open frame so it is sealed in the format it was built in
+	telemetry_flush();
+	vTaskSuspendAll();           // Against telemetry_get_stats()
+	stats.enabled = enabled;
+	stats.compressed = compressed;
+	stats.batch = batch;
+	stats.every_n = every_n;
+	xTaskResumeAll();
+	decimate_count = 0;
+	osMutexRelease(telemetry_lock);
+	return true;
+}
+
+void telemetry_get_stats(TelemetryStats_t *out)
+{
+	vTaskSuspendAll();
+	*out = stats;
+	xTaskResumeAll();
+}
+
+// stream on [batch] [every_n] [raw|gorilla] | stream off | stream
+CLI_COMMAND(stream, "|suus", "[on|off] [batch 1-32] [every_n] [raw|gorilla]", "Binary telemetry stream control")
+{
+	TelemetryStats_t current;
+	telemetry_get_stats(&current);
+
+	if (args->count > 0) {
+		bool on = (strcmp(args->v[0].s, "on") == 0);
+		uint32_t batch = (args->count > 1) ? args->v[1].u : current.batch;
+		uint32_t every_n = (args->count > 2) ? args->v[2].u : current.every_n;
+		bool compressed = (args->count > 3) ? (strcmp(args->v[3].s, "gorilla") == 0) : current.compressed;
+		bool valid_codec = (args->count <= 3) || compressed || strcmp(args->v[3].s, "raw") == 0;
+
+		if ((!on && strcmp(args->v[0].s, "off") != 0) || !valid_codec ||
+		    !telemetry_configure(on, compressed, batch, every_n)) {
+			log_printf("Usage: stream [on|off] [batch 1-32] [every_n] [raw|gorilla]\r\n");
+			return;
+		}
+		telemetry_get_stats(&current);
+	}
+
+	log_printf("Stream %s (%s), batch %lu, every %lu, frames %lu, dropped %lu, samples %lu, bytes %lu\r\n",
+	           current.enabled ? "on" : "off", current.compressed ? "gorilla" : "raw", current.batch, current.every_n, current.frames_sent,
+	           current.frames_dropped, current.samples_sent, current.bytes_sent);
+}
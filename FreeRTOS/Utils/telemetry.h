@@ -0,0 +1,73 @@
+/*
+ * telemetry.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#include "app_tasks.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Binary frame, little-endian, interleaved with text on the CLI UART:
+//   0  0xA5 0x5A   sync
+//   2  type        TELEMETRY_FRAME_*
+//   3  count       samples in the frame
+//   4  seq         uint16, +1 per frame including dropped ones
+//   6  length      uint16 payload bytes
+//   8  t0_ms       uint32 timestamp of the first sample
+//  12  payload
+//   .  crc16       CRC-16/CCITT-FALSE over type..end of payload
+//
+// TELEMETRY_FRAME_RAW payload, per sample:
+//   varint dt_us (LEB128, from t0_ms for the first sample), int16 temp x100, int16 pressure x100
+// TELEMETRY_FRAME_GORILLA payload: ts_codec bitstream of (us after t0_ms, temp, pressure)
+// TELEMETRY_FRAME_HISTORY payload: ts_codec bitstream of (bucket start, min, max, mean)
+// TELEMETRY_FRAME_ALARM payload, one event, t0 is its time:
+//   rule, type (AlarmType_t), channel (SensorId_t), active (1 raised, 0 cleared), float32 value
+// TELEMETRY_FRAME_FLASHLOG payload: one flash log entry as stored, a ts_codec
+//   bitstream of (log time s, temp, pressure); t0 is its first log time
+#define TELEMETRY_SYNC0             0xA5
+#define TELEMETRY_SYNC1             0x5A
+#define TELEMETRY_FRAME_RAW         0x01
+#define TELEMETRY_FRAME_GORILLA     0x02
+#define TELEMETRY_FRAME_HISTORY     0x03
+#define TELEMETRY_FRAME_ALARM       0x04
+#define TELEMETRY_FRAME_FLASHLOG    0x05
+#define TELEMETRY_HEADER_SIZE       12
+#define TELEMETRY_CRC_SIZE          2
+
+#define TELEMETRY_MAX_BATCH         32
+#define TELEMETRY_MAX_LATENCY_MS    1000    // A batch never spans more than this, keeping dt varints to 3 bytes
+
+typedef struct {
+	bool enabled;
+	bool compressed;             // Gorilla frames instead of fixed-point raw
+	uint32_t batch;
+	uint32_t every_n;            // Send one of every N published samples
+	uint32_t frames_sent;
+	uint32_t frames_dropped;     // No pool block free
+	uint32_t samples_sent;
+	uint32_t bytes_sent;
+} TelemetryStats_t;
+
+extern osThreadId_t TelemetryTaskHandle;
+
+// Subscribes to the sensor and alarm topics. TelemetryTask batches samples
+// into frames, and reports each alarm transition as it arrives: a frame of
+// its own while the stream is on, a console line otherwise.
+void telemetry_init(void);
+void TelemetryTaskFunc(void *argument);
+
+bool telemetry_configure(bool enabled, bool compressed, uint32_t batch, uint32_t every_n);
+
+// Fills in the header and trailing CRC around a payload already placed at
+// frame[TELEMETRY_HEADER_SIZE]. Returns the total frame length.
+uint16_t telemetry_frame_seal(uint8_t *frame, uint8_t type, uint8_t count, uint16_t seq,
+                              uint32_t t0, uint16_t payload_len);
+void telemetry_get_stats(TelemetryStats_t *stats);
+
+#endif /* TELEMETRY_H_ */
@@ -0,0 +1,246 @@
+/*
+ * ts_codec.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+#include "ts_codec.h"
+#include <string.h>
+
+static void put_bits(TsCodec_t *c, uint32_t value, uint8_t nbits)
+{
+	while (nbits > 0) {
+		uint32_t byte = c->bit_pos >> 3;
+		uint8_t space = 8 - (c->bit_pos & 7);
+		uint8_t take = (nbits < space) ? nbits : space;
+		uint8_t chunk = (uint8_t)((value >> (nbits - take)) & ((1U << take) - 1));
+
+		if (space == 8) {
+			c->buf[byte] = 0;
+		}
+		c->buf[byte] |= (uint8_t)(chunk << (space - take));
+		c->bit_pos += take;
+		nbits -= take;
+	}
+}
+
+// A read past the end (or a malformed field) parks bit_pos beyond cap_bits,
+// so every later read also fails and ts_decoder_next() reports it
+static void decode_fail(TsCodec_t *c)
+{
+	c->bit_pos = c->cap_bits + 1;
+}
+
+static uint32_t get_bits(TsCodec_t *c, uint8_t nbits)
+{
+	uint32_t value = 0;
+
+	if (c->bit_pos + nbits > c->cap_bits) {
+		decode_fail(c);
+		return 0;
+	}
+
+	while (nbits > 0) {
+		uint32_t byte = c->bit_pos >> 3;
+		uint8_t avail = 8 - (c->bit_pos & 7);
+		uint8_t take = (nbits < avail) ? nbits : avail;
+		uint8_t chunk = (uint8_t)((c->buf[byte] >> (avail - take)) & ((1U << take) - 1));
+
+		value = (value << take) | chunk;
+		c->bit_pos += take;
+		nbits -= take;
+	}
+	return value;
+}
+
+static uint32_t float_bits(float f)
+{
+	uint32_t u;
+	memcpy(&u, &f, sizeof(u));
+	return u;
+}
+
+static float bits_float(uint32_t u)
+{
+	float f;
+	memcpy(&f, &u, sizeof(f));
+	return f;
+}
+
+void ts_encoder_init(TsCodec_t *c, uint8_t *buf, uint32_t cap_bytes, uint8_t channels)
+{
+	memset(c, 0, sizeof(*c));
+	c->buf = buf;
+	c->cap_bits = cap_bytes * 8;
+	c->channels = (channels > TS_CODEC_MAX_CHANNELS) ? TS_CODEC_MAX_CHANNELS : channels;
+}
+
+static void encode_timestamp(TsCodec_t *c, uint32_t ts)
+{
+	if (c->count == 0) {
+		put_bits(c, ts, 32);
+		c->prev_ts = ts;
+		return;
+	}
+
+	int32_t delta = (int32_t)(ts - c->prev_ts);
+	int32_t dod = delta - c->prev_delta;
+
+	if (dod == 0) {
+		put_bits(c, 0x0, 1);
+	} else if (dod >= -63 && dod <= 64) {
+		put_bits(c, 0x2, 2);
+		put_bits(c, (uint32_t)(dod + 63), 7);
+	} else if (dod >= -255 && dod <= 256) {
+		put_bits(c, 0x6, 3);
+		put_bits(c, (uint32_t)(dod + 255), 9);
+	} else if (dod >= -2047 && dod <= 2048) {
+		put_bits(c, 0xE, 4);
+		put_bits(c, (uint32_t)(dod + 2047), 12);
+	} else {
+		put_bits(c, 0xF, 4);
+		put_bits(c, (uint32_t)dod, 32);
+	}
+	c->prev_delta = delta;
+	c->prev_ts = ts;
+}
+
+static void encode_value(TsCodec_t *c, uint8_t ch, uint32_t bits)
+{
+	if (c->count == 0) {
+		put_bits(c, bits, 32);
+		c->prev_bits[ch] = bits;
+		return;
+	}
+
+	uint32_t x = bits ^ c->prev_bits[ch];
+	c->prev_bits[ch] = bits;
+	if (x == 0) {
+		put_bits(c, 0x0, 1);
+		return;
+	}
+
+	uint8_t lead = (uint8_t)__builtin_clz(x);
+	uint8_t trail = (uint8_t)__builtin_ctz(x);
+	if (lead > 31) {
+		lead = 31;
+	}
+
+	// Reuse the previous window when the changed bits fit inside it
+	if (c->prev_len[ch] != 0 && lead >= c->prev_lead[ch] &&
+	    trail >= 32 - c->prev_lead[ch] - c->prev_len[ch]) {
+		put_bits(c, 0x2, 2);
+		put_bits(c, x >> (32 - c->prev_lead[ch] - c->prev_len[ch]), c->prev_len[ch]);
+		return;
+	}
+
+	uint8_t len = 32 - lead - trail;
+	put_bits(c, 0x3, 2);
+	put_bits(c, lead, 5);
+	put_bits(c, len - 1, 5);
+	put_bits(c, x >> trail, len);
+	c->prev_lead[ch] = lead;
+	c->prev_len[ch] = len;
+}
+
+bool ts_encoder_add(TsCodec_t *c, uint32_t ts, const float *values)
+{
+	if (c->bit_pos + TS_CODEC_WORST_BITS(c->channels) > c->cap_bits) {
+		return false;
+	}
+
+	encode_timestamp(c, ts);
+	for (uint8_t ch = 0; ch < c->channels; ch++) {
+		encode_value(c, ch, float_bits(values[ch]));
+	}
+	c->count++;
+	return true;
+}
+
+uint32_t ts_encoder_bytes(const TsCodec_t *c)
+{
+	return (c->bit_pos + 7) >> 3;
+}
+
+void ts_decoder_init(TsCodec_t *c, const uint8_t *buf, uint32_t len_bytes, uint8_t channels)
+{
+	ts_encoder_init(c, (uint8_t *)buf, len_bytes, channels);
+}
+
+static bool decode_timestamp(TsCodec_t *c, uint32_t *ts)
+{
+	if (c->count == 0) {
+		c->prev_ts = get_bits(c, 32);
+		*ts = c->prev_ts;
+		return true;
+	}
+
+	int32_t dod;
+	if (get_bits(c, 1) == 0) {
+		dod = 0;
+	} else if (get_bits(c, 1) == 0) {
+		dod = (int32_t)get_bits(c, 7) - 63;
+	} else if (get_bits(c, 1) == 0) {
+		dod = (int32_t)get_bits(c, 9) - 255;
+	} else if (get_bits(c, 1) == 0) {
+		dod = (int32_t)get_bits(c, 12) - 2047;
+	} else {
+		dod = (int32_t)get_bits(c, 32);
+	}
+
+	c->prev_delta += dod;
+	c->prev_ts += (uint32_t)c->prev_delta;
+	*ts = c->prev_ts;
+	return true;
+}
+
+static uint32_t decode_value(TsCodec_t *c, uint8_t ch)
+{
+	if (c->count == 0) {
+		c->prev_bits[ch] = get_bits(c, 32);
+		return c->prev_bits[ch];
+	}
+
+	if (get_bits(c, 1) == 0) {
+		return c->prev_bits[ch];
+	}
+
+	uint32_t x;
+	if (get_bits(c, 1) == 0) {
+		if (c->prev_len[ch] == 0) {   // No window yet: not something the encoder writes
+			decode_fail(c);
+			return 0;
+		}
+		x = get_bits(c, c->prev_len[ch]) << (32 - c->prev_lead[ch] - c->prev_len[ch]);
+	} else {
+		uint8_t lead = (uint8_t)get_bits(c, 5);
+		uint8_t len = (uint8_t)get_bits(c, 5) + 1;
+		if (lead + len > 32) {
+			decode_fail(c);
+			return 0;
+		}
+		x = get_bits(c, len) << (32 - lead - len);
+		c->prev_lead[ch] = lead;
+		c->prev_len[ch] = len;
+	}
+	c->prev_bits[ch] ^= x;
+	return c->prev_bits[ch];
+}
+
+bool ts_decoder_next(TsCodec_t *c, uint32_t *ts, float *values)
+{
+	// The shortest sample is one bit per field
+	if (c->bit_pos + 1 + c->channels > c->cap_bits) {
+		return false;
+	}
+
+	decode_timestamp(c, ts);
+	for (uint8_t ch = 0; ch < c->channels; ch++) {
+		values[ch] = bits_float(decode_value(c, ch));
+	}
+	if (c->bit_pos > c->cap_bits) {
+		return false;            // Truncated or corrupt; outputs are not valid
+	}
+	c->count++;
+	return true;
+}
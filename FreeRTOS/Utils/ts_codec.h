@@ -0,0 +1,47 @@
+/*
+ * ts_codec.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ */
+
+#ifndef TS_CODEC_H_
+#define TS_CODEC_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Gorilla-style streaming compression for (timestamp, float...) samples.
+// Bitstream is MSB-first:
+//   timestamp: first sample 32 raw bits, then delta-of-delta
+//     '0' = 0 | '10'+7b | '110'+9b | '1110'+12b (biased) | '1111'+32b
+//   each value: first sample 32 raw bits, then XOR with the previous value
+//     '0' = same | '10' + bits inside the previous window
+//     | '11' + 5b leading zeros + 5b (length-1) + meaningful bits
+#define TS_CODEC_MAX_CHANNELS   4
+#define TS_CODEC_WORST_BITS(channels)   (36 + 44 * (channels))
+
+typedef struct {
+	uint8_t *buf;
+	uint32_t cap_bits;
+	uint32_t bit_pos;
+	uint16_t count;
+	uint8_t channels;
+	uint32_t prev_ts;
+	int32_t prev_delta;
+	uint32_t prev_bits[TS_CODEC_MAX_CHANNELS];
+	uint8_t prev_lead[TS_CODEC_MAX_CHANNELS];
+	uint8_t prev_len[TS_CODEC_MAX_CHANNELS];   // 0 until a window exists
+} TsCodec_t;
+
+void ts_encoder_init(TsCodec_t *c, uint8_t *buf, uint32_t cap_bytes, uint8_t channels);
+// Refuses (and writes nothing) unless the worst case still fits
+bool ts_encoder_add(TsCodec_t *c, uint32_t ts, const float *values);
+uint32_t ts_encoder_bytes(const TsCodec_t *c);
+
+void ts_decoder_init(TsCodec_t *c, const uint8_t *buf, uint32_t len_bytes, uint8_t channels);
+// False at the end of the buffer, or if the sample would run past it or
+// holds a field the encoder cannot produce; never reads beyond len_bytes
+bool ts_decoder_next(TsCodec_t *c, uint32_t *ts, float *values);
+
+#endif /* TS_CODEC_H_ */
@@ -27,3 +27,11 @@ void log_printf(const char *fmt, ...) {
         osMutexRelease(UartMutexHandle);
     }
 }
+
+// Raw bytes (e.g. binary telemetry frames), serialised with text output
+void uart_logger_write(const uint8_t *data, uint16_t len) {
+    if (osMutexAcquire(UartMutexHandle, osWaitForever) == osOK) {
+        HAL_UART_Transmit(g_uart, (uint8_t*)data, len, HAL_MAX_DELAY);
+        osMutexRelease(UartMutexHandle);
+    }
+}
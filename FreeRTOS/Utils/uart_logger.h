@@ -7,5 +7,6 @@
 
 void uart_logger_init(UART_HandleTypeDef *huart);
 void log_printf(const char *fmt, ...);
+void uart_logger_write(const uint8_t *data, uint16_t len);
 
 #endif
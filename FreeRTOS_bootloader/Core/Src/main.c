@@ -43,6 +43,38 @@ typedef struct {
     uint32_t reserved[2]; // Reserved for future use
 } BootMetadata_t;
 
+// Journal entry in sector 3; same format as the app's boot_metadata.h
+typedef struct {
+    uint32_t marker;      // METADATA_JOURNAL_MARKER, programmed last
+    uint32_t seq;         // +1 per record; not compared, the last valid one by position is current
+    uint32_t version;
+    uint32_t active_slot;
+    uint32_t crc;
+    uint32_t image_size;
+    uint32_t reserved;
+    uint32_t record_crc;  // CRC-32 of the seven words above
+} BootMetadataRecord_t;
+
+// Result of the last full CRC check, kept in backup SRAM across resets
+typedef struct {
+    uint32_t magic;       // VERIFY_CACHE_MAGIC
+    uint32_t slot_addr;
+    uint32_t seq;         // Metadata record the check was made against
+    uint32_t version;
+    uint32_t crc;
+    uint32_t image_size;
+    uint32_t fingerprint; // image_fingerprint() when the check passed
+    uint32_t boots;       // Fast-path boots since the full check
+    uint32_t check;       // CRC-32 of the eight words above
+} VerifyCache_t;
+
+// Tells the app which metadata formats this bootloader reads
+typedef struct {
+    uint32_t magic;       // BOOT_CAPS_MAGIC
+    uint32_t caps;        // BOOT_CAP_* bits
+    uint32_t check;       // ~(magic ^ caps)
+} BootCaps_t;
+
 /* USER CODE END PTD */
 
 /* Private define ------------------------------------------------------------*/
@@ -56,6 +88,37 @@ extern uint32_t _estack;  // Defined in linker script
 #define SLOT_B_ADDR   0x08040000
 #define METADATA_ADDR 0x0800C000
 
+#define METADATA_SECTOR_SIZE    (16U * 1024U)
+#define METADATA_JOURNAL_MARKER 0x4A524E4CU  // "JRNL"
+#define METADATA_RECORD_WORDS   8
+#define METADATA_RECORD_SIZE    (METADATA_RECORD_WORDS * 4)
+#define METADATA_RECORDS        (METADATA_SECTOR_SIZE / METADATA_RECORD_SIZE)
+#define METADATA_BRIDGE_ADDR    0x08070000   // Copy kept while the app wraps sector 3
+#define METADATA_BRIDGE_RECORDS ((64U * 1024U) / METADATA_RECORD_SIZE)
+
+// An image that passed a full CRC check boots without one until the
+// metadata record changes, VERIFY_EVERY_N_BOOTS resets have gone by (0
+// checks on every boot), or the reset was a power-on, brown-out, watchdog
+// or low-power reset. Backup SRAM does not survive power loss without
+// VBAT, so a cold boot always runs the full check. Pin and software
+// resets are trusted, so the cache also holds a fingerprint of the
+// vector table and the image's last word: an image reflashed over SWD
+// without a metadata change then fails it and gets the full check.
+#define VERIFY_CACHE_ADDR       BKPSRAM_BASE
+#define BOOT_CAPS_ADDR          (BKPSRAM_BASE + 0x40)  // Read and cleared by the app
+#define BOOT_CAPS_MAGIC         0x424C4452U  // "BLDR"
+#define BOOT_CAP_JOURNAL        (1U << 0)
+#define VERIFY_CACHE_MAGIC      0x56455249U  // "VERI"
+#define VERIFY_CACHE_WORDS      9
+#define VERIFY_FINGERPRINT_WORDS 16  // Stack pointer, reset and fault vectors
+#define VERIFY_EVERY_N_BOOTS    32
+#define VERIFY_RESET_FLAGS      (RCC_CSR_BORRSTF | RCC_CSR_PORRSTF | RCC_CSR_IWDGRSTF | \
+                                 RCC_CSR_WWDGRSTF | RCC_CSR_LPWRRSTF)
+
+// Image checks on the CRC unit (a few ms for 192KB) instead of the
+// bit-serial loop; both give the zlib CRC-32 that ota_update.py computes
+#define USE_HW_CRC    1
+
 // STM32F446RE RAM range: 0x20000000 - 0x2001FFFF (128KB)
 #define RAM_START     0x20000000
 #define RAM_END       0x20020000
@@ -67,6 +130,11 @@ UART_HandleTypeDef huart2;
 /* USER CODE BEGIN PV */
 extern int _bflag;
 
+// Journal position found by load_metadata()
+static uint32_t metadata_seq = 0;
+static uint32_t metadata_next_record = 0;
+static uint8_t metadata_from_bridge = 0;
+
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
@@ -76,11 +144,19 @@ static void MX_USART2_UART_Init(void);
 /* USER CODE BEGIN PFP */
 void jump_to_application(uint32_t app_address);
 uint32_t calculate_crc32(uint32_t *data, uint32_t length_words);
+uint32_t calculate_crc32_hw(uint32_t *data, uint32_t length_words);
 uint32_t calculate_flash_crc(uint32_t start_addr, uint32_t size_bytes);
 uint8_t validate_crc(uint32_t app_addr, uint32_t expected_crc, uint32_t image_size);
 uint8_t is_valid_application(uint32_t app_addr);
 HAL_StatusTypeDef initialize_first_boot_metadata();
 void check_and_clear_flash_protection();
+const BootMetadataRecord_t *journal_newest(uint32_t base, uint32_t count, uint32_t *used);
+uint8_t load_metadata(BootMetadata_t *metadata);
+HAL_StatusTypeDef append_metadata_record(const BootMetadata_t *metadata);
+uint32_t image_fingerprint(uint32_t app_addr, const BootMetadata_t *metadata);
+uint8_t verify_cache_hit(uint32_t app_addr, const BootMetadata_t *metadata, uint32_t reset_flags);
+void verify_cache_store(uint32_t app_addr, const BootMetadata_t *metadata);
+void verify_cache_clear(void);
 
 /* USER CODE END PFP */
 
@@ -128,19 +204,35 @@ int main(void)
   /* USER CODE BEGIN 2 */
   log("Bootloader started...\r\n");
   
+  // Reset cause decides whether a cached image check can be trusted
+  uint32_t reset_flags = RCC->CSR;
+  __HAL_RCC_CLEAR_RESET_FLAGS();
+  
+  // Backup SRAM holds the verification cache and the capability word
+  __HAL_RCC_PWR_CLK_ENABLE();
+  HAL_PWR_EnableBkUpAccess();
+  __HAL_RCC_BKPSRAM_CLK_ENABLE();
+  
+  // Until the app sees this it keeps writing the single base record that
+  // older bootloaders read, instead of the journal
+  BootCaps_t *caps = (BootCaps_t *)BOOT_CAPS_ADDR;
+  caps->magic = BOOT_CAPS_MAGIC;
+  caps->caps = BOOT_CAP_JOURNAL;
+  caps->check = ~(caps->magic ^ caps->caps);
+  
   // Check and clear any flash protection that might interfere with programming
   check_and_clear_flash_protection();
 
-  // Read metadata from flash (not from const section)
-  BootMetadata_t *metadata = (BootMetadata_t *)METADATA_ADDR;
+  // Newest valid record of the metadata journal, copied to RAM
+  BootMetadata_t metadata_copy;
+  BootMetadata_t *metadata = &metadata_copy;
   
   char debug_buf[150];
-  sprintf(debug_buf, "Reading metadata from 0x%08X\r\n", (unsigned int)METADATA_ADDR);
+  sprintf(debug_buf, "Reading metadata journal at 0x%08X\r\n", (unsigned int)METADATA_ADDR);
   log(debug_buf);
 
-  if (metadata->is_valid != 0xA5A5A5A5) {
-	  sprintf(debug_buf, "Metadata invalid! Read value: 0x%08X (expected: 0xA5A5A5A5)\r\n", 
-	          (unsigned int)metadata->is_valid);
+  if (!load_metadata(metadata)) {
+	  sprintf(debug_buf, "No valid metadata record! (%lu records used)\r\n", metadata_next_record);
 	  log(debug_buf);
 	  
 	  // First boot - initialize metadata by scanning for valid applications
@@ -151,18 +243,26 @@ int main(void)
 	  }
 	  
 	  // Re-read metadata after initialization
-	  metadata = (BootMetadata_t *)METADATA_ADDR;
-	  if (metadata->is_valid != 0xA5A5A5A5) {
+	  if (!load_metadata(metadata)) {
 		  log("Metadata still invalid after initialization! Defaulting to Slot A\r\n");
 		  jump_to_application(SLOT_A_ADDR);
 	  }
 	  
 	  log("Metadata initialized successfully, continuing with normal boot...\r\n");
+  } else if (metadata_from_bridge) {
+	  // The bridge is erased with slot B, so put the record back in sector 3
+	  log("Metadata recovered from bridge, restoring journal\r\n");
+	  if (HAL_FLASH_Unlock() == HAL_OK) {
+		  if (append_metadata_record(metadata) != HAL_OK) {
+			  log("Journal restore failed\r\n");
+		  }
+		  HAL_FLASH_Lock();
+	  }
   }
 
   char log_buf[100];
-  sprintf(log_buf, "Metadata: ver=0x%08X, slot=%lu, crc=0x%08X, size=%lu\r\n", 
-          (unsigned int)metadata->version, metadata->active_slot, 
+  sprintf(log_buf, "Metadata: seq=%lu, ver=0x%08X, slot=%lu, crc=0x%08X, size=%lu\r\n", 
+          metadata_seq, (unsigned int)metadata->version, metadata->active_slot, 
           (unsigned int)metadata->crc, metadata->image_size);
   log(log_buf);
   
@@ -172,9 +272,14 @@ int main(void)
           (unsigned int)target_address);
   log(log_buf);
 
-  // CRC validation of target slot
-  if (!validate_crc(target_address, metadata->crc, metadata->image_size)) {
+  // CRC validation of target slot, skipped if it already passed for this record
+  if (verify_cache_hit(target_address, metadata, reset_flags)) {
+	  log("CRC validation: cached PASS\r\n");
+  } else if (validate_crc(target_address, metadata->crc, metadata->image_size)) {
+	  verify_cache_store(target_address, metadata);
+  } else {
 	  log("CRC validation failed! Falling back to Slot A\r\n");
+	  verify_cache_clear();
 	  target_address = SLOT_A_ADDR;
 	  
 	  // Also validate Slot A as fallback (skip CRC if different from target)
@@ -412,6 +517,20 @@ uint32_t calculate_crc32(uint32_t *data, uint32_t length_words)
     return ~crc;
 }
 
+uint32_t calculate_crc32_hw(uint32_t *data, uint32_t length_words)
+{
+    // The unit is MSB-first CRC-32 with no reflection options: feeding each
+    // word bit-reversed and reversing and inverting the result gives zlib's
+    __HAL_RCC_CRC_CLK_ENABLE();
+    CRC->CR = CRC_CR_RESET;
+    
+    for (uint32_t i = 0; i < length_words; i++) {
+        CRC->DR = __RBIT(data[i]);
+    }
+    
+    return ~__RBIT(CRC->DR);
+}
+
 uint32_t calculate_flash_crc(uint32_t start_addr, uint32_t size_bytes)
 {
     // Ensure size is word-aligned
@@ -423,7 +542,11 @@ uint32_t calculate_flash_crc(uint32_t start_addr, uint32_t size_bytes)
             (unsigned int)start_addr, size_bytes, size_words);
     log(log_buf);
     
+#if USE_HW_CRC
+    return calculate_crc32_hw(flash_ptr, size_words);
+#else
     return calculate_crc32(flash_ptr, size_words);
+#endif
 }
 
 uint8_t is_valid_application(uint32_t app_addr)
@@ -502,44 +625,203 @@ HAL_StatusTypeDef initialize_first_boot_metadata()
         return status;
     }
     
-    // Erase metadata sector
-    FLASH_EraseInitTypeDef eraseInit = {
-        .TypeErase = FLASH_TYPEERASE_SECTORS,
-        .VoltageRange = FLASH_VOLTAGE_RANGE_3,
-        .Sector = FLASH_SECTOR_3,
-        .NbSectors = 1
-    };
-    
-    uint32_t sectorError;
-    status = HAL_FLASHEx_Erase(&eraseInit, &sectorError);
+    // Append to the journal; erases the sector only if it is full
+    status = append_metadata_record(&new_metadata);
     if (status != HAL_OK) {
-        sprintf(log_buf, "Metadata sector erase failed: %d\r\n", status);
+        sprintf(log_buf, "Metadata write failed: %d\r\n", status);
         log(log_buf);
         HAL_FLASH_Lock();
         return status;
     }
     
-    // Write metadata word by word
-    uint32_t *metadata_ptr = (uint32_t *)&new_metadata;
-    uint32_t metadata_words = sizeof(BootMetadata_t) / 4;
+    HAL_FLASH_Lock();
+    log("First boot metadata initialized successfully\r\n");
+    return HAL_OK;
+}
+
+const BootMetadataRecord_t *journal_newest(uint32_t base, uint32_t count, uint32_t *used)
+{
+    // Records are appended in order, so the used ones end at the last non-blank
+    *used = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        const uint32_t *words = (const uint32_t *)(base + i * METADATA_RECORD_SIZE);
+        for (int w = 0; w < METADATA_RECORD_WORDS; w++) {
+            if (words[w] != 0xFFFFFFFF) {
+                *used = i + 1;
+                break;
+            }
+        }
+    }
+    
+    // Newest first: the last record that passes its CRC is current, and
+    // torn or corrupt ones after it are skipped but still take up their place
+    for (uint32_t i = *used; i > 0; i--) {
+        const BootMetadataRecord_t *rec = 
+            (const BootMetadataRecord_t *)(base + (i - 1) * METADATA_RECORD_SIZE);
+        if (rec->marker == METADATA_JOURNAL_MARKER &&
+            rec->record_crc == calculate_crc32((uint32_t *)rec, METADATA_RECORD_WORDS - 1)) {
+            return rec;
+        }
+    }
+    return NULL;
+}
+
+uint8_t load_metadata(BootMetadata_t *metadata)
+{
+    const BootMetadataRecord_t *newest = journal_newest(METADATA_ADDR, METADATA_RECORDS, &metadata_next_record);
+    uint32_t bridge_used;
+    
+    metadata_from_bridge = 0;
+    if (newest == NULL && *(uint32_t *)METADATA_ADDR != 0xA5A5A5A5) {
+        // Power was lost while the app wrapped the journal: the record that
+        // was current is in the bridge
+        newest = journal_newest(METADATA_BRIDGE_ADDR, METADATA_BRIDGE_RECORDS, &bridge_used);
+        metadata_from_bridge = (newest != NULL);
+    }
     
-    for (uint32_t i = 0; i < metadata_words; i++) {
-        status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, 
-                                   METADATA_ADDR + (i * 4), 
-                                   metadata_ptr[i]);
+    if (newest != NULL) {
+        metadata->is_valid = 0xA5A5A5A5;
+        metadata->version = newest->version;
+        metadata->active_slot = newest->active_slot;
+        metadata->crc = newest->crc;
+        metadata->image_size = newest->image_size;
+        metadata->reserved[0] = 0;
+        metadata->reserved[1] = 0;
+        metadata_seq = newest->seq;
+        return 1;
+    }
+    
+    // No journal yet: accept the single record older images wrote at the base
+    *metadata = *(BootMetadata_t *)METADATA_ADDR;
+    metadata_seq = 0;
+    return metadata->is_valid == 0xA5A5A5A5;
+}
+
+// The bootloader only appends when sector 3 has no valid record, so unlike
+// the app it has nothing to copy to the bridge before a wrap erase
+HAL_StatusTypeDef append_metadata_record(const BootMetadata_t *metadata)
+{
+    BootMetadataRecord_t rec;
+    rec.marker = METADATA_JOURNAL_MARKER;
+    rec.seq = metadata_seq + 1;
+    rec.version = metadata->version;
+    rec.active_slot = metadata->active_slot;
+    rec.crc = metadata->crc;
+    rec.image_size = metadata->image_size;
+    rec.reserved = 0;
+    rec.record_crc = calculate_crc32((uint32_t *)&rec, METADATA_RECORD_WORDS - 1);
+    
+    HAL_StatusTypeDef status;
+    if (metadata_next_record >= METADATA_RECORDS) {
+        FLASH_EraseInitTypeDef eraseInit = {
+            .TypeErase = FLASH_TYPEERASE_SECTORS,
+            .VoltageRange = FLASH_VOLTAGE_RANGE_3,
+            .Sector = FLASH_SECTOR_3,
+            .NbSectors = 1
+        };
+        uint32_t sectorError;
+        status = HAL_FLASHEx_Erase(&eraseInit, &sectorError);
         if (status != HAL_OK) {
-            sprintf(log_buf, "Metadata write failed at word %lu\r\n", i);
-            log(log_buf);
-            HAL_FLASH_Lock();
             return status;
         }
+        metadata_next_record = 0;
     }
     
-    HAL_FLASH_Lock();
-    log("First boot metadata initialized successfully\r\n");
+    // Body first, marker last, so a torn write never becomes current
+    uint32_t addr = METADATA_ADDR + metadata_next_record * METADATA_RECORD_SIZE;
+    uint32_t *words = (uint32_t *)&rec;
+    for (uint32_t i = 1; i <= METADATA_RECORD_WORDS; i++) {
+        uint32_t w = i % METADATA_RECORD_WORDS;
+        status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, addr + w * 4, words[w]);
+        if (status != HAL_OK) {
+            metadata_next_record++;
+            return status;
+        }
+    }
+    
+    metadata_next_record++;
+    metadata_seq = rec.seq;
     return HAL_OK;
 }
 
+uint32_t image_fingerprint(uint32_t app_addr, const BootMetadata_t *metadata)
+{
+    uint32_t words[VERIFY_FINGERPRINT_WORDS + 1];
+    uint32_t size = (metadata->image_size > 0 && metadata->image_size <= (192 * 1024)) ? 
+                    metadata->image_size : (192 * 1024);
+    
+    for (int i = 0; i < VERIFY_FINGERPRINT_WORDS; i++) {
+        words[i] = ((uint32_t *)app_addr)[i];
+    }
+    words[VERIFY_FINGERPRINT_WORDS] = *(uint32_t *)(app_addr + ((size - 1) & ~3U));
+    return calculate_crc32(words, VERIFY_FINGERPRINT_WORDS + 1);
+}
+
+uint8_t verify_cache_hit(uint32_t app_addr, const BootMetadata_t *metadata, uint32_t reset_flags)
+{
+    VerifyCache_t *cache = (VerifyCache_t *)VERIFY_CACHE_ADDR;
+    char log_buf[100];
+    
+    if (metadata->crc == 0xFFFFFFFF) {
+        return 0; // Nothing to check, validate_crc() returns at once
+    }
+    if (cache->magic != VERIFY_CACHE_MAGIC ||
+        cache->check != calculate_crc32((uint32_t *)cache, VERIFY_CACHE_WORDS - 1)) {
+        log("Verify cache: empty\r\n");
+        return 0;
+    }
+    if (cache->slot_addr != app_addr || cache->seq != metadata_seq ||
+        cache->version != metadata->version || cache->crc != metadata->crc ||
+        cache->image_size != metadata->image_size) {
+        log("Verify cache: metadata changed\r\n");
+        return 0;
+    }
+    if (cache->fingerprint != image_fingerprint(app_addr, metadata)) {
+        log("Verify cache: image changed\r\n");
+        return 0;
+    }
+    if (reset_flags & VERIFY_RESET_FLAGS) {
+        sprintf(log_buf, "Verify cache: ignored after reset cause 0x%08X\r\n", 
+                (unsigned int)(reset_flags & VERIFY_RESET_FLAGS));
+        log(log_buf);
+        return 0;
+    }
+    if (cache->boots >= VERIFY_EVERY_N_BOOTS) {
+        log("Verify cache: scheduled full check\r\n");
+        return 0;
+    }
+    
+    cache->boots++;
+    cache->check = calculate_crc32((uint32_t *)cache, VERIFY_CACHE_WORDS - 1);
+    sprintf(log_buf, "Verify cache: hit (%lu/%u boots since full check)\r\n", 
+            cache->boots, VERIFY_EVERY_N_BOOTS);
+    log(log_buf);
+    return 1;
+}
+
+void verify_cache_store(uint32_t app_addr, const BootMetadata_t *metadata)
+{
+    VerifyCache_t *cache = (VerifyCache_t *)VERIFY_CACHE_ADDR;
+    
+    if (metadata->crc == 0xFFFFFFFF) {
+        return;
+    }
+    cache->slot_addr = app_addr;
+    cache->seq = metadata_seq;
+    cache->version = metadata->version;
+    cache->crc = metadata->crc;
+    cache->image_size = metadata->image_size;
+    cache->fingerprint = image_fingerprint(app_addr, metadata);
+    cache->boots = 0;
+    cache->magic = VERIFY_CACHE_MAGIC;
+    cache->check = calculate_crc32((uint32_t *)cache, VERIFY_CACHE_WORDS - 1);
+}
+
+void verify_cache_clear(void)
+{
+    ((VerifyCache_t *)VERIFY_CACHE_ADDR)->magic = 0;
+}
+
 void check_and_clear_flash_protection()
 {
     // Check current RDP level
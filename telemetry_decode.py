@@ -0,0 +1,365 @@
+#!/usr/bin/env python3
+"""
+STM32 Sensor Telemetry Decoder
+
+Decodes the binary telemetry frames sent by the 'stream' command. Frames are
+interleaved with normal text output on the same UART; text is passed through
+and frames are recognised by their sync bytes, length and CRC-16.
+
+Frame payloads are fixed-point samples (raw), Gorilla-compressed samples,
+Gorilla-compressed history buckets from 'histdump', alarm transitions, or
+stored flash log blocks from 'flashlog dump'.
+
+Usage:
+    python telemetry_decode.py [options]
+
+Examples:
+    python telemetry_decode.py --port COM3 --start --batch 32
+    python telemetry_decode.py --port /dev/ttyUSB0 --csv samples.csv --duration 60
+    python telemetry_decode.py --file capture.bin
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+SYNC = b'\xA5\x5A'
+HEADER_SIZE = 12
+CRC_SIZE = 2
+FRAME_RAW = 0x01
+FRAME_GORILLA = 0x02
+FRAME_HISTORY = 0x03
+FRAME_ALARM = 0x04
+FRAME_FLASHLOG = 0x05
+ALARM_TYPES = ('high', 'low', 'rate', 'stuck')
+SENSOR_NAMES = ('temp', 'pressure')
+MAX_PAYLOAD = 512
+RAW_SAMPLE_BYTES = 12       # sizeof(SensorMessage_t), the uncompressed baseline
+
+
+def crc16_ccitt(data):
+    """CRC-16/CCITT-FALSE, as computed by the device"""
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def read_varint(buf, pos):
+    """Decode an unsigned LEB128 value, returning (value, new_pos)"""
+    value = 0
+    shift = 0
+    while True:
+        byte = buf[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        if not byte & 0x80:
+            return value, pos
+        shift += 7
+
+
+def decode_raw_payload(payload, count, t0):
+    """TELEMETRY_FRAME_RAW: varint dt_us, int16 temp x100, int16 pressure x100"""
+    samples = []
+    pos = 0
+    offset_us = 0
+    for _ in range(count):
+        dt, pos = read_varint(payload, pos)
+        temp, press = struct.unpack_from('<hh', payload, pos)
+        pos += 4
+        offset_us += dt
+        samples.append((t0 + offset_us / 1000.0, temp / 100.0, press / 100.0))
+    return samples
+
+
+class BitReader:
+    """MSB-first bit reader matching the device's ts_codec"""
+
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def read(self, nbits):
+        value = 0
+        for _ in range(nbits):
+            byte = self.data[self.pos >> 3]
+            value = (value << 1) | ((byte >> (7 - (self.pos & 7))) & 1)
+            self.pos += 1
+        return value
+
+
+def signed32(value):
+    return value - (1 << 32) if value & 0x80000000 else value
+
+
+def gorilla_decode(payload, count, channels):
+    """Decode a ts_codec stream into (timestamp, [values...]) tuples"""
+    reader = BitReader(payload)
+    samples = []
+    prev_ts = 0
+    prev_delta = 0
+    prev_bits = [0] * channels
+    prev_lead = [0] * channels
+    prev_len = [0] * channels
+
+    for index in range(count):
+        if index == 0:
+            prev_ts = reader.read(32)
+        else:
+            if reader.read(1) == 0:
+                dod = 0
+            elif reader.read(1) == 0:
+                dod = reader.read(7) - 63
+            elif reader.read(1) == 0:
+                dod = reader.read(9) - 255
+            elif reader.read(1) == 0:
+                dod = reader.read(12) - 2047
+            else:
+                dod = signed32(reader.read(32))
+            prev_delta += dod
+            prev_ts = (prev_ts + prev_delta) & 0xFFFFFFFF
+
+        values = []
+        for ch in range(channels):
+            if index == 0:
+                prev_bits[ch] = reader.read(32)
+            elif reader.read(1) == 1:
+                if reader.read(1) == 0:
+                    shift = 32 - prev_lead[ch] - prev_len[ch]
+                    xor = reader.read(prev_len[ch]) << shift
+                else:
+                    prev_lead[ch] = reader.read(5)
+                    prev_len[ch] = reader.read(5) + 1
+                    xor = reader.read(prev_len[ch]) << (32 - prev_lead[ch] - prev_len[ch])
+                prev_bits[ch] ^= xor
+            values.append(struct.unpack('<f', struct.pack('<I', prev_bits[ch]))[0])
+        samples.append((prev_ts, values))
+    return samples
+
+
+def decode_gorilla_payload(payload, count, t0):
+    """TELEMETRY_FRAME_GORILLA: (us after t0_ms, temp, pressure)"""
+    return [(t0 + ts / 1000.0, v[0], v[1]) for ts, v in gorilla_decode(payload, count, 2)]
+
+
+def decode_history_payload(payload, count, t0):
+    """TELEMETRY_FRAME_HISTORY: (bucket start, min, max, mean)"""
+    return [(ts, v[0], v[1], v[2]) for ts, v in gorilla_decode(payload, count, 3)]
+
+
+def decode_flashlog_payload(payload, count, t0):
+    """TELEMETRY_FRAME_FLASHLOG: (log time s, temp, pressure)"""
+    return [(ts, v[0], v[1]) for ts, v in gorilla_decode(payload, count, 2)]
+
+
+def decode_alarm_payload(payload, count, t0):
+    """TELEMETRY_FRAME_ALARM: (time_ms, rule, type, sensor, raised, value)"""
+    rule, kind, channel, active, value = struct.unpack_from('<BBBBf', payload)
+    kind = ALARM_TYPES[kind] if kind < len(ALARM_TYPES) else str(kind)
+    channel = SENSOR_NAMES[channel] if channel < len(SENSOR_NAMES) else str(channel)
+    return [(t0, rule, kind, channel, bool(active), value)]
+
+
+class TelemetryDecoder:
+    """Incremental frame parser with loss accounting"""
+
+    def __init__(self):
+        self.buffer = bytearray()
+        self.expected_seq = {}
+        self.frames = 0
+        self.samples = 0
+        self.payload_bytes = 0
+        self.history = []
+        self.alarms = []
+        self.flashlog = []
+        self.lost_frames = 0
+        self.crc_errors = 0
+        self.text = bytearray()
+        self.payload_decoders = {
+            FRAME_RAW: decode_raw_payload,
+            FRAME_GORILLA: decode_gorilla_payload,
+            FRAME_HISTORY: decode_history_payload,
+            FRAME_ALARM: decode_alarm_payload,
+            FRAME_FLASHLOG: decode_flashlog_payload,
+        }
+
+    def feed(self, data):
+        """Consume bytes, returning a list of decoded samples"""
+        self.buffer.extend(data)
+        samples = []
+
+        while True:
+            start = self.buffer.find(SYNC)
+            if start < 0:
+                # Keep a possible leading sync byte for the next read
+                keep = 1 if self.buffer.endswith(SYNC[:1]) else 0
+                self.text.extend(self.buffer[:len(self.buffer) - keep])
+                del self.buffer[:len(self.buffer) - keep]
+                break
+
+            self.text.extend(self.buffer[:start])
+            del self.buffer[:start]
+            if len(self.buffer) < HEADER_SIZE:
+                break
+
+            frame_type, count, seq, length, t0 = struct.unpack_from('<BBHHI', self.buffer, 2)
+            if frame_type not in self.payload_decoders or length > MAX_PAYLOAD:
+                # Sync bytes inside text or payload; skip one byte and rescan
+                self.text.extend(self.buffer[:1])
+                del self.buffer[:1]
+                continue
+
+            total = HEADER_SIZE + length + CRC_SIZE
+            if len(self.buffer) < total:
+                break
+
+            frame = bytes(self.buffer[:total])
+            (crc,) = struct.unpack_from('<H', frame, HEADER_SIZE + length)
+            if crc16_ccitt(frame[2:HEADER_SIZE + length]) != crc:
+                self.crc_errors += 1
+                self.text.extend(self.buffer[:1])
+                del self.buffer[:1]
+                continue
+
+            del self.buffer[:total]
+            # Raw and Gorilla frames share the stream sequence; history and
+            # flash log dumps and alarms count separately, and dumps restart at 0
+            stream = {FRAME_HISTORY: 'history', FRAME_ALARM: 'alarm',
+                      FRAME_FLASHLOG: 'flashlog'}.get(frame_type, 'samples')
+            expected = self.expected_seq.get(stream)
+            restart = frame_type in (FRAME_HISTORY, FRAME_FLASHLOG) and seq == 0
+            if expected is not None and seq != expected and not restart:
+                self.lost_frames += (seq - expected) & 0xFFFF
+            self.expected_seq[stream] = (seq + 1) & 0xFFFF
+
+            payload = frame[HEADER_SIZE:HEADER_SIZE + length]
+            decoded = self.payload_decoders[frame_type](payload, count, t0)
+            self.frames += 1
+            if frame_type == FRAME_HISTORY:
+                self.history.extend(decoded)
+                continue
+            if frame_type == FRAME_ALARM:
+                self.alarms.extend(decoded)
+                continue
+            if frame_type == FRAME_FLASHLOG:
+                self.flashlog.extend(decoded)
+                continue
+            self.samples += len(decoded)
+            self.payload_bytes += total
+            samples.extend(decoded)
+
+        return samples
+
+    def take_text(self):
+        """Return and clear any non-frame bytes seen so far"""
+        text = self.text.decode('utf-8', errors='replace')
+        self.text.clear()
+        return text
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="STM32 Sensor Telemetry Decoder",
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+        epilog="""
+Examples:
+  python telemetry_decode.py --port COM3 --start --batch 32
+  python telemetry_decode.py --port /dev/ttyUSB0 --csv samples.csv --duration 60
+  python telemetry_decode.py --file capture.bin
+        """
+    )
+
+    parser.add_argument('--port', default='COM3',
+                       help='Serial port (default: COM3)')
+    parser.add_argument('--baudrate', type=int, default=115200,
+                       help='Baud rate (default: 115200)')
+    parser.add_argument('--file',
+                       help='Decode a raw capture file instead of a serial port')
+    parser.add_argument('--csv',
+                       help='Write decoded samples to this CSV file')
+    parser.add_argument('--duration', type=float, default=0,
+                       help='Stop after this many seconds (default: run until Ctrl+C)')
+    parser.add_argument('--start', action='store_true',
+                       help="Send 'stream on' before reading and 'stream off' on exit")
+    parser.add_argument('--batch', type=int, default=16,
+                       help='Samples per frame when --start is used (default: 16)')
+    parser.add_argument('--every', type=int, default=1,
+                       help='Send every Nth sample when --start is used (default: 1)')
+    parser.add_argument('--codec', choices=['raw', 'gorilla'], default='gorilla',
+                       help='Frame encoding when --start is used (default: gorilla)')
+    parser.add_argument('--quiet', action='store_true',
+                       help='Do not print samples or device text')
+
+    args = parser.parse_args()
+
+    decoder = TelemetryDecoder()
+    csv_file = open(args.csv, 'w') if args.csv else None
+    if csv_file:
+        csv_file.write('timestamp_ms,temperature,pressure\n')
+
+    def handle(samples):
+        for ts, temp, press in samples:
+            if csv_file:
+                csv_file.write(f'{ts:.3f},{temp:.2f},{press:.2f}\n')
+            if not args.quiet:
+                print(f'{ts:>14.3f} ms  T={temp:7.2f}  P={press:7.2f}')
+        for start, low, high, mean in decoder.history:
+            if not args.quiet:
+                print(f'{start:>10}  min={low:7.2f}  max={high:7.2f}  mean={mean:7.2f}')
+        decoder.history.clear()
+        for ts, temp, press in decoder.flashlog:
+            if not args.quiet:
+                print(f'{ts:>10} s   T={temp:7.2f}  P={press:7.2f}  (flash log)')
+        decoder.flashlog.clear()
+        for ts, rule, kind, channel, raised, value in decoder.alarms:
+            if not args.quiet:
+                state = 'RAISED' if raised else 'cleared'
+                print(f'{ts:>10} ms  ALARM rule {rule} {channel} {kind} {state} ({value:.2f})')
+        decoder.alarms.clear()
+        text = decoder.take_text()
+        if text and not args.quiet:
+            sys.stdout.write(text)
+
+    started = time.time()
+    try:
+        if args.file:
+            with open(args.file, 'rb') as f:
+                handle(decoder.feed(f.read()))
+        else:
+            import serial
+            conn = serial.Serial(port=args.port, baudrate=args.baudrate, timeout=0.1)
+            print(f"✓ Connected to {args.port} at {args.baudrate} baud")
+            if args.start:
+                conn.write(f'stream on {args.batch} {args.every} {args.codec}\r\n'.encode())
+            try:
+                while not args.duration or time.time() - started < args.duration:
+                    data = conn.read(max(1, conn.in_waiting))
+                    if data:
+                        handle(decoder.feed(data))
+            except KeyboardInterrupt:
+                pass
+            finally:
+                if args.start:
+                    conn.write(b'stream off\r\n')
+                conn.close()
+    finally:
+        if csv_file:
+            csv_file.close()
+
+    elapsed = max(time.time() - started, 1e-6)
+    print(f"\n📊 Frames: {decoder.frames}, samples: {decoder.samples}, "
+          f"lost frames: {decoder.lost_frames}, CRC errors: {decoder.crc_errors}")
+    if decoder.samples:
+        bytes_per_sample = decoder.payload_bytes / decoder.samples
+        print(f"🗜 {bytes_per_sample:.2f} bytes/sample on the wire, "
+              f"{RAW_SAMPLE_BYTES / bytes_per_sample:.1f}x smaller than raw {RAW_SAMPLE_BYTES}-byte samples")
+    if not args.file:
+        print(f"📈 Throughput: {decoder.samples / elapsed:.1f} samples/s")
+
+
+if __name__ == "__main__":
+    main()
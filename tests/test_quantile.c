@@ -0,0 +1,146 @@
+/*
+ * test_quantile.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Halak Vyas
+ *
+ * Host check of the P-square sketch against exact order statistics, the
+ * figures quoted in quantile.h. Build and run from the repository root:
+ *
+ *   cc -O2 -std=c11 -IFreeRTOS/Utils tests/test_quantile.c FreeRTOS/Utils/quantile_sketch.c -lm -o test_quantile && ./test_quantile
+ *
+ * Exits non-zero if any bound fails.
+ */
+#include "quantile.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define SAMPLES     100000U
+#define PI          3.14159265358979f
+
+static uint32_t seed = 0x5EED1234U;
+static float data[SAMPLES];
+static int failures = 0;
+
+// xorshift32, so every run sees the same streams. Generators take the
+// sample index; the random ones ignore it.
+static float uniform01(void)
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	return ((float)(seed >> 8) + 0.5f) * (1.0f / 16777216.0f);
+}
+
+static float gen_uniform(uint32_t i)
+{
+	return uniform01() * 100.0f;
+}
+
+static float gen_normal(uint32_t i)
+{
+	// Box-Muller
+	float u1 = uniform01();
+	float u2 = uniform01();
+	return 50.0f + 10.0f * sqrtf(-2.0f * logf(u1)) * cosf(2.0f * PI * u2);
+}
+
+static float gen_exponential(uint32_t i)
+{
+	return -10.0f * logf(uniform01());
+}
+
+static float gen_sine(uint32_t i)
+{
+	return 25.0f + 5.0f * sinf(2.0f * PI * (float)i / 20000.0f);
+}
+
+static float gen_ramp(uint32_t i)
+{
+	return (float)(i % 1000U) * 0.1f;
+}
+
+static float gen_bimodal(uint32_t i)
+{
+	float centre = (uniform01() < 0.5f) ? 20.0f : 80.0f;
+	return centre + (uniform01() - 0.5f) * 4.0f;
+}
+
+static int cmp_float(const void *a, const void *b)
+{
+	float x = *(const float *)a;
+	float y = *(const float *)b;
+	return (x > y) - (x < y);
+}
+
+// Nearest rank, as quantile_sketch_get() uses below five samples
+static float exact(const float *sorted, uint32_t count, QuantileId_t q)
+{
+	return sorted[(uint32_t)(quantile_fraction(q) * (float)(count - 1) + 0.5f)];
+}
+
+static void check(const char *name, QuantileId_t q, float got, float want, float range, float bound)
+{
+	float error = fabsf(got - want) / ((range > 0.0f) ? range : 1.0f);
+	int ok = error <= bound;
+
+	printf("  %-12s P%-2d sketch %9.3f exact %9.3f error %6.3f%% (bound %.2f%%) %s\n", name,
+	       (int)(quantile_fraction(q) * 100.0f + 0.5f), got, want, error * 100.0f, bound * 100.0f,
+	       ok ? "ok" : "FAIL");
+	if (!ok) {
+		failures++;
+	}
+}
+
+// Feeds 'count' samples and compares every quantile against the sorted stream
+static void run(const char *name, float (*gen)(uint32_t), uint32_t count, const float bounds[QUANTILE_COUNT])
+{
+	QuantileSketch_t sketch;
+	quantile_sketch_reset(&sketch);
+
+	for (uint32_t i = 0; i < count; i++) {
+		data[i] = gen(i);
+		quantile_sketch_add(&sketch, data[i]);
+	}
+	qsort(data, count, sizeof(float), cmp_float);
+
+	float range = data[count - 1] - data[0];
+	for (uint32_t q = 0; q < QUANTILE_COUNT; q++) {
+		if (bounds[q] < 0.0f) {
+			continue;
+		}
+		check(name, (QuantileId_t)q, quantile_sketch_get(&sketch, (QuantileId_t)q),
+		      exact(data, count, (QuantileId_t)q), range, bounds[q]);
+	}
+}
+
+int main(void)
+{
+	const float all[QUANTILE_COUNT] = { 0.002f, 0.002f, 0.002f };
+	// A ramp's flat density leaves the median marker a step behind
+	const float ramp[QUANTILE_COUNT] = { 0.003f, 0.002f, 0.002f };
+	// P50 of two equal modes falls in the gap between them; not checked
+	const float tails[QUANTILE_COUNT] = { -1.0f, 0.001f, 0.001f };
+	const float exact_few[QUANTILE_COUNT] = { 0.0f, 0.0f, 0.0f };
+
+	printf("%u samples:\n", SAMPLES);
+	run("uniform", gen_uniform, SAMPLES, all);
+	run("normal", gen_normal, SAMPLES, all);
+	run("exponential", gen_exponential, SAMPLES, all);
+	run("slow sine", gen_sine, SAMPLES, all);
+	run("ramp", gen_ramp, SAMPLES, ramp);
+	run("bimodal", gen_bimodal, SAMPLES, tails);
+
+	printf("Short exponential streams:\n");
+	run("exp 400", gen_exponential, 400, (const float[QUANTILE_COUNT]){ -1.0f, 0.05f, -1.0f });
+	run("exp 4000", gen_exponential, 4000, (const float[QUANTILE_COUNT]){ -1.0f, -1.0f, 0.05f });
+
+	for (uint32_t count = 1; count <= QUANTILE_MARKERS; count++) {
+		printf("%u samples:\n", count);
+		run("uniform", gen_uniform, count, exact_few);
+	}
+
+	printf("%s\n", failures ? "FAILED" : "All bounds hold");
+	return failures ? 1 : 0;
+}